@@ -0,0 +1,221 @@
+/**
+ * @file       TinyGsmATRequest.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMATREQUEST_H_
+#define SRC_TINYGSMATREQUEST_H_
+
+#include "TinyGsmCommon.h"
+#include "TinyGsmCommandBuffer.h"
+#include "TinyGsmResponseBuffer.h"
+#include <atomic>
+
+// Size of the command (without "AT") and of the copy of the response kept in
+// a request.
+#ifndef TINY_GSM_AT_REQUEST_COMMAND_SIZE
+#define TINY_GSM_AT_REQUEST_COMMAND_SIZE 128
+#endif
+
+#ifndef TINY_GSM_AT_REQUEST_RESPONSE_SIZE
+#define TINY_GSM_AT_REQUEST_RESPONSE_SIZE 64
+#endif
+
+template <class modemType>
+class TinyGsmModem;
+
+/**
+ * @brief State of an asynchronous AT command.
+ */
+enum TinyGsmATState {
+  TINY_GSM_AT_IDLE    = 0,  /// Not submitted yet
+  TINY_GSM_AT_QUEUED  = 1,  /// Waiting for the modem to become free
+  TINY_GSM_AT_RUNNING = 2,  /// Sent, waiting for the response
+  TINY_GSM_AT_DONE    = 3,  /// Finished, see result()
+};
+
+/**
+ * @brief An AT command run without blocking, see TinyGsmModem::submitAT().
+ *
+ * The request is owned by the application and must stay alive until it is
+ * done; no heap memory is used.  The request is also the handle to poll:
+ * done(), result() and response() tell how it went.  Optionally a callback
+ * is called when it is done.
+ *
+ * @code
+ * TinyGsmATRequest attach;
+ * attach.command(GF("+CGATT=1")).timeout(60000L).onDone(attached, nullptr);
+ * modem.submitAT(attach);
+ * ...
+ * modem.pollAT();  // in the loop of the application task
+ * @endcode
+ */
+class TinyGsmATRequest {
+  template <class modemType>
+  friend class TinyGsmModem;
+  friend class TinyGsmATQueue;
+
+ public:
+  /**
+   * @brief Called when the request is done, in the task polling the modem.
+   */
+  typedef void (*Callback)(TinyGsmATRequest& req, void* arg);
+
+  TinyGsmATRequest() {
+    memset(_r, 0, sizeof(_r));
+  }
+
+  /**
+   * @brief Set the command, formatted like sendAT() (without "AT").
+   */
+  template <typename... Args>
+  TinyGsmATRequest& command(Args... parts) {
+    _cmd.truncate(0);
+    (_cmd.add(parts), ...);
+    _cmd.add('\0');
+    return *this;
+  }
+
+  /**
+   * @brief Set the expected responses; the default is OK and ERROR.
+   */
+  TinyGsmATRequest& expect(GsmConstStr r1, GsmConstStr r2 = nullptr,
+                           GsmConstStr r3 = nullptr, GsmConstStr r4 = nullptr,
+                           GsmConstStr r5 = nullptr, GsmConstStr r6 = nullptr,
+                           GsmConstStr r7 = nullptr) {
+    _r[0] = r1;
+    _r[1] = r2;
+    _r[2] = r3;
+    _r[3] = r4;
+    _r[4] = r5;
+    _r[5] = r6;
+    _r[6] = r7;
+    return *this;
+  }
+
+  /**
+   * @brief Set the deadline, counted from submitAT(); the default is 1s.
+   */
+  TinyGsmATRequest& timeout(uint32_t timeout_ms) {
+    _timeout_ms = timeout_ms;
+    return *this;
+  }
+
+  TinyGsmATRequest& onDone(Callback cb, void* arg = nullptr) {
+    _cb    = cb;
+    _cbArg = arg;
+    return *this;
+  }
+
+  TinyGsmATState state() const {
+    return _state;
+  }
+
+  bool done() const {
+    return _state == TINY_GSM_AT_DONE;
+  }
+
+  /**
+   * @brief The index of the matched response (1 = the first expected one),
+   * or 0 if the deadline passed.
+   */
+  int8_t result() const {
+    return _result;
+  }
+
+  /**
+   * @brief The received response, as far as it fits.
+   */
+  const char* response() const {
+    return _response.c_str();
+  }
+
+  /**
+   * @brief The command without "AT".
+   */
+  const char* commandText() const {
+    return _cmd.data();
+  }
+
+  /**
+   * @brief Check if the command fitted into the request.
+   */
+  bool valid() const {
+    return _cmd.length() > 0 && !_cmd.overflow();
+  }
+
+ private:
+  bool expired(uint32_t now) const {
+    return now - _submitted >= _timeout_ms;
+  }
+
+  uint32_t remaining(uint32_t now) const {
+    return expired(now) ? 0 : _timeout_ms - (now - _submitted);
+  }
+
+  TinyGsmCommandBuffer<TINY_GSM_AT_REQUEST_COMMAND_SIZE> _cmd;
+  TinyGsmResponseBuffer<TINY_GSM_AT_REQUEST_RESPONSE_SIZE,
+                        TINY_GSM_OVERFLOW_KEEP_TAIL>
+                              _response;
+  GsmConstStr                 _r[7];                     /// Expected responses
+  uint32_t                    _timeout_ms = 1000L;       /// Deadline
+  uint32_t                    _submitted  = 0;           /// millis() of submit
+  Callback                    _cb         = nullptr;     /// Called when done
+  void*                       _cbArg      = nullptr;     /// Argument of _cb
+  std::atomic<TinyGsmATState> _state{TINY_GSM_AT_IDLE};  /// Progress
+  int8_t                      _result     = 0;           /// Matched response
+  TinyGsmATRequest*           _next       = nullptr;     /// Queue link
+};
+
+/**
+ * @brief First-in first-out list of requests, linked through the requests.
+ * Submitting and polling may happen in different tasks.
+ */
+class TinyGsmATQueue {
+ public:
+  void push(TinyGsmATRequest* req) {
+    lock();
+    req->_next = nullptr;
+    if (_tail) {
+      _tail->_next = req;
+    } else {
+      _head = req;
+    }
+    _tail = req;
+    unlock();
+  }
+
+  TinyGsmATRequest* pop() {
+    lock();
+    TinyGsmATRequest* req = _head;
+    if (req) {
+      _head = req->_next;
+      if (!_head) { _tail = nullptr; }
+      req->_next = nullptr;
+    }
+    unlock();
+    return req;
+  }
+
+  bool empty() const {
+    return _head == nullptr;
+  }
+
+ private:
+  void lock() {
+    while (_lock.test_and_set(std::memory_order_acquire)) { TINY_GSM_YIELD(); }
+  }
+
+  void unlock() {
+    _lock.clear(std::memory_order_release);
+  }
+
+  TinyGsmATRequest* volatile _head = nullptr;           /// Next to run
+  TinyGsmATRequest*          _tail = nullptr;           /// Last submitted
+  std::atomic_flag           _lock = ATOMIC_FLAG_INIT;  /// Guards the list
+};
+
+#endif  // SRC_TINYGSMATREQUEST_H_
@@ -10,6 +10,7 @@
 #define SRC_TINYGSMBATTERY_H_
 
 #include "TinyGsmCommon.h"
+#include "TinyGsmStatusCache.h"
 
 #define TINY_GSM_MODEM_HAS_BATTERY
 
@@ -23,6 +24,10 @@ class TinyGsmBattery {
  public:
   /*
    * Battery functions
+   *
+   * All of them are answered by one +CBC query, shared by the callers
+   * asking at the same time and cached for TINY_GSM_CACHE_CBC_MS (see
+   * getBattStats()).
    */
 
   /**
@@ -35,7 +40,11 @@ class TinyGsmBattery {
    * @return *int16_t*  The battery voltage measured by the modem module.
    */
   int16_t getBattVoltage() {
-    return thisModem().getBattVoltageImpl();
+    int8_t  chargeState = 0;
+    int8_t  percent     = 0;
+    int16_t milliVolts  = 0;
+    getBattStats(chargeState, percent, milliVolts);
+    return milliVolts;
   }
 
   /**
@@ -48,7 +57,11 @@ class TinyGsmBattery {
    * @return *int8_t*  The current battery percent.
    */
   int8_t getBattPercent() {
-    return thisModem().getBattPercentImpl();
+    int8_t  chargeState = 0;
+    int8_t  percent     = 0;
+    int16_t milliVolts  = 0;
+    getBattStats(chargeState, percent, milliVolts);
+    return percent;
   }
 
   /**
@@ -57,7 +70,11 @@ class TinyGsmBattery {
    * @return *int8_t* The battery charge state.
    */
   int8_t getBattChargeState() {
-    return thisModem().getBattChargeStateImpl();
+    int8_t  chargeState = 0;
+    int8_t  percent     = 0;
+    int16_t milliVolts  = 0;
+    getBattStats(chargeState, percent, milliVolts);
+    return chargeState;
   }
 
   /**
@@ -66,12 +83,31 @@ class TinyGsmBattery {
    * @param chargeState A reference to an int to set to the battery charge state
    * @param percent A reference to an int to set to the battery percent
    * @param milliVolts A reference to an int to set to the battery voltage
+   * @param maxAge_ms The maximum age of cached stats to accept; callers
+   * asking while the modem is asked get the same answer.
    * @return *true* The battery stats were updated by the module.
    * @return *false* There was a failure in updating the battery stats from the
    * module.
    */
-  bool getBattStats(int8_t& chargeState, int8_t& percent, int16_t& milliVolts) {
-    return thisModem().getBattStatsImpl(chargeState, percent, milliVolts);
+  bool getBattStats(int8_t& chargeState, int8_t& percent, int16_t& milliVolts,
+                    uint32_t maxAge_ms = TINY_GSM_CACHE_CBC_MS) {
+    BattStats b;
+    if (battCache.begin(b, maxAge_ms) == TINY_GSM_CACHE_QUERY) {
+
+      MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
+
+      b.ok = thisModem().getBattStatsImpl(b.chargeState, b.percent, b.milliVolts);
+
+      MS_TINY_GSM_SEM_GIVE_WAIT
+
+      battCache.end(b.ok, b);
+    }
+    if (b.ok) {
+      chargeState = b.chargeState;
+      percent     = b.percent;
+      milliVolts  = b.milliVolts;
+    }
+    return b.ok;
   }
 
   /*
@@ -84,6 +120,10 @@ class TinyGsmBattery {
   inline modemType& thisModem() {
     return static_cast<modemType&>(*this);
   }
+  // The lock of the modem, for the MS_TINY_GSM_SEM_* macros
+  inline TinyGsmScheduler& lockScheduler() {
+    return thisModem().lockScheduler();
+  }
   ~TinyGsmBattery() {}
 
   /* =========================================== */
@@ -96,51 +136,26 @@ class TinyGsmBattery {
    * Battery functions
    */
  protected:
-  // Use: float vBatt = modem.getBattVoltage() / 1000.0;
-  int16_t getBattVoltageImpl() {
-    thisModem().sendAT(GF("+CBC"));
-    if (thisModem().waitResponse(GF("+CBC:")) != 1) { return 0; }
-    thisModem().streamSkipUntil(',');  // Skip battery charge status
-    thisModem().streamSkipUntil(',');  // Skip battery charge level
-    // return voltage in mV
-    uint16_t res = thisModem().streamGetIntBefore('\n');
-    // Wait for final OK
-    thisModem().waitResponse();
-    return res;
-  }
-
-  int8_t getBattPercentImpl() {
-    thisModem().sendAT(GF("+CBC"));
-    if (thisModem().waitResponse(GF("+CBC:")) != 1) { return false; }
-    thisModem().streamSkipUntil(',');  // Skip battery charge status
-    // Read battery charge level
-    int8_t res = thisModem().streamGetIntBefore(',');
-    // Wait for final OK
-    thisModem().waitResponse();
-    return res;
-  }
-
-  int8_t getBattChargeStateImpl() {
-    thisModem().sendAT(GF("+CBC"));
-    if (thisModem().waitResponse(GF("+CBC:")) != 1) { return false; }
-    // Read battery charge status
-    int8_t res = thisModem().streamGetIntBefore(',');
-    // Wait for final OK
-    thisModem().waitResponse();
-    return res;
-  }
-
   bool getBattStatsImpl(int8_t& chargeState, int8_t& percent,
                         int16_t& milliVolts) {
     thisModem().sendAT(GF("+CBC"));
     if (thisModem().waitResponse(GF("+CBC:")) != 1) { return false; }
-    chargeState = thisModem().streamGetIntBefore(',');
-    percent     = thisModem().streamGetIntBefore(',');
-    milliVolts  = thisModem().streamGetIntBefore('\n');
+    chargeState = thisModem().streamGetIntegerBefore(',');
+    percent     = thisModem().streamGetIntegerBefore(',');
+    milliVolts  = thisModem().streamGetIntegerBefore('\n');
     // Wait for final OK
     thisModem().waitResponse();
     return true;
   }
+
+  // Result of getBattStatsImpl(), see battCache
+  struct BattStats {
+    bool    ok          = false;
+    int8_t  chargeState = 0;
+    int8_t  percent     = 0;
+    int16_t milliVolts  = 0;
+  };
+  TinyGsmStatusCache<BattStats> battCache;  /// See getBattStats()
 };
 
 #endif  // SRC_TINYGSMBATTERY_H_
@@ -0,0 +1,100 @@
+/**
+ * @file       TinyGsmBringUp.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMBRINGUP_H_
+#define SRC_TINYGSMBRINGUP_H_
+
+#include "TinyGsmCommon.h"
+
+/**
+ * @brief Steps of bringing the modem up (init, restart), in their order.
+ */
+enum TinyGsmBringUpState : uint8_t {
+  TINY_GSM_BRINGUP_IDLE     = 0,  /// Not started
+  TINY_GSM_BRINGUP_PROBE    = 1,  /// AT until the modem answers, echo off
+  TINY_GSM_BRINGUP_CFUN_OFF = 2,  /// Restart: minimum functionality
+  TINY_GSM_BRINGUP_CFUN_ON  = 3,  /// Restart: full functionality
+  TINY_GSM_BRINGUP_REBOOT   = 4,  /// Restart: reboot the module
+  TINY_GSM_BRINGUP_BOOTING  = 5,  /// Restart: AT until it answers again
+  TINY_GSM_BRINGUP_CONFIG   = 6,  /// Error codes, time stamps, battery checks
+  TINY_GSM_BRINGUP_SIM      = 7,  /// SIM ready, unlocked with the pin
+  TINY_GSM_BRINGUP_READY    = 8,  /// Done
+  TINY_GSM_BRINGUP_FAILED   = 9,  /// Given up, see the log
+};
+
+#define TINY_GSM_BRINGUP_STATES 10
+
+/**
+ * @brief Keeps the time of the steps of a bring-up, to tell its progress and
+ * the estimated time until the modem is ready.
+ *
+ * The estimate of a step starts with a typical duration and follows the
+ * durations observed (moving average), so it fits the module after the
+ * first bring-up.
+ */
+class TinyGsmBringUpClock {
+ public:
+  /**
+   * @brief A bring-up of the steps in plan (bit n: state n) starts.
+   */
+  void begin(uint16_t plan, uint32_t now) {
+    _plan    = plan;
+    _start   = now;
+    _entered = now;
+    _state   = TINY_GSM_BRINGUP_IDLE;
+  }
+
+  /**
+   * @brief The bring-up went on to state; the step before took its time.
+   */
+  void enter(TinyGsmBringUpState state, uint32_t now) {
+    if (_state != TINY_GSM_BRINGUP_IDLE && state != TINY_GSM_BRINGUP_FAILED) {
+      _typical[_state] = (3 * _typical[_state] + (now - _entered)) / 4;
+    }
+    _state   = state;
+    _entered = now;
+  }
+
+  /**
+   * @brief The estimated time until ready; 0 when done.
+   */
+  uint32_t eta(uint32_t now) const {
+    if (_state >= TINY_GSM_BRINGUP_READY) { return 0; }
+    uint32_t spent = now - _entered;
+    uint32_t eta   = _typical[_state] > spent ? _typical[_state] - spent : 0;
+    for (uint8_t s = _state + 1; s < TINY_GSM_BRINGUP_READY; s++) {
+      if (_plan & (1U << s)) { eta += _typical[s]; }
+    }
+    return eta;
+  }
+
+  /**
+   * @brief The progress in percent.
+   */
+  uint8_t progress(uint32_t now) const {
+    if (_state == TINY_GSM_BRINGUP_IDLE) { return 0; }
+    if (_state >= TINY_GSM_BRINGUP_READY) { return 100; }
+    uint32_t elapsed = now - _start;
+    uint32_t total   = elapsed + eta(now);
+    // Not 100 before it is done
+    if (total == 0) { return 0; }
+    uint32_t pct = static_cast<uint32_t>(100ULL * elapsed / total);
+    return static_cast<uint8_t>(TinyGsmMin(pct, static_cast<uint32_t>(99)));
+  }
+
+ private:
+  // Typical durations (ms), the estimate until observed
+  uint32_t _typical[TINY_GSM_BRINGUP_STATES] = {0,     500,  1500, 3000, 500,
+                                                10000, 500,  1000, 0,    0};
+  uint16_t _plan    = 0;                      /// Steps of this bring-up
+  uint32_t _start   = 0;                      /// millis() of begin()
+  uint32_t _entered = 0;                      /// millis() the step started
+  TinyGsmBringUpState _state = TINY_GSM_BRINGUP_IDLE;  /// The running step
+};
+
+#endif  // SRC_TINYGSMBRINGUP_H_
@@ -0,0 +1,95 @@
+/**
+ * @file       TinyGsmBudget.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMBUDGET_H_
+#define SRC_TINYGSMBUDGET_H_
+
+#include "TinyGsmCommon.h"
+
+/**
+ * @brief How much work one call may do: time (us) and received bytes, e.g.
+ * one maintain() per tick of a control loop.  A default constructed budget
+ * is never spent.
+ *
+ * @code
+ * TinyGsmBudget budget(2000);         // 2 ms
+ * while (!budget.exhausted() && ...) { ...; budget.spend(n); }
+ * waitResponse(budget.cap(15));       // not beyond the budget
+ * @endcode
+ */
+class TinyGsmBudget {
+ public:
+  TinyGsmBudget() {}
+
+  /**
+   * @brief A budget of time_us from now, and of bytes received bytes.
+   */
+  explicit TinyGsmBudget(uint32_t time_us, size_t bytes = SIZE_MAX)
+      : _start(micros()), _time_us(time_us), _bytes(bytes), _set(true) {}
+
+  /**
+   * @brief Check if the budget is set at all.
+   */
+  bool set() const {
+    return _set;
+  }
+
+  /**
+   * @brief Check if the time or the bytes are spent.
+   *
+   * @param pending Bytes used but not spend() yet.
+   */
+  bool exhausted(size_t pending = 0) const {
+    return _set && (pending >= _bytes || remaining_us() == 0);
+  }
+
+  /**
+   * @brief The time left (us); UINT32_MAX if not set.
+   */
+  uint32_t remaining_us() const {
+    if (!_set) { return UINT32_MAX; }
+    uint32_t elapsed = static_cast<uint32_t>(micros()) - _start;
+    return elapsed >= _time_us ? 0 : _time_us - elapsed;
+  }
+
+  /**
+   * @brief The time left (ms); UINT32_MAX if not set.
+   */
+  uint32_t remaining_ms() const {
+    return _set ? remaining_us() / 1000 : UINT32_MAX;
+  }
+
+  /**
+   * @brief The bytes left; SIZE_MAX if not set.
+   */
+  size_t bytes() const {
+    return _set ? _bytes : SIZE_MAX;
+  }
+
+  /**
+   * @brief n bytes were handled.
+   */
+  void spend(size_t n) {
+    if (_bytes != SIZE_MAX) { _bytes = n >= _bytes ? 0 : _bytes - n; }
+  }
+
+  /**
+   * @brief timeout_ms, but not beyond the time left.
+   */
+  uint32_t cap(uint32_t timeout_ms) const {
+    return TinyGsmMin(timeout_ms, remaining_ms());
+  }
+
+ private:
+  uint32_t _start   = 0;         /// micros() when set
+  uint32_t _time_us = 0;         /// us from _start
+  size_t   _bytes   = SIZE_MAX;  /// Received bytes left
+  bool     _set     = false;     /// false: never spent
+};
+
+#endif  // SRC_TINYGSMBUDGET_H_
@@ -0,0 +1,153 @@
+/**
+ * @file       TinyGsmBufferedStream.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMBUFFEREDSTREAM_H_
+#define SRC_TINYGSMBUFFEREDSTREAM_H_
+
+#include "TinyGsmCommon.h"
+#include <atomic>
+
+/**
+ * @brief Stream wrapper reading the modem UART in chunks.
+ *
+ * Whatever the underlying stream has available is read with one readBytes()
+ * into a chunk buffer.  Scanners (waitResponse, streamSkipUntil, payload
+ * reads) work on that chunk in memory with fill(), buffer() and consume();
+ * the bytes they do not consume stay in the chunk and are returned first by
+ * all the usual Stream functions, so nothing read ahead gets lost.
+ *
+ * Writing is passed through unchanged.
+ *
+ * Only the owner of the modem reads; available() may also be asked by
+ * another task (e.g. the rx pump deciding whether to take the modem), as a
+ * hint.
+ *
+ * @tparam N The size of the chunk buffer.
+ */
+template <unsigned N>
+class TinyGsmBufferedStream : public Stream {
+ public:
+  explicit TinyGsmBufferedStream(Stream& s) : _s(s), _pos(0), _len(0) {
+    setTimeout(s.getTimeout());
+  }
+
+  /*
+   * Stream
+   */
+  int available() override {
+    return static_cast<int>(_unread.load(std::memory_order_relaxed)) +
+        _s.available();
+  }
+
+  int read() override {
+    if (_pos == _len && !fill()) { return -1; }
+    _read++;
+    int c = static_cast<uint8_t>(_b[_pos++]);
+    publish();
+    return c;
+  }
+
+  int peek() override {
+    if (_pos == _len && !fill()) { return -1; }
+    return static_cast<uint8_t>(_b[_pos]);
+  }
+
+  using Stream::readBytes;
+  size_t readBytes(char* buf, size_t length) override {
+    size_t n = TinyGsmMin(length, buffered());
+    memcpy(buf, &_b[_pos], n);
+    _pos += n;
+    publish();
+    if (n < length) { n += _s.readBytes(buf + n, length - n); }
+    _read += n;
+    return n;
+  }
+
+  size_t write(uint8_t c) override {
+    return _s.write(c);
+  }
+
+  size_t write(const uint8_t* buf, size_t size) override {
+    return _s.write(buf, size);
+  }
+
+  void flush() override {
+    _s.flush();
+  }
+
+  /*
+   * Chunk access
+   */
+
+  /**
+   * @brief Make sure there is something in the chunk buffer, reading
+   * whatever the underlying stream has available if it is empty.
+   * Does not wait.
+   *
+   * @return *size_t* The number of unread bytes in the chunk buffer.
+   */
+  size_t fill() {
+    if (_pos < _len) { return _len - _pos; }
+    _pos = 0;
+    _len = 0;
+    int a = _s.available();
+    if (a > 0) {
+      _len = _s.readBytes(_b, TinyGsmMin(static_cast<size_t>(a),
+                                         static_cast<size_t>(N)));
+    }
+    publish();
+    return _len;
+  }
+
+  /**
+   * @brief The first unread byte in the chunk buffer; buffered() bytes are
+   * valid.
+   */
+  const char* buffer() const {
+    return &_b[_pos];
+  }
+
+  size_t buffered() const {
+    return _len - _pos;
+  }
+
+  /**
+   * @brief Mark bytes of the chunk buffer as read.
+   *
+   * @param n The number of bytes, at most buffered().
+   */
+  void consume(size_t n) {
+    n = TinyGsmMin(n, buffered());
+    _pos += n;
+    _read += n;
+    publish();
+  }
+
+  /**
+   * @brief The number of bytes read so far (wraps around), e.g. to tell how
+   * much a URC handler read.
+   */
+  uint32_t consumed() const {
+    return _read;
+  }
+
+ private:
+  // The unread bytes of the chunk, for available() in another task
+  void publish() {
+    _unread.store(_len - _pos, std::memory_order_relaxed);
+  }
+
+  Stream&             _s;         /// The underlying stream (modem UART)
+  char                _b[N];      /// The chunk buffer
+  size_t              _pos;       /// Next unread byte in the chunk buffer
+  size_t              _len;       /// Number of valid bytes in the chunk buffer
+  std::atomic<size_t> _unread{0}; /// _len - _pos, see available()
+  uint32_t            _read = 0;  /// Bytes read, see consumed()
+};
+
+#endif  // SRC_TINYGSMBUFFEREDSTREAM_H_
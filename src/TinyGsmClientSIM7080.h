@@ -19,6 +19,8 @@
 
 #define TINY_GSM_MUX_COUNT 12
 #define TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
+// Several commands can be sent in one line, separated by ';'.
+#define TINY_GSM_AT_CHAINING
 
 #include "TinyGsmClientSIM70xx.h"
 #include "TinyGsmTCP.tpp"
@@ -28,6 +30,8 @@
 #include "TinyGsmTime.tpp"
 #include "TinyGsmNTP.tpp"
 #include "TinyGsmBattery.tpp"
+#include "TinyGsmBringUp.h"
+#include <atomic>
 
 
 // Logging
@@ -38,6 +42,14 @@
 #include "ESP32Logger.h"
 
 
+// State of GsmClientSim7080::connectAsync().
+enum TinyGsmConnectState : uint8_t {
+  TINY_GSM_CONNECT_IDLE    = 0,  /// No asynchronous connect started
+  TINY_GSM_CONNECT_PENDING = 1,  /// Waiting for +CAOPEN: <cid>,<result>
+  TINY_GSM_CONNECT_DONE    = 2,  /// Connected
+  TINY_GSM_CONNECT_FAILED  = 3,  /// Refused, failed or timed out
+};
+
 
 class TinyGsmSim7080 : public TinyGsmSim70xx<TinyGsmSim7080>,
                        public TinyGsmTCP<TinyGsmSim7080, TINY_GSM_MUX_COUNT>,
@@ -59,6 +71,10 @@ class TinyGsmSim7080 : public TinyGsmSim70xx<TinyGsmSim7080>,
   friend class TinyGsmNTP<TinyGsmSim7080>;
   friend class TinyGsmBattery<TinyGsmSim7080>;
 
+ public:
+  // The mixins have one each, all giving the one of TinyGsmModem.
+  using TinyGsmSim70xx<TinyGsmSim7080>::lockScheduler;
+
   /*
    * Inner Client
    */
@@ -89,7 +105,6 @@ class TinyGsmSim7080 : public TinyGsmSim70xx<TinyGsmSim7080>,
       DBGLOG(Info, "%s>> _mux: %hhu", TAG, _mux)
       this->at       = _modem;
       sock_available = 0;
-      prev_check     = 0;
       sock_connected = false;
       got_data       = false;
 
@@ -118,11 +133,110 @@ class TinyGsmSim7080 : public TinyGsmSim70xx<TinyGsmSim7080>,
       stop();
       TINY_GSM_YIELD();
       rx.clear();
-      sock_connected = at->modemConnect(host, port, mux, false, timeout_s);
+      connect_status = at->modemConnect(host, port, mux, false, timeout_s);
+      sock_connected = connect_status;
       DBGLOG(Info, "%s<< (mux: %hhu) return sock_connected: %s", TAG, mux, DBGB2S(sock_connected))
       return sock_connected;
     } // int GsmClientSim7080::connect(...)
     TINY_GSM_CLIENT_CONNECT_OVERRIDES
+
+    /**
+     * @brief Why the last connect() failed: timeout, ERROR with the <result>
+     * of +CAOPEN, or the error code of the modem.
+     */
+    TinyGsmResult connectStatus() const {
+      return connect_status;
+    }
+
+    /**
+     * @brief Called when an asynchronous connect ended.
+     *
+     * Runs in the task holding the modem (see handleCAOPEN()), so it must be
+     * short and must not call the modem.
+     *
+     * @param result The <result> of +CAOPEN (0: connected), -1 if it did not
+     * come within the time.
+     */
+    typedef void (*ConnectCallback)(GsmClientSim7080& client, int8_t result,
+                                    void* arg);
+
+    /**
+     * @brief Start to connect and return as soon as the modem took the
+     * command, so several sockets can be opened at the same time.
+     *
+     * The connect is completed by the URC +CAOPEN: <cid>,<result>: cb is
+     * called, and connectState() / connectResult() tell the outcome.  Without
+     * a result within timeout_s, maintain() fails the connect and closes the
+     * socket.
+     *
+     * @code
+     * for (auto& c : clients) { c.connectAsync(host, port); }
+     * while (...) { modem.maintain(); ... c.connectState() ... }
+     * @endcode
+     *
+     * @return *true* The connect is pending (or already done).
+     * @return *false* The modem did not take it; connectState() is FAILED.
+     */
+    bool connectAsync(const char* host, uint16_t port, int timeout_s = 75,
+                      ConnectCallback cb = nullptr, void* arg = nullptr) {
+      return startConnect(host, port, false, timeout_s, cb, arg);
+    }
+
+    TinyGsmConnectState connectState() const {
+      return connect_state;
+    }
+
+    // The <result> of +CAOPEN of the last asynchronous connect, -1 if none.
+    int8_t connectResult() const {
+      return connect_result;
+    }
+
+   protected:
+    bool startConnect(const char* host, uint16_t port, bool ssl, int timeout_s,
+                      ConnectCallback cb, void* arg) {
+      DBGLOG(Info, "%s>> (mux: %hhu)", TAG, mux)
+      // The close of an expired connect must not hit the new one
+      if (close_req.state() == TINY_GSM_AT_QUEUED ||
+          close_req.state() == TINY_GSM_AT_RUNNING) {
+        at->waitAT(close_req);
+      }
+      stop();
+      TINY_GSM_YIELD();
+      rx.clear();
+      connect_state      = TINY_GSM_CONNECT_PENDING;
+      connect_result     = -1;
+      connect_cb         = cb;
+      connect_cb_arg     = arg;
+      connect_start      = millis();
+      connect_timeout_ms = ((uint32_t)timeout_s) * 1000;
+      bool r = at->modemConnectAsync(host, port, mux, ssl, timeout_s);
+      if (!r && connect_state == TINY_GSM_CONNECT_PENDING) {
+        connect_state = TINY_GSM_CONNECT_FAILED;
+      }
+      DBGLOG(Info, "%s<< (mux: %hhu) return: %s", TAG, mux, DBGB2S(r))
+      return r;
+    } // bool GsmClientSim7080::startConnect(...)
+
+    // The asynchronous connect ended, see handleCAOPEN() and expireConnects().
+    void finishConnect(int8_t result) {
+      connect_result = result;
+      connect_state  = result == 0 ? TINY_GSM_CONNECT_DONE : TINY_GSM_CONNECT_FAILED;
+      sock_connected = result == 0;
+      DBGLOG(Info, "%s(mux: %hhu) connect ended, result: %hhi", TAG, mux, result)
+      if (connect_cb) { connect_cb(*this, result, connect_cb_arg); }
+    }
+
+    TinyGsmResult                    connect_status;  /// See connectStatus()
+    // Read by connectState() without the modem locked
+    std::atomic<TinyGsmConnectState> connect_state{TINY_GSM_CONNECT_IDLE};
+    int8_t                           connect_result     = -1;
+    ConnectCallback                  connect_cb         = nullptr;
+    void*                            connect_cb_arg     = nullptr;
+    uint32_t                         connect_start      = 0;  /// millis() of connectAsync()
+    uint32_t                         connect_timeout_ms = 0;
+    TinyGsmATRequest                 close_req;  /// +CACLOSE of an expired connect, see expireConnects()
+
+   public:
 /*
     // Added due to new C++-compiler-standard with ESP-IDF 5.3.1.
     int connect(IPAddress ip, uint16_t port, int32_t timeout) override {
@@ -141,6 +255,7 @@ class TinyGsmSim7080 : public TinyGsmSim70xx<TinyGsmSim7080>,
 
       at->sendAT(GF("+CACLOSE="), mux);
       sock_connected = false;
+      connect_state  = TINY_GSM_CONNECT_IDLE;
       at->waitResponse(3000);
 
       MS_TINY_GSM_SEM_GIVE_WAIT
@@ -193,16 +308,23 @@ class TinyGsmSim7080 : public TinyGsmSim70xx<TinyGsmSim7080>,
       stop();
       TINY_GSM_YIELD();
       rx.clear();
-      sock_connected = at->modemConnect(host, port, mux, true, timeout_s);
+      connect_status = at->modemConnect(host, port, mux, true, timeout_s);
+      sock_connected = connect_status;
       DBGLOG(Info, "[GsmClientSecureSIM7080] << return sock_connected: %s", DBGB2S(sock_connected))
       return sock_connected;
     } // GsmClientSecureSIM7080::connect(...)
     TINY_GSM_CLIENT_CONNECT_OVERRIDES
+
+    // See GsmClientSim7080::connectAsync().
+    bool connectAsync(const char* host, uint16_t port, int timeout_s = 75,
+                      ConnectCallback cb = nullptr, void* arg = nullptr) {
+      return startConnect(host, port, true, timeout_s, cb, arg);
+    }
   }; // GsmClientSecureSIM7080
 
  // <MS>
  public:
-  // Set by handleURCs(...) when receiving "DST" from the network.
+  // Set by handleDST() when receiving "DST" from the network.
   // -1: not set, 0: standard time, 1: daylight saving time
   // Sometimes not set by the network, therefore stored in preferences by MsGsm as default for next time re-start.
   // At the moment not used (dst is detected by msSetTime() using the actual date)
@@ -216,13 +338,16 @@ class TinyGsmSim7080 : public TinyGsmSim70xx<TinyGsmSim7080>,
       : TinyGsmSim70xx<TinyGsmSim7080>(_stream) {
     DBGLOG(Info, "[TinyGsmSim7080] >>");
     memset(sockets, 0, sizeof(sockets));
-    msTinyGsmSemProcess = xSemaphoreCreateMutex();
-    DBGCHK(Error, msTinyGsmSemProcess != NULL, "[TinyGsmSim7080] CRITICAL ERROR msTinyGsmSemProcess can not be created!");
+    memset(openResult, -1, sizeof(openResult));
     DBGLOG(Info, "[TinyGsmSim7080] <<");
   } // TinyGsmSim7080::TinyGsmSim7080(...)
 
   ~TinyGsmSim7080() {
     DBGLOG(Info, "[TinyGsmSim7080] >>");
+#if defined TINY_GSM_RX_PUMP
+    // The pump task uses the sockets and the lock.
+    stopRxPump();
+#endif
     for (uint8_t mux = 0; mux < TINY_GSM_MUX_COUNT; mux++) {
       GsmClientSim7080* sock = sockets[mux];
       if (sock) {
@@ -230,10 +355,6 @@ class TinyGsmSim7080 : public TinyGsmSim70xx<TinyGsmSim7080>,
         sockets[mux] = NULL;
       }
     }
-    if (msTinyGsmSemProcess) {
-      vSemaphoreDelete(msTinyGsmSemProcess);
-      msTinyGsmSemProcess = NULL;
-    }
     DBGLOG(Info, "[TinyGsmSim7080] <<");
   } // TinyGsmSim7080::~TinyGsmSim7080()
 
@@ -241,204 +362,336 @@ class TinyGsmSim7080 : public TinyGsmSim70xx<TinyGsmSim7080>,
    * Basic functions
    */
  protected:
-  bool initRunning = false;
   bool initImpl(const char* pin = nullptr) {
-    SimStatus ret;
     bool r = false;
-    bool gotATOK = false;
     DBGLOG(Info, "[TinyGsmSim7080] >> pin: '%s'", pin == NULL ? "-" : pin);
     DBGLOG(Info, "[TinyGsmSim7080] Version: %s", TINYGSM_VERSION);
     DBGLOG(Info, "[TinyGsmSim7080] Compiled Module: TinyGsmClientSIM7080");
 
-    if (initRunning) {
+    if (!startBringUp(pin, false, false)) {
       DBGLOG(Warn, "[TinyGsmSim7080] Initialization already running!")
-      goto endxx;
-    }
-
-    MS_TINY_GSM_SEM_TAKE_WAIT
-
-    initRunning = true;
-
-/* <MS> old 0.11.5
-    if (!testAT()) { 
-      DBGLOG(Error, "[TinyGsmSim7080] testAT() failed! Stop.")
-      r = false; 
-      goto end; 
-    }
-
-    sendAT(GF("E0"));  // Echo Off
-    if (waitResponse() != 1) { 
-      DBGLOG(Error, "[TinyGsmSim7080] Echo-off failed! Stop.")
-      r = false; 
-      goto end; 
-    }
-*/
-
-    for (uint32_t start = millis(); millis() - start < 10000L;) {
-      sendAT(GF(""));
-      int8_t resp = waitResponse(200L, GFP(GSM_OK), GFP(GSM_ERROR), GF("AT"));
-      if (resp == 1) {
-        gotATOK = true;
-        break;
-      } else if (resp == 3) {
-        waitResponse(200L);  // get the OK
-        sendAT(GF("E0"));    // Echo Off
-        DBGLOG(Info, "[TinyGsmSim7080] Turning off echo!")
-        waitResponse(2000L);
-      }
-      delay(100);
-    }
-    if (!gotATOK) { goto end; }
-
-#ifdef TINY_GSM_DEBUG
-    sendAT(GF("+CMEE=2"));  // turn on verbose error codes
-#else
-    sendAT(GF("+CMEE=0"));  // turn off error codes
-#endif
-    waitResponse();
-
-    // Enable Local Time Stamp for getting network time
-    sendAT(GF("+CLTS=1"));
-    if (waitResponse(10000L) != 1) { 
-      DBGLOG(Error, "[TinyGsmSim7080] Enable-local-timestamp failed! Stop.")
-      goto end; 
-    }
-
-    // Enable battery checks
-// <MS>
-// IMPORTANT: 
-// +CBATCHK=1 has to be set! Or not?
-//    sendAT(GF("+CBATCHK=0"));
-    sendAT(GF("+CBATCHK=1"));
-    // Disable battery checks
-    if (waitResponse() != 1) { 
-      DBGLOG(Error, "[TinyGsmSim7080] Disable-bat-checks failed! Stop.")
-      goto end; 
-    }
-
-
-    MS_TINY_GSM_SEM_GIVE_WAIT
-
-    ret = getSimStatus();
-    // if the sim isn't ready and a pin has been provided, try to unlock the sim
-    if (ret != SIM_READY && pin != nullptr && strlen(pin) > 0) {
-      simUnlock(pin);
-      r = (getSimStatus() == SIM_READY);
-    } else {
-      // if the sim is ready, or it's locked but no pin has been provided,
-      // return true
-      r = ((ret == SIM_READY) || (ret == SIM_LOCKED));
+      goto end;
     }
-
-    goto endx;
+    r = runBringUp();
 
 end:
-    MS_TINY_GSM_SEM_GIVE_WAIT
-
-endx:
-    initRunning = false;
-
-endxx:
     DBGLOG(Info, "[TinyGsmSim7080] << return: %s", DBGB2S(r));
     return r;
   } // TinyGsmSim7080::initImpl(...)
 
   void maintainImpl() {
+    TinyGsmBudget unlimited;
+    maintainImpl(unlimited);
+  } // TinyGsmSim7080::maintainImpl()
+
+  // maintain(budget): the waits for the lock and for the modem end with the
+  // budget; the size check of the sockets is left for the next call if the
+  // budget cannot afford it.
+  bool maintainImpl(TinyGsmBudget& budget) {
     // Keep listening for modem URC's and proactively iterate through
     // sockets asking if any data is avaiable
+    bool pending = true;
     DBGLOG(Debug, "[TinyGsmSim7080::maintainImpl] >>");
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
-    // xSemaphoreTake(msTinyGsmSemProcess, portMAX_DELAY);
-
-    bool check_socks = false;
-    for (uint8_t mux = 0; mux < TINY_GSM_MUX_COUNT; mux++) {
-      GsmClientSim7080* sock = sockets[mux];
-      if (sock && sock->got_data) {
-        sock->got_data = false;
-        check_socks    = true;
+    // A bring-up started with beginInit() or beginRestart()
+    if (bringUpDriven && bringUpRunning()) { bringUpStep(); }
+    // The submitted commands are stepped (see pollAT()).  While one is in
+    // flight, taking the modem would wait for its response: its waitResponse
+    // handles the URCs meanwhile, the connects out of time are failed, and
+    // the sockets are polled once it is done.
+    this->pollAT();
+    if (atRunning != nullptr) {
+      if (this->lockScheduler().tryAcquire(TINY_GSM_LOCK_SITE, false)) {
+        expireConnects(budget);
+        MS_TINY_GSM_SEM_GIVE_WAIT
       }
+      goto end;
     }
+
+    if (!MS_TINY_GSM_SEM_TAKE_WITHIN(TINY_GSM_SCHED_DATA, TINY_GSM_SCHED_NO_MUX,
+                                     budget.remaining_ms())) {
+      DBGLOG(Debug, "[TinyGsmSim7080::maintainImpl] modem busy")
+      goto end;
+    }
+    DBGCOD(this->lockScheduler().blockedBy(__func__, __FILENAME__, __LINE__);)
+    // The budget only decides whether a command is sent: once sent, it is
+    // waited for with its own timeout, a late response would be taken for
+    // the response to the next command.
+
     // modemGetAvailable checks all socks, so we only want to do it once
-    // modemGetAvailable calls modemGetConnected(), which also checks allf
 
-    // Check all mux in use.
-    if (check_socks) { modemGetAvailable((uint8_t)-1); }
+    // Check all mux in use, if due (see TinyGsmTCP::pollDue()).
+    if (pollDue() && budget.remaining_ms() >= TINY_GSM_MAINTAIN_MIN_POLL_MS) {
+      pollSocketsImpl();
+    }
+
+    while (stream.available() && !budget.exhausted()) { handleURCs(15, budget); }
 
-    while (stream.available()) { waitResponse(15, nullptr, nullptr); }
+    expireConnects(budget);
+
+    pending = stream.available() > 0 || pollDue();
 
     MS_TINY_GSM_SEM_GIVE_WAIT
-    // xSemaphoreGive(msTinyGsmSemProcess); 
 
-    DBGLOG(Debug, "[TinyGsmSim7080::maintainImpl] <<");
-  } // TinyGsmSim7080::maintainImpl()
+  end:
+    DBGLOG(Debug, "[TinyGsmSim7080::maintainImpl] << pending: %s", DBGB2S(pending));
+    return pending;
+  } // TinyGsmSim7080::maintainImpl(...)
+
+  // One +CARECV? checks all sockets, see TinyGsmTCP::pollSocketsImpl().
+  void pollSocketsImpl() {
+    modemGetAvailable((uint8_t)-1);
+  }
 
   /*
    * Power functions
    */
  protected:
   bool restartImpl(const char* pin = nullptr) {
+    bool success = false;
     DBGLOG(Info, "[TinyGsmSim7080] >>");
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    if (!startBringUp(pin, true, false)) {
+      DBGLOG(Warn, "[TinyGsmSim7080] Initialization already running!")
+      goto end;
+    }
+    success = runBringUp();
 
-    bool success = true;
-    int8_t resp;
-    String s;
-
-    bool gotATOK = false;
-    for (uint32_t start = millis(); millis() - start < 10000L;) {
-      sendAT(GF(""));
-      resp = waitResponse(200L, s, GFP(GSM_OK), GFP(GSM_ERROR), GF("AT"));
-      DBGLOG(Info, "[TinyGsmSim7080] Empty AT returned: %hhi, %s", resp, s.c_str());
-      if (resp == 1) {
-        gotATOK = true;
-        break;
-      } else if (resp == 3) {
-        waitResponse(200L);  // get the OK
-        DBGLOG(Info, "[TinyGsmSim7080] Turning off echo!");
-        sendAT(GF("E0"));  // Echo Off
-        waitResponse(2000L);
-      }
-      delay(100);
+  end:
+    DBGLOG(Info, "[TinyGsmSim7080] << return: %s", DBGB2S(success));
+    return success;
+  } // TinyGsmSim7080::restartImpl(...)
+
+  /*
+   * Bring-up without blocking
+   */
+ public:
+  /**
+   * @brief Start init() without blocking the calling task: the steps are
+   * taken by bringUpStep(), which maintain() calls as well.  The AT commands
+   * are submitted like submitAT(), so the modem stays free for other tasks
+   * between them.
+   *
+   * @code
+   * modem.beginInit(pin);
+   * while (modem.bringUpRunning()) {
+   *   modem.maintain();
+   *   Serial.printf("%u%%, ready in %lums\n", modem.bringUpProgress(), modem.bringUpEta());
+   *   ...  // the rest of the loop
+   * }
+   * if (modem.bringUpState() == TINY_GSM_BRINGUP_READY) { ... }
+   * @endcode
+   *
+   * @return *false* A bring-up is running already.
+   */
+  bool beginInit(const char* pin = nullptr) {
+    return startBringUp(pin, false, true);
+  }
+
+  /**
+   * @brief Start restart() without blocking the calling task, see
+   * beginInit().
+   */
+  bool beginRestart(const char* pin = nullptr) {
+    return startBringUp(pin, true, true);
+  }
+
+  /**
+   * @brief Take the next steps of the bring-up as far as possible without
+   * waiting for the modem.  Call it from one task only.
+   *
+   * @return *TinyGsmBringUpState* The step it is in; TINY_GSM_BRINGUP_READY
+   * or TINY_GSM_BRINGUP_FAILED when done.
+   */
+  TinyGsmBringUpState bringUpStep() {
+    if (!bringUpRunning()) { return bringUp; }
+
+    pollAT();
+    if (bringUpWaiting) {
+      if (!bringUpReq.done()) { return bringUp; }
+      bringUpWaiting = false;
+      bringUpDone(bringUpReq.result());
+    } else if (static_cast<int32_t>(millis() - bringUpNext) >= 0) {
+      bringUpSubmit();
     }
-    DBGCHK(Error, gotATOK, "[TinyGsmSim7080] Restart failed, no answer 'AT' received!")
-    if (!gotATOK) { success = false; goto end; }
+    return bringUp;
+  }
 
-    DBGLOG(Info, "[TinyGsmSim7080] setPhoneFunctionality(0) ...");
-    if (!setPhoneFunctionality(0)) { 
-      DBGLOG(Error, "[TinyGsmSim7080] Restart failed, setPhoneFunctionality(0) failed!")
-      goto end; 
+  TinyGsmBringUpState bringUpState() const {
+    return bringUp;
+  }
+
+  bool bringUpRunning() const {
+    return bringUp != TINY_GSM_BRINGUP_IDLE && bringUp < TINY_GSM_BRINGUP_READY;
+  }
+
+  /**
+   * @brief The progress of the running bring-up in percent, 100 when done.
+   */
+  uint8_t bringUpProgress() const {
+    return bringUpClock.progress(millis());
+  }
+
+  /**
+   * @brief The estimated time (ms) until the modem is ready; learned from the
+   * bring-ups before.  0 when done.
+   */
+  uint32_t bringUpEta() const {
+    return bringUpClock.eta(millis());
+  }
+
+ protected:
+  bool startBringUp(const char* pin, bool restart, bool driven) {
+    if (bringUpRunning()) { return false; }
+    bringUpDriven  = driven;
+    bringUpPinSent = false;
+    bringUpPin[0]  = '\0';
+    if (pin != nullptr) { snprintf(bringUpPin, sizeof(bringUpPin), "%s", pin); }
+
+    uint16_t plan = (1U << TINY_GSM_BRINGUP_PROBE) | (1U << TINY_GSM_BRINGUP_CONFIG) |
+        (1U << TINY_GSM_BRINGUP_SIM);
+    if (restart) {
+      plan |= (1U << TINY_GSM_BRINGUP_CFUN_OFF) | (1U << TINY_GSM_BRINGUP_CFUN_ON) |
+          (1U << TINY_GSM_BRINGUP_REBOOT) | (1U << TINY_GSM_BRINGUP_BOOTING);
     }
-    DBGLOG(Info, "[TinyGsmSim7080] setPhoneFunctionality(1, true) ...");
-//    if (!setPhoneFunctionality(1, true)) { 
-    if (!setPhoneFunctionality(1)) { 
-      DBGLOG(Error, "[TinyGsmSim7080] Restart failed, setPhoneFunctionality(1, true) failed!")
-      goto end; 
+    bringUpRestart = restart;
+    bringUpClock.begin(plan, millis());
+    bringUpEnter(TINY_GSM_BRINGUP_PROBE);
+    return true;
+  }
+
+  // Drive the bring-up to its end in the calling task, for init() and
+  // restart().
+  bool runBringUp() {
+    TinyGsmBringUpState s;
+    while ((s = bringUpStep()) != TINY_GSM_BRINGUP_READY &&
+           s != TINY_GSM_BRINGUP_FAILED) {
+      delay(1);
+      TINY_GSM_YIELD();
     }
+    return s == TINY_GSM_BRINGUP_READY;
+  }
 
-    DBGLOG(Info, "[TinyGsmSim7080] Rebooting ...");
-    sendAT(GF("+CREBOOT"));  // Reboot
-    success &= waitResponse(30000L, s) == 1;
-    DBGCHK(Error, success, "[TinyGsmSim7080] Reboot failed: %s", s.c_str())
-    DBGCHK(Info, !success, "[TinyGsmSim7080] Reboot initiated successful: %s", s.c_str())
-/**/    
-    resp = waitResponse(30000L, s);
-//    resp = waitResponse(30000L, s, GF("SMS Ready"));
-    DBGLOG(Info, "[TinyGsmSim7080] Reboot response: %i, %s", resp, s.c_str());
+  void bringUpEnter(TinyGsmBringUpState state) {
+    DBGLOG(Info, "[TinyGsmSim7080] bring-up: %hhu -> %hhu", static_cast<uint8_t>(bringUp), static_cast<uint8_t>(state))
+    bringUp      = state;
+    bringUpSub   = 0;
+    bringUpSince = millis();
+    bringUpNext  = bringUpSince;
+    // The module needs a moment after the reboot before it listens
+    if (state == TINY_GSM_BRINGUP_BOOTING) { bringUpNext += 2000; }
+    bringUpClock.enter(state, bringUpSince);
+  }
 
-    MS_TINY_GSM_SEM_GIVE_WAIT
+  void bringUpFail() {
+    DBGLOG(Error, "[TinyGsmSim7080] bring-up failed in step %hhu, AT%s: %s", static_cast<uint8_t>(bringUp), bringUpReq.commandText(), bringUpReq.response())
+    bringUpEnter(TINY_GSM_BRINGUP_FAILED);
+  }
 
-    success &= initImpl(pin);
-    goto endx;
+  // Try again after delay_ms, or fail if the step took longer than limit_ms.
+  void bringUpRetry(uint32_t delay_ms, uint32_t limit_ms) {
+    if (millis() - bringUpSince >= limit_ms) {
+      bringUpFail();
+    } else {
+      bringUpNext = millis() + delay_ms;
+    }
+  }
 
-  end:
-    MS_TINY_GSM_SEM_GIVE_WAIT
+  // Submit the command of the current step.
+  void bringUpSubmit() {
+    bringUpReq.expect(GFP(GSM_OK), GFP(GSM_ERROR)).timeout(10000L);
+    switch (bringUp) {
+      case TINY_GSM_BRINGUP_PROBE:
+      case TINY_GSM_BRINGUP_BOOTING:
+        bringUpReq.command(GF("E0")).timeout(500L);  // Echo Off
+        break;
+      case TINY_GSM_BRINGUP_CFUN_OFF:
+        bringUpReq.command(GF("+CFUN=0"));
+        break;
+      case TINY_GSM_BRINGUP_CFUN_ON: bringUpReq.command(GF("+CFUN=1")); break;
+      case TINY_GSM_BRINGUP_REBOOT:
+        bringUpReq.command(GF("+CREBOOT")).timeout(30000L);
+        break;
+      case TINY_GSM_BRINGUP_CONFIG:
+        switch (bringUpSub) {
+          // Numeric error codes: a failing command ends its wait at once
+          // with the code, see TinyGsmResult
+          case 0: bringUpReq.command(GF("+CMEE=1")).timeout(1000L); break;
+          // Enable Local Time Stamp for getting network time
+          case 1: bringUpReq.command(GF("+CLTS=1")); break;
+          // Enable battery checks
+          default: bringUpReq.command(GF("+CBATCHK=1")).timeout(1000L); break;
+        }
+        break;
+      case TINY_GSM_BRINGUP_SIM:
+        if (bringUpSub == 1) {
+          bringUpReq.command(GF("+CPIN=\""), bringUpPin, '"').timeout(1000L);
+        } else {
+          bringUpReq.command(GF("+CPIN?")).timeout(1000L);
+        }
+        break;
+      default: return;
+    }
+    bringUpWaiting = submitAT(bringUpReq);
+    if (!bringUpWaiting) { bringUpFail(); }
+  }
 
-  endx:
-    DBGLOG(Info, "[TinyGsmSim7080] << return: %s", DBGB2S(success));
-    return success;
-  } // TinyGsmSim7080::restartImpl(...)
+  // The command of the current step is done with result (see
+  // TinyGsmATRequest::result()); go on.
+  void bringUpDone(int8_t result) {
+    switch (bringUp) {
+      case TINY_GSM_BRINGUP_PROBE:
+      case TINY_GSM_BRINGUP_BOOTING:
+        if (result == 1) {
+          bringUpEnter(bringUp == TINY_GSM_BRINGUP_PROBE && bringUpRestart ?
+                           TINY_GSM_BRINGUP_CFUN_OFF :
+                           TINY_GSM_BRINGUP_CONFIG);
+        } else {
+          bringUpRetry(100, bringUp == TINY_GSM_BRINGUP_PROBE ? 10000L : 30000L);
+        }
+        break;
+      case TINY_GSM_BRINGUP_CFUN_OFF:
+      case TINY_GSM_BRINGUP_CFUN_ON:
+      case TINY_GSM_BRINGUP_REBOOT:
+        if (result != 1) {
+          bringUpFail();
+        } else {
+          bringUpEnter(static_cast<TinyGsmBringUpState>(bringUp + 1));
+        }
+        break;
+      case TINY_GSM_BRINGUP_CONFIG:
+        // +CMEE=1 is optional
+        if (result != 1 && bringUpSub > 0) {
+          bringUpFail();
+        } else if (++bringUpSub > 2) {
+          bringUpEnter(TINY_GSM_BRINGUP_SIM);
+        }
+        break;
+      case TINY_GSM_BRINGUP_SIM:
+        if (bringUpSub == 1) {
+          // Unlocked or not, ask again
+          bringUpSub     = 0;
+          bringUpPinSent = true;
+        } else if (result == 1 && strstr(bringUpReq.response(), "READY")) {
+          bringUpEnter(TINY_GSM_BRINGUP_READY);
+        } else if (result == 1 && (strstr(bringUpReq.response(), "SIM PIN") ||
+                                   strstr(bringUpReq.response(), "SIM PUK"))) {
+          if (bringUpPin[0] != '\0' && !bringUpPinSent) {
+            bringUpSub = 1;
+          } else if (bringUpPin[0] == '\0') {
+            // Locked, but no pin given: that's all init() can do
+            bringUpEnter(TINY_GSM_BRINGUP_READY);
+          } else {
+            bringUpFail();  // still locked after the pin
+          }
+        } else {
+          // Not inserted or not ready yet
+          bringUpRetry(1000, 10000L);
+        }
+        break;
+      default: break;
+    }
+  }
 
   /*
    * Generic network functions
@@ -478,43 +731,18 @@ end:
    * GPRS functions
    */
  protected:
-  bool gprsConnectImpl(const char* apn, const char* user = nullptr,
-                       const char* pwd = nullptr) {
-    DBGLOG(Info, "[TinyGsmSim7080] >> apn: '%s', user: %s", apn == nullptr ? "-" : apn, user == nullptr ? "-" : user);
-    bool res    = false;
-    int  ntries = 0;
-
-    gprsDisconnect();
-
-    // gprsDisconnect() has its own "blocking".
-    MS_TINY_GSM_SEM_TAKE_WAIT
-
-    DBGLOG(Info, "[TinyGsmSim7080] -1- CGDCONT")
-
+  // The steps of gprsConnect() up to the bearer settings.  Only a failing
+  // attach fails the connect, like it was before.  The settings (PDP context
+  // and bearer) are chained into one line ahead of the attach, which is sent
+  // on its own: a chained line failing is run again command by command, and
+  // the attach must not be repeated.
+  void gprsSettings(TinyGsmATBatch& batch, const char* apn, const char* user,
+                    const char* pwd) {
     // Define the PDP context
-    sendAT(GF("+CGDCONT=1,\"IP\",\""), apn, '"');
-    waitResponse();
-
-    DBGLOG(Info, "[TinyGsmSim7080] -2- CGATT")
-
-    // Attach to GPRS
-    sendAT(GF("+CGATT=1"));
-    if (waitResponse(60000L) != 1) { res = false; goto end; }
-
-    // NOTE:  **DO NOT** activate the PDP context
-    // For who only knows what reason, doing so screws up the rest of the
-    // process
-
-    DBGLOG(Info, "[TinyGsmSim7080] -3- CGNAPN")
-
-    // Check the APN returned by the server
-    // not sure why, but the connection is more consistent with this
-    sendAT(GF("+CGNAPN"));
-    waitResponse();
+    batch.addOptional(GF("+CGDCONT=1,\"IP\",\""), apn, '"');
 
-    DBGLOG(Info, "[TinyGsmSim7080] -4- CNCFG")
-
-    // Bearer settings for applications based on IP
+    // Bearer settings for applications based on IP; they are applied by
+    // +CNACT, so they may be set before the attach.
     // Set the user name and password
     // AT+CNCFG=<pdpidx>,<ip_type>,[<APN>,[<usename>,<password>,[<authentication>]]]
     // <pdpidx> PDP Context Identifier - for reasons not understood by me,
@@ -527,18 +755,59 @@ end:
     //                  2: CHAP
     //                  3: PAP or CHAP
     if (pwd && strlen(pwd) > 0 && user && strlen(user) > 0) {
-      sendAT(GF("+CNCFG=0,1,\""), apn, "\",\"", user, "\",\"", pwd, "\",3");
-      waitResponse();
+      batch.addOptional(GF("+CNCFG=0,1,\""), apn, "\",\"", user, "\",\"", pwd, "\",3");
     } else if (user && strlen(user) > 0) {
       // Set the user name only
-      sendAT(GF("+CNCFG=0,1,\""), apn, "\",\"", user, '"');
-      waitResponse();
+      batch.addOptional(GF("+CNCFG=0,1,\""), apn, "\",\"", user, '"');
     } else {
       // Set the APN only
-      sendAT(GF("+CNCFG=0,1,\""), apn, '"');
-      waitResponse();
+      batch.addOptional(GF("+CNCFG=0,1,\""), apn, '"');
+    }
+
+    // Attach to GPRS; it may take up to 60s.
+    batch.addUnchained(60000L, GF("+CGATT=1"));
+
+    // NOTE:  **DO NOT** activate the PDP context
+    // For who only knows what reason, doing so screws up the rest of the
+    // process
+
+    // Check the APN returned by the server
+    // not sure why, but the connection is more consistent with this
+    batch.addOptional(GF("+CGNAPN"));
+  }
+
+  TinyGsmResult gprsConnectImpl(const char* apn, const char* user = nullptr,
+                                const char* pwd        = nullptr,
+                                uint32_t    timeout_ms = TINY_GSM_GPRS_CONNECT_TIMEOUT_MS) {
+    DBGLOG(Info, "[TinyGsmSim7080] >> apn: '%s', user: %s, timeout: %" PRIu32 "ms", apn == nullptr ? "-" : apn, user == nullptr ? "-" : user, timeout_ms);
+    bool   res    = false;
+    int    ntries = 0;
+    int8_t active = -1;
+
+    // One deadline for all steps, the disconnect included.
+    TinyGsmDeadline deadline(timeout_ms);
+    TinyGsmDeadline outer;
+    TinyGsmResult   r;
+
+    gprsDisconnectImpl(deadline.remaining());
+
+    // gprsDisconnect() has its own "blocking".
+    MS_TINY_GSM_SEM_TAKE_WAIT
+
+    outer = beginDeadline(deadline);
+    if (deadlinePassed()) { goto end; }
+
+    DBGLOG(Info, "[TinyGsmSim7080] -1- CGDCONT, CNCFG, CGATT, CGNAPN")
+
+    // The steps up to the bearer settings are sent as one batch.
+    {
+      TinyGsmATBatch batch;
+      gprsSettings(batch, apn, user, pwd);
+      if (!sendATBatch(batch)) { res = false; goto end; }
     }
 
+    if (deadlinePassed()) { goto end; }
+
     // Activate application network connection
     // AT+CNACT=<pdpidx>,<action>
     // <pdpidx> PDP Context Identifier - for reasons not understood by me,
@@ -546,43 +815,110 @@ end:
     // <action> 0: Deactive
     //          1: Active
     //          2: Auto Active
-    while (!res && ntries < 5) {
+    // The modem answers OK and tells with "+APP PDP: 0,ACTIVE" (or DEACTIVE)
+    // when it is done; the others can have the modem meanwhile.
+    while (!res && ntries < 5 && !deadlinePassed()) {
       DBGLOG(Info, "[TinyGsmSim7080] CNACT ntries: %i", ntries);
+      active = expectCompletion(GF("+APP PDP: "), 0);
       sendAT(GF("+CNACT=0,1"));
-      res = waitResponse(60000L, GF(AT_NL "+APP PDP: 0,ACTIVE"),
-                         GF(AT_NL "+APP PDP: 0,DEACTIVE"));
-      waitResponse();
+      res = waitResponse() == 1 && waitCompletion(active, 60000L);
+      DBGLOG(Info, "[TinyGsmSim7080] +APP PDP: 0,%s", completionLine(active));
+      endCompletion(active);
+      active = -1;
       ntries++;
     }
 
   end:
+    endCompletion(active);
+    r = operationResult(res);
+    endDeadline(outer);
+
     MS_TINY_GSM_SEM_GIVE_WAIT
 
-    DBGLOG(Info, "[TinyGsmSim7080] << return: %s", DBGB2S(res));
-    return res;
+    DBGLOG(Info, "[TinyGsmSim7080] << return: %s, error: %hi", r.text(), r.error);
+    return r;
   } // TinyGsmSim7080::gprsConnectImpl(...)
 
-  bool gprsDisconnectImpl() {
+  TinyGsmResult gprsDisconnectImpl(uint32_t timeout_ms = TINY_GSM_GPRS_DISCONNECT_TIMEOUT_MS) {
     // Shut down the general application TCP/IP connection
     // CNACT will close *all* open application connections
     DBGLOG(Info, "[TinyGsmSim7080] >>");
 
+    TinyGsmDeadline deadline(timeout_ms);
+
     MS_TINY_GSM_SEM_TAKE_WAIT
 
+    TinyGsmDeadline outer = beginDeadline(deadline);
     bool ret = false;
 
-    sendAT(GF("+CNACT=0,0"));
-    if (waitResponse(60000L) == 1) {
-      sendAT(GF("+CGATT=0"));  // Deactivate the bearer context
-      if (waitResponse(60000L) == 1) { ret = true; }
+    if (!deadlinePassed()) {
+      sendAT(GF("+CNACT=0,0"));
+      if (waitResponse(60000L) == 1 && !deadlinePassed()) {
+        sendAT(GF("+CGATT=0"));  // Deactivate the bearer context
+        if (waitResponse(60000L) == 1) { ret = true; }
+      }
     }
 
+    TinyGsmResult r = operationResult(ret);
+    endDeadline(outer);
+
     MS_TINY_GSM_SEM_GIVE_WAIT
 
-    DBGLOG(Info, "[TinyGsmSim7080] << return: %s", DBGB2S(ret));
-    return ret;
+    DBGLOG(Info, "[TinyGsmSim7080] << return: %s, error: %hi", r.text(), r.error);
+    return r;
   } // TinyGsmSim7080::gprsDisconnectImpl()
 
+#if defined TINY_GSM_COROUTINES
+  // The same steps as gprsConnectImpl() and gprsDisconnectImpl(), each one
+  // awaited, so the calling task is free while the modem attaches.
+  TinyGsmTask<bool> gprsConnectAsyncImpl(const char* apn,
+                                         const char* user       = nullptr,
+                                         const char* pwd        = nullptr,
+                                         uint32_t    timeout_ms = TINY_GSM_GPRS_CONNECT_TIMEOUT_MS) {
+    DBGLOG(Info, "[TinyGsmSim7080] >> apn: '%s', user: %s, timeout: %" PRIu32 "ms", apn == nullptr ? "-" : apn, user == nullptr ? "-" : user, timeout_ms);
+    // One deadline for all steps, the disconnect included.
+    TinyGsmDeadline  deadline(timeout_ms);
+    TinyGsmATRequest req;
+    TinyGsmATBatch   batch;
+    bool             res    = false;
+    int              ntries = 0;
+
+    co_await gprsDisconnectAsyncImpl(deadline.remaining());
+
+    gprsSettings(batch, apn, user, pwd);
+    if (!co_await sendATBatchAsync(batch, deadline)) {
+      DBGLOG(Info, "[TinyGsmSim7080] << return: false, CGATT failed");
+      co_return false;
+    }
+
+    // Activate application network connection, see gprsConnectImpl(); the OK
+    // comes before the "+APP PDP" URC, so the URC is what is waited for.  An
+    // ERROR ends the wait at once.
+    req.expect(GF(AT_NL "+APP PDP: 0,ACTIVE"), GF(AT_NL "+APP PDP: 0,DEACTIVE"),
+               GFP(GSM_ERROR));
+    while (!res && ntries < 5 && !deadline.expired()) {
+      DBGLOG(Info, "[TinyGsmSim7080] CNACT ntries: %i", ntries);
+      req.command(GF("+CNACT=0,1")).timeout(deadline.cap(60000L));
+      res = co_await atAsync(req) == 1;
+      ntries++;
+    }
+
+    DBGLOG(Info, "[TinyGsmSim7080] << return: %s", DBGB2S(res));
+    co_return res;
+  } // TinyGsmSim7080::gprsConnectAsyncImpl(...)
+
+  TinyGsmTask<bool> gprsDisconnectAsyncImpl(uint32_t timeout_ms = TINY_GSM_GPRS_DISCONNECT_TIMEOUT_MS) {
+    TinyGsmDeadline  deadline(timeout_ms);
+    TinyGsmATRequest req;
+    if (co_await atAsync(req.command(GF("+CNACT=0,0")).timeout(deadline.cap(60000L))) != 1 ||
+        deadline.expired()) {
+      co_return false;
+    }
+    // Deactivate the bearer context
+    co_return co_await atAsync(req.command(GF("+CGATT=0")).timeout(deadline.cap(60000L))) == 1;
+  } // TinyGsmSim7080::gprsDisconnectAsyncImpl()
+#endif
+
   /*
    * SIM card functions
    */
@@ -732,24 +1068,102 @@ DBGCOD(
 )
 // <MS>
 
-  bool modemConnect(const char* host, uint16_t port, uint8_t mux,
-                    bool ssl = false, int timeout_s = 75) {
+  // The result is taken while the modem is locked: timeout, ERROR with the
+  // <result> of +CAOPEN, or the error code of a failing command.
+  TinyGsmResult modemConnect(const char* host, uint16_t port, uint8_t mux,
+                             bool ssl = false, int timeout_s = 75) {
     DBGLOG(Info, "[TinyGsmSim7080] (mux: %hhu) >> host: '%s', port: %hu, ssl: %s, timeout: %is", 
       mux, host == nullptr ? "-" : host, port, DBGB2S(ssl), timeout_s)
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
-    
     uint32_t timeout_ms = ((uint32_t)timeout_s) * 1000;
+
+    // One deadline for all steps, the wait for the modem included; every
+    // waitResponse below is capped by it.
+    TinyGsmDeadline deadline(timeout_ms);
+
+    MS_TINY_GSM_SEM_TAKE_WAIT
+
+    TinyGsmDeadline outer = beginDeadline(deadline);
     bool ret = false;
     int8_t res = -1;
+    TinyGsmResult r;
 
-    // set the connection (mux) identifier to use
-    sendAT(GF("+CACID="), mux);
-    if (waitResponse(timeout_ms) != 1) { 
-      DBGLOG(Warn, "[TinyGsmSim7080] (mux: %hhu)Set the connection (mux) identifier to use failed.", mux)
-      goto end; 
+    if (!modemOpen(host, port, mux, ssl, timeout_ms)) { goto end; }
+    // The result is taken by handleCAOPEN(), whoever reads it; while the
+    // connection is being opened the others can have the modem, see
+    // waitUntil().
+    if (!waitUntil([this, mux] { return openResult[mux] >= 0; }, timeout_ms)) {
+      goto end;
     }
+    // returns OK/r/n/r/n+CAOPEN: <cid>,<result>
+    // <result> 0: Success
+    //          1: Socket error
+    //          2: No memory
+    //          3: Connection limit
+    //          4: Parameter invalid
+    //          6: Invalid IP address
+    //          7: Not support the function
+    //          12: Can’t bind the port
+    //          13: Can’t listen the port
+    //          20: Can’t resolve the host
+    //          21: Network not active
+    //          23: Remote refuse
+    //          24: Certificate’s time expired
+    //          25: Certificate’s common name does not match
+    //          26: Certificate’s common name does not match and time expired
+    //          27: Connect failed
+    // make sure the connection really opened
+    res = openResult[mux];
+
+    ret = (0 == res);
+
+    DBGCHK(Error, ret, "[TinyGsmSim7080] (mux: %hhu) Result of +CAOPEN: %hhi-%s", mux, res, getCaopenResultText(res))
+
+end:
+    r = res > 0 ? TinyGsmResult(TINY_GSM_RESULT_ERROR, res) : operationResult(ret);
+    endDeadline(outer);
+
+    MS_TINY_GSM_SEM_GIVE_WAIT
+
+    DBGLOG(Info, "[TinyGsmSim7080] (mux: %hhu) << return: %s, result of +CAOPEN: %hhi", mux, r.text(), res)
+
+    return r;
+  } // ::modemConnect(...)
+
+  // Start opening the connection and return once the modem took +CAOPEN;
+  // the result comes with the URC, see handleCAOPEN() and
+  // GsmClientSim7080::connectAsync().
+  bool modemConnectAsync(const char* host, uint16_t port, uint8_t mux,
+                         bool ssl = false, int timeout_s = 75) {
+    DBGLOG(Info, "[TinyGsmSim7080] (mux: %hhu) >> host: '%s', port: %hu, ssl: %s, timeout: %is", 
+      mux, host == nullptr ? "-" : host, port, DBGB2S(ssl), timeout_s)
+
+    TinyGsmDeadline deadline(((uint32_t)timeout_s) * 1000);
+
+    MS_TINY_GSM_SEM_TAKE_WAIT
+
+    TinyGsmDeadline outer = beginDeadline(deadline);
+    bool ret = modemOpen(host, port, mux, ssl, ((uint32_t)timeout_s) * 1000);
+    endDeadline(outer);
+
+    MS_TINY_GSM_SEM_GIVE_WAIT
+
+    DBGLOG(Info, "[TinyGsmSim7080] (mux: %hhu) << return: %s", mux, DBGB2S(ret))
+    return ret;
+  } // ::modemConnectAsync(...)
+
+  // Send the settings of the connection and +CAOPEN; true if the modem took
+  // it.  The result follows with +CAOPEN: <cid>,<result>, see handleCAOPEN().
+  // Call with the modem locked.
+  bool modemOpen(const char* host, uint16_t port, uint8_t mux, bool ssl,
+                 uint32_t timeout_ms) {
+    // All settings are sent as one batch, with one round trip if the modem
+    // takes them in one line.  Failing to enable/disable ssl or to set the
+    // SNI is ignored, like it was before.
+    TinyGsmATBatch batch;
 
+    // set the connection (mux) identifier to use
+    batch.addTimed(timeout_ms, GF("+CACID="), mux);
 
     if (ssl) {
       // set the ssl version
@@ -765,13 +1179,9 @@ DBGCOD(
       //              5: QAPI_NET_SSL_PROTOCOL_DTLS_1_2
       // NOTE:  despite docs using caps, "sslversion" must be in lower case
 // <MS>
-      sendAT(GF("+CSSLCFG=\"sslversion\",0,3"));  // TLS 1.2
-//      sendAT(GF("+CSSLCFG=\"sslversion\","), mux, GF(",3"));  // TLS 1.2
+      batch.addTimed(5000L, GF("+CSSLCFG=\"sslversion\",0,3"));  // TLS 1.2
+//      batch.add(GF("+CSSLCFG=\"sslversion\","), mux, GF(",3"));  // TLS 1.2
 // <MS>      
-      if (waitResponse(5000L) != 1)  { 
-        DBGLOG(Error, "[TinyGsmSim7080] (mux: %hhu) Set the ssl version failed.", mux);
-        goto end; 
-      }
     }
 
     // enable or disable ssl
@@ -779,13 +1189,11 @@ DBGCOD(
     // <cid> Application connection ID (set with AT+CACID above)
     // <sslFlag> 0: Not support SSL
     //           1: Support SSL
-    sendAT(GF("+CASSLCFG="), mux, ',', GF("SSL,"), ssl);
-    waitResponse();
+    batch.addOptional(GF("+CASSLCFG="), mux, ',', GF("SSL,"), ssl);
 
     if (ssl) {
 // <MS> NEW
-//      sendAT(GF("+CASSLCFG="), mux, ',', GF("crindex,"), mux);
-//      waitResponse();
+//      batch.add(GF("+CASSLCFG="), mux, ',', GF("crindex,"), mux);
 // <MS>
 
       // set the PDP context to apply SSL to
@@ -795,16 +1203,11 @@ DBGCOD(
       //            the gprsConnect function
       // NOTE:  despite docs using "CRINDEX" in all caps, the module only
       // accepts the command "ctxindex" and it must be in lower case
+      // The certificate information it returns is skipped by waitResponse.
 // <MS>      
-      sendAT(GF("+CSSLCFG=\"ctxindex\",0"));
-//      sendAT(GF("+CSSLCFG=\"ctxindex\","), mux);
+      batch.addTimed(5000L, GF("+CSSLCFG=\"ctxindex\",0"));
+//      batch.add(GF("+CSSLCFG=\"ctxindex\","), mux);
 // <MS>      
-      if (waitResponse(5000L, GF("+CSSLCFG:")) != 1)  { 
-        DBGLOG(Error, "[TinyGsmSim7080] (mux: %hhu) +CSSLCFG=\'ctxindex\' failed.", mux);
-        goto end; 
-      }
-      streamSkipUntil('\n');  // read out the certificate information
-      waitResponse();
 
       if (certificates[mux] != "") {
         // <MS> Looks like that it is not possible to upload the certificate itself,
@@ -816,12 +1219,8 @@ DBGCOD(
         // <cid> Application connection ID (set with AT+CACID above)
         // <certname> certificate name
         DBGLOG(Info, "[TinyGsmSim7080] (mux: %hhu) set certificate ...", mux);
-        sendAT(GF("+CASSLCFG="), mux, ",CACERT,\"", certificates[mux].c_str(),
-               "\"");
-        if (waitResponse(5000L) != 1)  { 
-          DBGLOG(Warn, "[TinyGsmSim7080] (mux: %hhu) Set certificate failed.");
-          goto end; 
-        }
+        batch.addTimed(5000L, GF("+CASSLCFG="), mux, ",CACERT,\"",
+                       certificates[mux].c_str(), "\"");
       }
 
       // set the SSL SNI (server name indication)
@@ -830,11 +1229,15 @@ DBGCOD(
       //            use PDP context identifier of 0 for what we defined as 1 in
       //            the gprsConnect function
       // NOTE:  despite docs using caps, "sni" must be in lower case
-      DBGLOG(Info, "[TinyGsmSim7080] (mux: %hhu)  +CSSLCFG=/sni/ ...", mux)
-//      sendAT(GF("+CSSLCFG=\"sni\","), mux, ',', GF("\""), host, GF("\""));
-      sendAT(GF("+CSSLCFG=\"sni\",0,"), GF("\""), host, GF("\""));
-      waitResponse();
+//      batch.add(GF("+CSSLCFG=\"sni\","), mux, ',', GF("\""), host, GF("\""));
+      batch.addOptional(GF("+CSSLCFG=\"sni\",0,"), GF("\""), host, GF("\""));
+    }
+
+    if (!sendATBatch(batch)) {
+      DBGLOG(Error, "[TinyGsmSim7080] (mux: %hhu) Connection settings failed.", mux)
+      return false;
     }
+    if (deadlinePassed()) { return false; }
 
     // actually open the connection
     // AT+CAOPEN=<cid>,<pdp_index>,<conn_type>,<server>,<port>[,<recv_mode>]
@@ -848,57 +1251,30 @@ DBGCOD(
     //                +CAURC:
     //                "recv",<id>,<length>,<remoteIP>,<remote_port><CR><LF><data>
     // NOTE:  including the <recv_mode> fails
+    openResult[mux] = -1;
     sendAT(GF("+CAOPEN="), mux, GF(",0,\"TCP\",\""), host, GF("\","), port);
-    if (waitResponse(timeout_ms, GF(AT_NL "+CAOPEN:")) != 1) { goto end; }
-    // returns OK/r/n/r/n+CAOPEN: <cid>,<result>
-    // <result> 0: Success
-    //          1: Socket error
-    //          2: No memory
-    //          3: Connection limit
-    //          4: Parameter invalid
-    //          6: Invalid IP address
-    //          7: Not support the function
-    //          12: Can’t bind the port
-    //          13: Can’t listen the port
-    //          20: Can’t resolve the host
-    //          21: Network not active
-    //          23: Remote refuse
-    //          24: Certificate’s time expired
-    //          25: Certificate’s common name does not match
-    //          26: Certificate’s common name does not match and time expired
-    //          27: Connect failed
-    streamSkipUntil(',');  // Skip mux
-
-    // make sure the connection really opened
-    res = streamGetInt8Before('\n');
-    waitResponse();
-
-    ret = (0 == res);
-
-    DBGCHK(Error, ret, "[TinyGsmSim7080] (mux: %hhu) Result of +CAOPEN: %hhi-%s", mux, res, getCaopenResultText(res))
-
-end:
-    MS_TINY_GSM_SEM_GIVE_WAIT
-
-    DBGLOG(Info, "[TinyGsmSim7080] (mux: %hhu) << return: %s, result of +CAOPEN: %hhi", mux, DBGB2S(ret), res)
-
-    return ret;
-  } // ::modemConnect(...)
+    return waitResponse(timeout_ms) == 1;
+  } // ::modemOpen(...)
 
   size_t modemSend(const void* buff, size_t len, uint8_t mux) {
     DBGLOG(Debug, "[TinyGsmSim7080] >> mux: %hhu", mux)
-    DBGCHK(Error, len < UINT16_MAX, "[TinyGsmSim7080] (#%hhu) len(%u) >= UINT16_MAX(%i)!", mux, len, UINT16_MAX)
+    DBGCHK(Error, len < UINT16_MAX, "[TinyGsmSim7080] (#%hhu) len(%zu) >= UINT16_MAX(%i)!", mux, len, UINT16_MAX)
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_DATA, mux)
 
     size_t _len = len;
 
     // send data on prompt
     sendAT(GF("+CASEND="), mux, ',', (uint16_t)len);
-    if (waitResponse(GF(">")) != 1) { _len = 0; goto end; }
+    if (waitResponse(GF(">")) != 1) {
+      // e.g. the socket closed without us getting the URC
+      suspectURCLoss();
+      _len = 0;
+      goto end;
+    }
 
     _len = stream.write(reinterpret_cast<const uint8_t*>(buff), len);
-    DBGCHK(Error, _len == len, "stream.write: _len(%u) != len(%u)", _len, len)
+    DBGCHK(Error, _len == len, "stream.write: _len(%zu) != len(%zu)", _len, len)
     stream.flush();
 
     // OK after posting data
@@ -907,16 +1283,28 @@ end:
   end:
     MS_TINY_GSM_SEM_GIVE_WAIT
 
-    DBGLOG(Debug, "[TinyGsmSim7080] (#%hhu) << return: %u", mux, _len);
+    DBGLOG(Debug, "[TinyGsmSim7080] (#%hhu) << return: %zu", mux, _len);
     return _len;
   } // ::modemSend(...)
 
   size_t modemRead(size_t size, uint8_t mux) {
-    DBGLOG(Debug, "[TinyGsmSim7080] (#%hhu) >> size: %u", mux, size);
     DBGCHK(Error, sockets[mux] != nullptr, "[TinyGsmSim7080] (#%hhu) socket #%hhu does not exist!", mux, mux)
     if (!sockets[mux]) { return 0; }
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_DATA, mux)
+
+    size_t _size = modemReadLocked(size, mux);
+
+    MS_TINY_GSM_SEM_GIVE_WAIT
+
+    return _size;
+  } // ::modemRead(...)
+
+  // Like modemRead(), with the modem locked by the caller.
+  size_t modemReadLocked(size_t size, uint8_t mux) {
+    DBGLOG(Debug, "[TinyGsmSim7080] (#%hhu) >> size: %zu", mux, size);
+    DBGCHK(Warn, MS_TINY_GSM_SEM_BLOCKED, "[TinyGsmSim7080] Not blocked by calling function")
+    if (!sockets[mux]) { return 0; }
 
     long len_confirmed;
     size_t _size = size;
@@ -925,7 +1313,12 @@ end:
 
     sendAT(GF("+CARECV="), mux, ',', (uint16_t)size);
 
-    if (waitResponse(GF("+CARECV:")) != 1) { _size = 0; goto end; }
+    if (waitResponse(GF("+CARECV:")) != 1) {
+      // e.g. the socket closed without us getting the URC
+      suspectURCLoss();
+      _size = 0;
+      goto end;
+    }
 
     // uint8_t ret_mux = stream.parseInt();
     // streamSkipUntil(',');
@@ -952,26 +1345,27 @@ end:
       goto end;
     }
 
-    for (i = 0; i < len_confirmed; i++) {
+    // Copy the payload chunk by chunk into the fifo.
+    for (i = 0; i < len_confirmed;) {
       startMillis = millis();
-      while (!stream.available() &&
+      while (!bufferedStream.fill() &&
              (millis() - startMillis < sockets[mux]->_timeout)) {
         TINY_GSM_YIELD();
       }
       // <MS>
-      if (!stream.available()) {
+      size_t n = bufferedStream.buffered();
+      if (n == 0) {
         DBGLOG(Error, "[TinyGsmSim7080] time-out! Stop reading.")
         break;
       }
-
-      int iread = stream.read();
-
-      // <MS>
-      DBGCHK(Error, (iread >= 0) && (iread <= 0xFF), "[TinyGsmSim7080] iread out-of-range [0..0xFF]: %i! Stop reading.", iread)
-      if (iread < 0) break;
-
-      char c = static_cast<char>(iread);
-      sockets[mux]->rx.put(c);
+      n = TinyGsmMin(n, static_cast<size_t>(len_confirmed - i));
+
+      [[maybe_unused]] int put = sockets[mux]->rx.put(
+          reinterpret_cast<const uint8_t*>(bufferedStream.buffer()),
+          static_cast<int>(n));
+      DBGCHK(Error, put == static_cast<int>(n), "[TinyGsmSim7080] (#%hhu) rx fifo full, %i bytes dropped!", mux, static_cast<int>(n) - put)
+      bufferedStream.consume(n);
+      i += static_cast<int>(n);
     } // for i
 //    DBGCHK(Error, i == len_confirmed, "[TinyGsmSim7080] i(%i) != len_confirmed(%i), i.e. time-out, unexpected end.", i, len_confirmed)
     waitResponse();
@@ -983,15 +1377,15 @@ end:
     _size = static_cast<size_t>(i);
 
   end:
-    MS_TINY_GSM_SEM_GIVE_WAIT
-
-    DBGLOG(Debug, "[TinyGsmSim7080] (#%hhu) << return: %u,  sock_available: %" PRIu16, mux, _size, sockets[mux]->sock_available);
+    DBGLOG(Debug, "[TinyGsmSim7080] (#%hhu) << return: %zu,  sock_available: %zu", mux, _size, sockets[mux]->sock_available);
     return _size;
-  } // ::modemRead(...)
+  } // ::modemReadLocked(...)
 
   size_t modemGetAvailable(uint8_t mux) {
     // If the socket doesn't exist, just return
     size_t result_sum = 0;
+    uint32_t announced  = 0;      // Sockets which had announced data
+    bool     complete   = false;  // The answer covered all sockets
     DBGLOG(Debug, "[TinyGsmSim7080] (mux: %hhu) >>", mux);
     DBGCHK(Warn, MS_TINY_GSM_SEM_BLOCKED, "[TinyGsmSim7080] Not blocked by calling function")
     DBGCHK(Error, (mux == (uint8_t)-1) || (sockets[mux] != nullptr), "[TinyGsmSim7080] (mux: %hhu) socket (mux) does not exist!", mux)
@@ -999,6 +1393,9 @@ end:
 
     // NOTE: This gets how many characters are available on all connections that
     // have data.  It does not return all the connections, just those with data.
+    // So it covers all sockets, whichever mux asked; only if the answer is
+    // complete though, otherwise the announcements are kept.
+    announced = pollStarted();
     sendAT(GF("+CARECV?"));
     for (uint8_t muxNo = 0; muxNo < TINY_GSM_MUX_COUNT; muxNo++) {
       // after the last connection, there's an ok, so we catch it right away
@@ -1010,14 +1407,14 @@ end:
         size_t result  = streamGetSizeBefore('\n');
 
         if (ret_mux >= TINY_GSM_MUX_COUNT) {
-          DBGLOG(Error, "[TinyGsmSim7080] (mux: %hhu) ret_mux out of range: %hhu (range: 0..%i), result: %u", 
+          DBGLOG(Error, "[TinyGsmSim7080] (mux: %hhu) ret_mux out of range: %hhu (range: 0..%i), result: %zu", 
             mux, ret_mux, TINY_GSM_MUX_COUNT - 1, result);
           continue;
         }
 
         result_sum += result;
 
-        DBGLOG(Debug, "[TinyGsmSim7080] (mux: %hhu) muxNo: %hhu, res=1: ret_mux: %hhu, available: %u", mux, muxNo, ret_mux, result);
+        DBGLOG(Debug, "[TinyGsmSim7080] (mux: %hhu) muxNo: %hhu, res=1: ret_mux: %hhu, available: %zu", mux, muxNo, ret_mux, result);
 
         GsmClientSim7080* sock    = sockets[ret_mux];
         if (sock) { sock->sock_available = result; }
@@ -1040,6 +1437,7 @@ end:
           GsmClientSim7080* isock = sockets[extra_mux];
           if (isock) { isock->sock_available = 0; }
         }
+        complete = true;
         break;
       } else {
         // if we got an error, give up
@@ -1049,10 +1447,20 @@ end:
       // Should be a final OK at the end.
       // If every connection was returned, catch the OK here.
       // If only a portion were returned, catch it above.
-      if (muxNo == TINY_GSM_MUX_COUNT - 1) { waitResponse(); }
+      if (muxNo == TINY_GSM_MUX_COUNT - 1) { complete = waitResponse() == 1; }
     } // for muxNo
+    if (complete) {
+      pollFinished();
+    } else {
+      pollFailed(announced);
+    }
 
-    modemGetConnected(mux);  // check the state of all connections
+    // The state of the connections is kept up to date by the +CASTATE URCs;
+    // only ask for it if a URC may have been lost (see suspectURCLoss()).
+    if (urcLossSuspected) {
+      urcLossSuspected = false;
+      modemGetConnected((uint8_t)-1);
+    }
     if (mux == (uint8_t)-1) {
       // No specific mux given, all active muxs updated, no specific return-value expected by caller.
       // If there was at least one mux with available return > 0.
@@ -1065,7 +1473,7 @@ end:
     result_sum = sockets[mux]->sock_available;
 
 end:
-    DBGLOG(Debug, "[TinyGsmSim7080] (mux: %hhu) << return: %u", mux, result_sum);
+    DBGLOG(Debug, "[TinyGsmSim7080] (mux: %hhu) << return: %zu", mux, result_sum);
     return result_sum;
   } // ::modemGetAvailable(...)
 
@@ -1091,12 +1499,12 @@ end:
         size_t status  = streamGetSizeBefore('\n');
 
         if (ret_mux >= TINY_GSM_MUX_COUNT) {
-          DBGLOG(Error, "[TinyGsmSim7080] (mux: %hhu) ret_mux out of range: %hhu (range: 0..%i), status: %u", 
+          DBGLOG(Error, "[TinyGsmSim7080] (mux: %hhu) ret_mux out of range: %hhu (range: 0..%i), status: %zu", 
             mux, ret_mux, TINY_GSM_MUX_COUNT - 1, status);
           continue;
         }
 
-        DBGLOG(Debug, "[TinyGsmSim7080] (mux: %hhu) muxNo: %hhu, res=ok: ret_mux: %hhu, status: %u-%s", 
+        DBGLOG(Debug, "[TinyGsmSim7080] (mux: %hhu) muxNo: %hhu, res=ok: ret_mux: %hhu, status: %zu-%s", 
           mux, muxNo, ret_mux, status,
           (status == 0) ? "Closed by remote server or internal error" :
           (status == 1) ? "Connected to remote server" :
@@ -1159,110 +1567,181 @@ end:
     return connected_sum;
   } // ::modemGetConnected(...)
 
+ public:
+  /**
+   * @brief Ask the modem for the state of all sockets (+CASTATE?).
+   *
+   * Normally not needed: the state is kept up to date by the +CASTATE URCs,
+   * and queried by the next size check after a URC may have been lost.
+   *
+   * @return *true* At least one socket is connected.
+   */
+  bool refreshSocketStates() {
+    MS_TINY_GSM_SEM_TAKE_WAIT
+
+    bool r = modemGetConnected((uint8_t)-1);
+
+    MS_TINY_GSM_SEM_GIVE_WAIT
+
+    return r;
+  }
+
+ protected:
+
   /*
    * Utilities
    */
  public:
-  bool handleURCs(String& data) {
-    if (data.endsWith(GF("+CARECV:"))) {
-      uint8_t  mux = streamGetUInt8Before(',');
-      size_t len = streamGetSizeBefore('\n');
-      if (mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->got_data = true;
-        DBGCHK(Error, len <=1024, "[TinyGsmSim7080] len (%zu) out of range [0..1024]!", len)
-        if (len <= 1024) { sockets[mux]->sock_available = len; }
-      }
-      data = "";
-      DBGLOG(Debug, "{TinyGsmSim7080} Got Data on mux: %hhu, len: %zu", mux, len)
-      return true;
-    } else if (data.endsWith(GF("+CADATAIND:"))) {
-      uint8_t mux = streamGetUInt8Before('\n');
-      if (mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        sockets[mux]->got_data = true;
+  // Used by waitResponse() to compile its URC matcher and to dispatch the
+  // URCs; each handler reads the parameters of its URC from the stream.
+  const TinyGsmURCEntry<TinyGsmSim7080>* urcTable() const {
+    static const TinyGsmURCEntry<TinyGsmSim7080> table[] = {
+        {GF("+CARECV:"), &TinyGsmSim7080::handleCARECV},
+        {GF("+CADATAIND:"), &TinyGsmSim7080::handleCADATAIND},
+        {GF("+CASTATE:"), &TinyGsmSim7080::handleCASTATE},
+        {GF("+CAOPEN:"), &TinyGsmSim7080::handleCAOPEN},
+        {GF("*PSNWID:"), &TinyGsmSim7080::handlePSNWID},
+        {GF("*PSUTTZ:"), &TinyGsmSim7080::handlePSUTTZ},
+        {GF("CTZV:"), &TinyGsmSim7080::handleCTZV},  // also "+CTZV:"
+        {GF("DST: "), &TinyGsmSim7080::handleDST},
+        {GF(AT_NL "SMS Ready" AT_NL), &TinyGsmSim7080::handleSMSReady},
+        {nullptr, nullptr}};
+    return table;
+  }
+
+ protected:
+  bool handleCARECV() {
+    uint8_t  mux = streamGetUInt8Before(',');
+    size_t len = streamGetSizeBefore('\n');
+    if (mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
+      sockets[mux]->got_data = true;
+      DBGCHK(Error, len <=1024, "[TinyGsmSim7080] len (%zu) out of range [0..1024]!", len)
+      if (len <= 1024) { sockets[mux]->sock_available = len; }
+    }
+    DBGLOG(Debug, "{TinyGsmSim7080} Got Data on mux: %hhu, len: %zu", mux, len)
+    return true;
+  }
+
+  bool handleCADATAIND() {
+    uint8_t mux = streamGetUInt8Before('\n');
+    if (mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
+      sockets[mux]->got_data = true;
+    }
+    DBGLOG(Debug, "{TinyGsmSim7080} Got Data on mux: %hhu.", mux)
+    return true;
+  }
+
+  bool handleCASTATE() {
+    uint8_t mux = streamGetUInt8Before(',');
+    int8_t state = streamGetInt8Before('\n');
+    if (mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
+      if (state != 1) {
+        sockets[mux]->sock_connected = false;
+        DBGLOG(Info, "{TinyGsmSim7080} Closed mux: %hhu", mux)
+        this->publishEvent(TINY_GSM_EVENT_SOCKET_CLOSED, mux);
       }
-      data = "";
-      DBGLOG(Debug, "{TinyGsmSim7080} Got Data on mux: %hhu.", mux)
-      return true;
-    } else if (data.endsWith(GF("+CASTATE:"))) {
-      uint8_t mux = streamGetUInt8Before(',');
-      int8_t state = streamGetInt8Before('\n');
-      if (mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-        if (state != 1) {
-          sockets[mux]->sock_connected = false;
-          DBGLOG(Info, "{TinyGsmSim7080} Closed mux: %hhu", mux)
-        }
+    }
+    return true;
+  }
+
+  // The result of +CAOPEN, for modemConnect() waiting for it or for the
+  // client waiting with connectAsync().
+  bool handleCAOPEN() {
+    uint8_t mux = streamGetUInt8Before(',');
+    int8_t  res = streamGetInt8Before('\n');
+    if (mux < TINY_GSM_MUX_COUNT) {
+      openResult[mux]        = res;
+      GsmClientSim7080* sock = sockets[mux];
+      if (sock && sock->connect_state == TINY_GSM_CONNECT_PENDING) {
+        sock->finishConnect(res);
       }
-      data = "";
-      return true;
-    } else if (data.endsWith(GF("*PSNWID:"))) {
-      char dest[128];
-      streamGetCharBefore('\n', dest, sizeof(dest));  // Refresh time zone by network
-//      streamSkipUntil('\n');  // Refresh network name by network
-      data = "";
-      DBGLOG(Info, "\n\n{TinyGsmSim7080} Network name updated, *PSNWID: %s\n\n", dest)
-      return true;
-    } else if (data.endsWith(GF("*PSUTTZ:"))) {
-      char dest[32];
-      streamGetCharBefore('\n', dest, sizeof(dest));  // Refresh time zone by network
-//      streamSkipUntil('\n');  // Refresh time and time zone by network
-      data = "";
-      DBGLOG(Info, "\n\n{TinyGsmSim7080} Network time and time zone updated, *PSUTTZ: %s\n\n", dest)
-      return true;
-//    } else if (data.endsWith(GF("+CTZV:"))) {
-    } else if (data.endsWith(GF("CTZV:"))) {
-      char dest[32];
-      streamGetCharBefore('\n', dest, sizeof(dest));  // Refresh time zone by network
-//      streamSkipUntil('\n');  // Refresh network time zone by network
-      data = "";
-      DBGLOG(Info, "\n\n{TinyGsmSim7080} Network time zone updated, +CTZV: %s\n\n", dest)
-      return true;
-    } else if (data.endsWith(GF("DST: "))) {
-      int dst = streamGetIntegerBefore('\n');  // Refresh time zone by network
-      data = "";
-      DBGCHK(Error, (dst == 0) || (dst == 1), "{TinyGsmSim7080} Daylight savings time state updated, DST out of range: %i", dst)
-      DBGCHK(Info, !((dst == 0) || (dst == 1)), "\n\n{TinyGsmSim7080} Daylight savings time state updated, DST: %i\n\n", dst)
-      if ((dst == 0) || (dst == 1)) { 
-        dayLightSaving = dst;
+    }
+    DBGLOG(Info, "{TinyGsmSim7080} +CAOPEN: %hhu,%hhi", mux, res)
+    return true;
+  }
+
+  // Fail the asynchronous connects without result within their time and
+  // close their sockets, as long as the budget lasts.  While a submitted
+  // command is in flight the close is queued behind it.  Called with the
+  // modem locked.
+  void expireConnects(const TinyGsmBudget& budget) {
+    for (uint8_t mux = 0; mux < TINY_GSM_MUX_COUNT && !budget.exhausted();
+         mux++) {
+      GsmClientSim7080* sock = sockets[mux];
+      if (sock == nullptr || sock->connect_state != TINY_GSM_CONNECT_PENDING ||
+          millis() - sock->connect_start < sock->connect_timeout_ms) {
+        continue;
       }
-      return true;
-    } else if (data.endsWith(GF(AT_NL "SMS Ready" AT_NL))) {
-      data = "";
-      DBGLOG(Warn, "{TinyGsmSim7080} Unexpected module reset!")
-//      init();
-      data = "";
-      return true;
-    } 
-// <MS>
-/*
-    else if (data.indexOf(GF("VOLTAGE")) >= 0) {
-      DBGLOG(Error, "[TinyGsmSim7080] Voltage-message: %s.", asCharString(data.c_str(), 0, data.length()).c_str())
-      streamSkipUntil('\n'); 
-      data = "";
-    } else {
-      String tmp = data;
-      tmp.replace(AT_NL, "/");
-      tmp.trim();
-      if ((tmp.length() > 10) && 
-          (tmp.indexOf(GF("CNACT")) < 0) && 
-          (tmp.indexOf(GF("SLEDS")) < 0) && 
-          (tmp.indexOf(GF("CNET")) < 0) && 
-          (tmp.indexOf(GF("CSGS")) < 0) && 
-          (tmp.indexOf(GF("CGNAP")) < 0) && 
-          (tmp.indexOf(GF("CLTS")) < 0) )
-        {
-        DBGLOG(Warn, "[TinyGsmSim7080] Unknown message: '%s' (%s)", 
-          asCharString(tmp.c_str(), 0, tmp.length()).c_str(), asHexString(tmp.c_str(), 0, tmp.length()).c_str())
+      DBGLOG(Warn, "[TinyGsmSim7080] (mux: %hhu) no +CAOPEN within %" PRIu32 "ms", mux, sock->connect_timeout_ms)
+      if (atRunning != nullptr) {
+        sock->close_req.command(GF("+CACLOSE="), mux).timeout(3000);
+        this->submitAT(sock->close_req);
+      } else {
+        sendAT(GF("+CACLOSE="), mux);
+        waitResponse(3000);
       }
+      sock->finishConnect(-1);
     }
-*/
-// <MS>
+  }
 
-    return false;
-  } // ::handleURCs(...)
+  bool handlePSNWID() {
+    char dest[128];
+    streamGetCharBefore('\n', dest, sizeof(dest));  // Refresh network name by network
+    DBGLOG(Info, "\n\n{TinyGsmSim7080} Network name updated, *PSNWID: %s\n\n", dest)
+    this->publishEvent(TINY_GSM_EVENT_NETWORK_NAME, 0xFF, 0, dest);
+    return true;
+  }
+
+  bool handlePSUTTZ() {
+    char dest[32];
+    streamGetCharBefore('\n', dest, sizeof(dest));  // Refresh time and time zone by network
+    DBGLOG(Info, "\n\n{TinyGsmSim7080} Network time and time zone updated, *PSUTTZ: %s\n\n", dest)
+    this->publishEvent(TINY_GSM_EVENT_NETWORK_TIME, 0xFF, 0, dest);
+    return true;
+  }
+
+  bool handleCTZV() {
+    char dest[32];
+    streamGetCharBefore('\n', dest, sizeof(dest));  // Refresh time zone by network
+    DBGLOG(Info, "\n\n{TinyGsmSim7080} Network time zone updated, +CTZV: %s\n\n", dest)
+    this->publishEvent(TINY_GSM_EVENT_TIME_ZONE, 0xFF, 0, dest);
+    return true;
+  }
+
+  bool handleDST() {
+    int dst = streamGetIntegerBefore('\n');  // Refresh daylight saving by network
+    DBGCHK(Error, (dst == 0) || (dst == 1), "{TinyGsmSim7080} Daylight savings time state updated, DST out of range: %i", dst)
+    DBGCHK(Info, !((dst == 0) || (dst == 1)), "\n\n{TinyGsmSim7080} Daylight savings time state updated, DST: %i\n\n", dst)
+    if ((dst == 0) || (dst == 1)) { 
+      dayLightSaving = dst;
+      this->publishEvent(TINY_GSM_EVENT_DAYLIGHT_SAVING, 0xFF, static_cast<int16_t>(dst));
+    }
+    return true;
+  }
+
+  bool handleSMSReady() {
+    DBGLOG(Warn, "{TinyGsmSim7080} Unexpected module reset!")
+    this->forgetIdentity();
+    this->publishEvent(TINY_GSM_EVENT_MODEM_RESET);
+    suspectURCLoss();  // the sockets are gone
+    return true;
+  }
 
- protected:
   GsmClientSim7080* sockets[TINY_GSM_MUX_COUNT];
   String            certificates[TINY_GSM_MUX_COUNT];
+  int8_t            openResult[TINY_GSM_MUX_COUNT];  /// Of +CAOPEN, -1: none yet, see modemOpen()
+  // See beginInit()
+  TinyGsmBringUpState bringUp = TINY_GSM_BRINGUP_IDLE;  /// The step it is in
+  TinyGsmBringUpClock bringUpClock;                     /// Progress and estimate
+  TinyGsmATRequest    bringUpReq;                       /// Command of the step
+  uint8_t             bringUpSub     = 0;               /// Command within the step
+  uint32_t            bringUpSince   = 0;               /// millis() the step started
+  uint32_t            bringUpNext    = 0;               /// millis() of the next command
+  bool                bringUpRestart = false;           /// restart(), not init()
+  bool                bringUpDriven  = false;           /// Stepped by maintain()
+  bool                bringUpWaiting = false;           /// bringUpReq is submitted
+  bool                bringUpPinSent = false;           /// +CPIN="<pin>" was tried
+  char                bringUpPin[16] = {};              /// The pin to unlock the SIM
 }; // class TinyGsmSim7080
 
 #endif  // SRC_TINYGSMCLIENTSIM7080_H_
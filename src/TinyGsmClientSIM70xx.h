@@ -39,6 +39,7 @@
 #include "TinyGsmModem.tpp"
 #include "TinyGsmGPRS.tpp"
 #include "TinyGsmGPS.tpp"
+#include "TinyGsmStatusCache.h"
 
 
 // For ms_strncpy(...)
@@ -113,11 +114,23 @@ class TinyGsmSim70xx : public TinyGsmModem<SIM70xxType>,
   }
   ~TinyGsmSim70xx() {}
 
+ public:
+  // The mixins have one each, all giving the one of TinyGsmModem.
+  using TinyGsmModem<SIM70xxType>::lockScheduler;
+
   /*
    * Constructor
    */
  public:
-  explicit TinyGsmSim70xx(Stream& _stream) : stream(_stream) {}
+  // All reads go through bufferedStream, which reads the UART in chunks.
+  // With TINY_GSM_RX_PUMP the UART is behind the rx pump.
+#if defined TINY_GSM_RX_PUMP
+  explicit TinyGsmSim70xx(Stream& _stream)
+      : rxPump(_stream, &this->rxSignal), bufferedStream(rxPump), stream(bufferedStream) {}
+#else
+  explicit TinyGsmSim70xx(Stream& _stream)
+      : bufferedStream(_stream), stream(bufferedStream) {}
+#endif
 
   /*
    * Basic functions
@@ -162,11 +175,10 @@ class TinyGsmSim70xx : public TinyGsmModem<SIM70xxType>,
   bool setPhoneFunctionalityImpl(uint8_t fun, bool reset = false) {
     DBGLOG(Info, "[GsmClientSim70xx] >> AT+CFUN=%hhu%s", fun, reset ? ",1" : "")
     thisModem().sendAT(GF("+CFUN="), fun, reset ? ",1" : "");
-    String s;
-    bool ret = thisModem().waitResponse(10000L, s) == 1;
-    DBGLOG(Info, "AT+CFUN=%hhu%s returned - 1: %s, %s", fun, reset ? ",1" : "", DBGB2S(ret), s.c_str())
-    thisModem().waitResponse(10000L, s);
-    DBGLOG(Info, "AT+CFUN=%hhu%s returned - 2: %s", fun, reset ? ",1" : "", s.c_str())
+    bool ret = thisModem().waitResponse(10000L) == 1;
+    DBGLOG(Info, "AT+CFUN=%hhu%s returned - 1: %s, %s", fun, reset ? ",1" : "", DBGB2S(ret), thisModem().lastResponse())
+    thisModem().waitResponse(10000L);
+    DBGLOG(Info, "AT+CFUN=%hhu%s returned - 2: %s", fun, reset ? ",1" : "", thisModem().lastResponse())
     DBGLOG(Info, "[GsmClientSim70xx] << return: %s", DBGB2S(ret))
     return ret;
   }
@@ -190,12 +202,19 @@ class TinyGsmSim70xx : public TinyGsmModem<SIM70xxType>,
     }
   }
 
-  SIM70xxRegStatus getRegistrationStatus() {
+  // Up to maxAge_ms old, see TinyGsmStatusCache.
+  SIM70xxRegStatus getRegistrationStatus(uint32_t maxAge_ms = TINY_GSM_CACHE_REG_MS) {
     DBGLOG(Info, "[TinyGsmSim70xx] >>")
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    SIM70xxRegStatus epsStatus = REG_NO_RESULT;
+    if (regCache.begin(epsStatus, maxAge_ms) != TINY_GSM_CACHE_QUERY) {
+      DBGLOG(Info, "[TinyGsmSim70xx] << return registration status (cached): %i - %s", epsStatus, getRegistrationStatus(epsStatus))
+      return epsStatus;
+    }
 
-    SIM70xxRegStatus epsStatus = (SIM70xxRegStatus)thisModem().getRegistrationStatusXREG("CEREG");
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
+
+    epsStatus = (SIM70xxRegStatus)thisModem().getRegistrationStatusXREG("CEREG");
 
     // If we're connected on EPS, great!
     if (epsStatus == REG_OK_HOME || epsStatus == REG_OK_ROAMING) {
@@ -207,6 +226,8 @@ class TinyGsmSim70xx : public TinyGsmModem<SIM70xxType>,
 
     MS_TINY_GSM_SEM_GIVE_WAIT
 
+    regCache.end(epsStatus != REG_NO_RESULT, epsStatus);
+
     DBGLOG(Info, "[TinyGsmSim70xx] << return registration status: %i - %s", epsStatus, getRegistrationStatus(epsStatus))
     return epsStatus;
   }
@@ -221,7 +242,7 @@ class TinyGsmSim70xx : public TinyGsmModem<SIM70xxType>,
   String getNetworkModes() {
     String res;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     // Get the help string, not the setting value
     thisModem().sendAT(GF("+CNMP=?"));
@@ -239,7 +260,7 @@ class TinyGsmSim70xx : public TinyGsmModem<SIM70xxType>,
   int16_t getNetworkMode() {
     int16_t mode = 0;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     thisModem().sendAT(GF("+CNMP?"));
     if (thisModem().waitResponse(GF(AT_NL "+CNMP:")) != 1) {
@@ -265,7 +286,7 @@ class TinyGsmSim70xx : public TinyGsmModem<SIM70xxType>,
   String getPreferredModes() {
     String res;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     // Get the help string, not the setting value
     thisModem().sendAT(GF("+CMNB=?"));
@@ -283,7 +304,7 @@ class TinyGsmSim70xx : public TinyGsmModem<SIM70xxType>,
   int16_t getPreferredMode() {
     int16_t mode = 0;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     thisModem().sendAT(GF("+CMNB?"));
     if (thisModem().waitResponse(GF(AT_NL "+CMNB:")) != 1) {
@@ -309,7 +330,7 @@ class TinyGsmSim70xx : public TinyGsmModem<SIM70xxType>,
     // n: whether to automatically report the system mode info
     // stat: the current service. 0 if it not connected
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     thisModem().sendAT(GF("+CNSMOD?"));
     if (thisModem().waitResponse(GF(AT_NL "+CNSMOD:")) != 1) { goto end; }
@@ -344,7 +365,7 @@ end:
     thisModem().sendAT(GF("+CCID"));
     if (thisModem().waitResponse(GF(AT_NL)) != 1) { return ""; }
     String res = stream.readStringUntil('\n');
-    thisModem().waitResponse();
+    if (thisModem().waitResponse() != 1) { return ""; }
     res.trim();
     return res;
   }
@@ -460,9 +481,6 @@ end:
     thisModem().waitResponse();
     return false;
   }
-  bool handleURCs(String& data) {
-    return thisModem().handleURCs(data);
-  }
 
  public:
 
@@ -472,10 +490,20 @@ end:
   // @return      
   // @note        
   **/
-  bool getUserEquipmentSystemInfo(MsUserEquipmentSystemInfo& si) {
+  bool getUserEquipmentSystemInfo(MsUserEquipmentSystemInfo& si,
+                                  uint32_t maxAge_ms = TINY_GSM_CACHE_CPSI_MS) {
     bool ret = false;
+    UESIResult cached;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    switch (uesiCache.begin(cached, maxAge_ms)) {
+      case TINY_GSM_CACHE_QUERY: break;
+      case TINY_GSM_CACHE_TIMEOUT: return false;
+      default:
+        si = cached.si;
+        return cached.ok;
+    }
+
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     thisModem().sendAT(GF("+CPSI?"));
     if (thisModem().waitResponse(GF(AT_NL "+CPSI: ")) != 1) goto end;
@@ -508,7 +536,11 @@ end:
 
 end:
     MS_TINY_GSM_SEM_GIVE_WAIT
-    
+
+    cached.ok = ret;
+    cached.si = si;
+    uesiCache.end(ret, cached);
+
     return ret;
   } // TinyGsmSim70xx.getUserEquipmentSystemInfo
 
@@ -522,7 +554,7 @@ end:
     bool ret = false;
     apn[0] = 0;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     thisModem().sendAT(GF("+CGNAPN"));
     if (thisModem().waitResponse(GF(AT_NL "+CGNAPN: ")) != 1) goto end;
@@ -546,39 +578,37 @@ end:
   // @note        Details see latest "SIM7070_SIM7080_SIM7090 Series_AT Command Manual".
   **/
   bool reportNetlightStatus() {
-    String s;
-
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     DBGLOG(Info, "[TinyGsmSim70xx] AT+SLEDS=?")
     thisModem().sendAT(GF("+SLEDS=?"));
-    thisModem().waitResponse(2000L, s);
-    DBGLOG(Info, "[TinyGsmSim70xx] +SLEDS=?: %s", s.c_str());
+    thisModem().waitResponse(2000L);
+    DBGLOG(Info, "[TinyGsmSim70xx] +SLEDS=?: %s", thisModem().lastResponse());
 
     DBGLOG(Info, "[TinyGsmSim70xx] AT+SLEDS?")
     thisModem().sendAT(GF("+SLEDS?"));
-    thisModem().waitResponse(2000L, s);
-    DBGLOG(Info, "[TinyGsmSim70xx] +SLEDS?: %s", s.c_str());
+    thisModem().waitResponse(2000L);
+    DBGLOG(Info, "[TinyGsmSim70xx] +SLEDS?: %s", thisModem().lastResponse());
 
     DBGLOG(Info, "[TinyGsmSim70xx] AT+CNETLIGHT=?")
     thisModem().sendAT(GF("+CNETLIGHT=?"));
-    thisModem().waitResponse(2000L, s);
-    DBGLOG(Info, "[TinyGsmSim70xx] +CNETLIGHT=?: %s", s.c_str());
+    thisModem().waitResponse(2000L);
+    DBGLOG(Info, "[TinyGsmSim70xx] +CNETLIGHT=?: %s", thisModem().lastResponse());
 
     DBGLOG(Info, "[TinyGsmSim70xx] AT+CNETLIGHT?")
     thisModem().sendAT(GF("+CNETLIGHT?"));
-    thisModem().waitResponse(2000L, s);
-    DBGLOG(Info, "[TinyGsmSim70xx] +CNETLIGHT?: %s", s.c_str());
+    thisModem().waitResponse(2000L);
+    DBGLOG(Info, "[TinyGsmSim70xx] +CNETLIGHT?: %s", thisModem().lastResponse());
 
     DBGLOG(Info, "[TinyGsmSim70xx] AT+CSGS=?")
     thisModem().sendAT(GF("+CSGS=?"));
-    thisModem().waitResponse(2000L, s);
-    DBGLOG(Info, "[TinyGsmSim70xx] +CSGS=?: %s", s.c_str());
+    thisModem().waitResponse(2000L);
+    DBGLOG(Info, "[TinyGsmSim70xx] +CSGS=?: %s", thisModem().lastResponse());
 
     DBGLOG(Info, "[TinyGsmSim70xx] AT+CSGS?")
     thisModem().sendAT(GF("+CSGS?"));
-    thisModem().waitResponse(2000L, s);
-    DBGLOG(Info, "[TinyGsmSim70xx] +CSGS?: %s", s.c_str());
+    thisModem().waitResponse(2000L);
+    DBGLOG(Info, "[TinyGsmSim70xx] +CSGS?: %s", thisModem().lastResponse());
 
     MS_TINY_GSM_SEM_GIVE_WAIT
 
@@ -670,7 +700,7 @@ end:
   **/
   String getModemRevisionSoftwareRelease() {
   
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     thisModem().sendAT(GF("+CGMR"));
     String res;
@@ -692,8 +722,21 @@ end:
   } // TinyGsmSim70xx.getModemRevisionSoftwareRelease
 
 
+ protected:
+  // Result of getUserEquipmentSystemInfo(), see uesiCache
+  struct UESIResult {
+    bool                      ok = false;
+    MsUserEquipmentSystemInfo si;
+  };
+  TinyGsmStatusCache<SIM70xxRegStatus> regCache;   /// See getRegistrationStatus()
+  TinyGsmStatusCache<UESIResult>       uesiCache;  /// See getUserEquipmentSystemInfo()
+
  public:
-  Stream& stream;
+#if defined TINY_GSM_RX_PUMP
+  TinyGsmRxPump<TINY_GSM_RX_PUMP_BUFFER>            rxPump;
+#endif
+  TinyGsmBufferedStream<TINY_GSM_STREAM_CHUNK_SIZE> bufferedStream;
+  Stream&                                           stream;
 };
 
 #endif  // SRC_TINYGSMCLIENTSIM70XX_H_
@@ -0,0 +1,273 @@
+/**
+ * @file       TinyGsmCommandBuffer.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMCOMMANDBUFFER_H_
+#define SRC_TINYGSMCOMMANDBUFFER_H_
+
+#include "TinyGsmCommon.h"
+#include <type_traits>
+
+/**
+ * @brief Stack buffer an AT command is formatted into before it is handed to
+ * the modem stream with a single write().
+ *
+ * The arguments are added with the add() overloads, which produce the same
+ * text as Print::print() for the types used in AT commands (strings,
+ * characters, integers and booleans); integers are converted without Print.
+ * If a command does not fit, the filled part is written and the buffer is
+ * reused, so long commands still work, just with more than one write.
+ * Without a stream the buffer just collects text; what does not fit is
+ * dropped and overflow() is set.
+ *
+ * @tparam N The size of the buffer.
+ */
+template <size_t N>
+class TinyGsmCommandBuffer {
+ public:
+  TinyGsmCommandBuffer() : _s(nullptr), _len(0), _overflow(false) {}
+
+  explicit TinyGsmCommandBuffer(Stream& s)
+      : _s(&s), _len(0), _overflow(false) {}
+
+  void add(const char* str) {
+    if (str != nullptr) { append(str, strlen(str)); }
+  }
+
+  void add(const String& str) {
+    append(str.c_str(), str.length());
+  }
+
+  void add(char c) {
+    append(&c, 1);
+  }
+
+  void add(bool b) {
+    add(b ? '1' : '0');
+  }
+
+#if defined(__AVR__) && !defined(__AVR_ATmega4809__)
+  void add(GsmConstStr str) {
+    PGM_P p = reinterpret_cast<PGM_P>(str);
+    char  c;
+    while ((c = pgm_read_byte(p++)) != '\0') { append(&c, 1); }
+  }
+#endif
+
+  /**
+   * @brief Add an integer in decimal, like print() does for all integer types
+   * except char.
+   */
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value>::type add(T v) {
+    typedef typename std::make_unsigned<T>::type U;
+    char  digits[3 * sizeof(T) + 1];
+    char* p = &digits[sizeof(digits)];
+    U     u = static_cast<U>(v);
+    if constexpr (std::is_signed<T>::value) {
+      if (v < 0) {
+        u = static_cast<U>(0U - u);
+        add('-');
+      }
+    }
+    do {
+      *--p = static_cast<char>('0' + u % 10U);
+      u /= 10U;
+    } while (u);
+    append(p, static_cast<size_t>(&digits[sizeof(digits)] - p));
+  }
+
+  /**
+   * @brief Write the buffered characters to the stream.
+   */
+  void send() {
+    if (_s && _len) { _s->write(reinterpret_cast<const uint8_t*>(_b), _len); }
+    _len = 0;
+  }
+
+  const char* data() const {
+    return _b;
+  }
+
+  size_t length() const {
+    return _len;
+  }
+
+  /**
+   * @brief Drop everything after the first n characters and clear overflow().
+   */
+  void truncate(size_t n) {
+    _len      = TinyGsmMin(n, _len);
+    _overflow = false;
+  }
+
+  /**
+   * @brief Check if text was dropped because the buffer (without stream) was
+   * full.
+   */
+  bool overflow() const {
+    return _overflow;
+  }
+
+ private:
+  void append(const char* str, size_t n) {
+    while (n) {
+      if (_len == N) {
+        if (_s == nullptr) {
+          _overflow = true;
+          return;
+        }
+        send();
+      }
+      size_t m = TinyGsmMin(n, N - _len);
+      memcpy(&_b[_len], str, m);
+      _len += m;
+      str += m;
+      n -= m;
+    }
+  }
+
+  Stream* _s;         /// The stream the command is written to, or nullptr
+  char    _b[N];      /// The command
+  size_t  _len;       /// Number of characters in the buffer
+  bool    _overflow;  /// Characters were dropped (only without stream)
+};
+
+/**
+ * @brief A list of AT commands (without the leading "AT") to be run with one
+ * round trip, see TinyGsmModem::sendATBatch().
+ *
+ * Each add() formats one command like sendAT() does.  A command that does not
+ * fit is not added at all and makes the batch invalid, so a batch is never
+ * sent half-formatted.  Every command has its own timeout, 1000 ms (like
+ * waitResponse()) unless added with addTimed() or addUnchained().
+ *
+ * @tparam N The size of the buffer holding all commands.
+ * @tparam maxCmds The maximum number of commands.
+ */
+template <size_t N, uint8_t maxCmds>
+class TinyGsmCommandBatch {
+ public:
+  TinyGsmCommandBatch() {
+    clear();
+  }
+
+  void clear() {
+    _text.truncate(0);
+    _count = 0;
+    _valid = true;
+  }
+
+  template <typename... Args>
+  bool add(Args... parts) {
+    return addCommand(false, 1000L, parts...);
+  }
+
+  /**
+   * @brief Add a command taking up to timeout_ms to answer.
+   */
+  template <typename... Args>
+  bool addTimed(uint32_t timeout_ms, Args... parts) {
+    return addCommand(false, timeout_ms, parts...);
+  }
+
+  /**
+   * @brief Add a command whose failure does not fail the batch.
+   */
+  template <typename... Args>
+  bool addOptional(Args... parts) {
+    return addCommand(true, 1000L, parts...);
+  }
+
+  /**
+   * @brief Add a required command which is always sent on its own line, e.g.
+   * a network operation like the attach: it is never repeated because a
+   * chained line failed, and it does not share its timeout.
+   */
+  template <typename... Args>
+  bool addUnchained(uint32_t timeout_ms, Args... parts) {
+    bool r = addCommand(false, timeout_ms, parts...);
+    if (r) { _unchained[_count - 1] = true; }
+    return r;
+  }
+
+  uint8_t count() const {
+    return _count;
+  }
+
+  /**
+   * @brief The zero terminated text of command i.
+   */
+  const char* command(uint8_t i) const {
+    return _text.data() + _start[i];
+  }
+
+  bool optional(uint8_t i) const {
+    return _optional[i];
+  }
+
+  bool unchained(uint8_t i) const {
+    return _unchained[i];
+  }
+
+  uint32_t timeout(uint8_t i) const {
+    return _timeout[i];
+  }
+
+  /**
+   * @brief The result of command i after sendATBatch(): 1 = OK, 2 = ERROR,
+   * 0 = not run or no answer.
+   */
+  int8_t result(uint8_t i) const {
+    return _result[i];
+  }
+
+  void setResult(uint8_t i, int8_t r) {
+    _result[i] = r;
+  }
+
+  /**
+   * @brief Check if all added commands fitted into the batch.
+   */
+  bool valid() const {
+    return _valid;
+  }
+
+ private:
+  template <typename... Args>
+  bool addCommand(bool opt, uint32_t timeout_ms, Args... parts) {
+    if (_count >= maxCmds) {
+      _valid = false;
+      return false;
+    }
+    size_t start = _text.length();
+    (_text.add(parts), ...);
+    _text.add('\0');
+    if (_text.overflow()) {
+      _text.truncate(start);
+      _valid = false;
+      return false;
+    }
+    _start[_count]     = start;
+    _optional[_count]  = opt;
+    _unchained[_count] = false;
+    _timeout[_count]   = timeout_ms;
+    _result[_count++]  = 0;
+    return true;
+  }
+
+  TinyGsmCommandBuffer<N> _text;                /// The commands, zero separated
+  size_t                  _start[maxCmds];      /// Start of each command
+  bool                    _optional[maxCmds];   /// Failure is ignored
+  bool                    _unchained[maxCmds];  /// Always on its own line
+  uint32_t                _timeout[maxCmds];    /// Timeout of each command
+  int8_t                  _result[maxCmds];     /// Result of each command
+  uint8_t                 _count;               /// Number of commands
+  bool                    _valid;               /// All commands fitted
+};
+
+#endif  // SRC_TINYGSMCOMMANDBUFFER_H_
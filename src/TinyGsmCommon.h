@@ -46,58 +46,55 @@
 #define MS_TINY_GSM_SEM_WAIT_FOR_MS (ULONG_MAX)
 #endif
 
-extern SemaphoreHandle_t msTinyGsmSemProcess;
-
 #if defined(MS_LOGGER_ON)
+// No longer used by the library, kept for applications still defining
+// msTinyGsmSemBlockedByFunc / msTinyGsmSemBlockedByFileName.
 #define MS_TINY_GSM_SEM_BLOCKEDBY_MAXLEN 64
-extern char msTinyGsmSemBlockedByFunc[MS_TINY_GSM_SEM_BLOCKEDBY_MAXLEN];
-extern char msTinyGsmSemBlockedByFileName[MS_TINY_GSM_SEM_BLOCKEDBY_MAXLEN];
-extern int msTinyGsmSemBlockedByLineNumber;
 #endif
 
-// Check [msTinyGsmSemProcess] and wait if necessary until it becomes available.
+// The macros work on the lock of the modem they are used in: a member
+// function lockScheduler() returning its TinyGsmScheduler has to be visible
+// through this, see TinyGsmModem::lockScheduler().
+
+// Check the lock of the modem and wait if necessary until it becomes available.
+// The order of the waiting callers is decided by the TinyGsmScheduler of the
+// modem; this is a caller of class TINY_GSM_SCHED_CONTROL.
 #define MS_TINY_GSM_SEM_TAKE_WAIT \
-	if (xSemaphoreTake(msTinyGsmSemProcess, 0) != pdTRUE) { \
-		DBGLOG( \
-			logLevelSemTinyGsmError, \
-			"### TINY_GSM ### ---> sem not available, wait until it becomes available. Blocked by: %s<%s:%i>", \
-			msTinyGsmSemBlockedByFunc, msTinyGsmSemBlockedByFileName, msTinyGsmSemBlockedByLineNumber) \
-		if (xSemaphoreTake(msTinyGsmSemProcess, ( TickType_t )(MS_TINY_GSM_SEM_WAIT_FOR_MS / portTICK_PERIOD_MS)) == pdTRUE) { \
-			DBGLOG(logLevelSemTinyGsmError, "### TINY_GSM ### ---> sem now available, proceed with code.") \
-		} else { \
-			DBGLOG(Fatal, "### TINY_GSM ### ---> sem-take returned error or time-out after ms: %u.", MS_TINY_GSM_SEM_WAIT_FOR_MS) \
-		} \
-	} else { \
+	MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX)
+
+// Like [MS_TINY_GSM_SEM_TAKE_WAIT], for a caller of the given class
+// (TinyGsmSchedClass) and socket (or TINY_GSM_SCHED_NO_MUX).
+// The call site is counted, see TinyGsmScheduler::topContenders().
+#define MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(cls, mux) \
+	if (this->lockScheduler().acquire(cls, mux, static_cast<uint32_t>(MS_TINY_GSM_SEM_WAIT_FOR_MS), \
+	                                  TINY_GSM_LOCK_SITE, msTinyGsmSemLogWait)) { \
 		DBGLOG(logLevelSemTinyGsmInfo, "### TINY_GSM ### ---> sem available, proceed with code.") \
+	} else { \
+		DBGLOG(Fatal, "### TINY_GSM ### ---> sem-take returned error or time-out after ms: %" PRIu32 ".", static_cast<uint32_t>(MS_TINY_GSM_SEM_WAIT_FOR_MS)) \
 	} \
-	DBGCOD(ms_strncpy(msTinyGsmSemBlockedByFunc, __func__, strlen(__func__), MS_TINY_GSM_SEM_BLOCKEDBY_MAXLEN);) \
-	DBGCOD(ms_strncpy(msTinyGsmSemBlockedByFileName, __FILENAME__, strlen(__FILENAME__), MS_TINY_GSM_SEM_BLOCKEDBY_MAXLEN);) \
-	DBGCOD(msTinyGsmSemBlockedByLineNumber = __LINE__;) \
+	DBGCOD(this->lockScheduler().blockedBy(__func__, __FILENAME__, __LINE__);) \
 
-// Check [msTinyGsmSemProcess] w/o waiting, if available proceed with program code,
+// Check the lock of the modem w/o waiting, if available proceed with program code,
 // otherwise skip program code w/o waiting.
 #define MS_TINY_GSM_SEM_TAKE_IF_AVAILABLE \
-	if (xSemaphoreTake(msTinyGsmSemProcess, 0) != pdTRUE) { \
+	if (!this->lockScheduler().tryAcquire(TINY_GSM_LOCK_SITE)) { \
 		DBGLOG( \
 			logLevelSemTinyGsmWarn, \
 			"### TINY_GSM ### ---> sem not available, do not wait, skip. Blocked by: %s<%s:%i>", \
-			msTinyGsmSemBlockedByFunc, msTinyGsmSemBlockedByFileName, msTinyGsmSemBlockedByLineNumber) \
+			this->lockScheduler().blockedByFunc(), this->lockScheduler().blockedByFile(), \
+			this->lockScheduler().blockedByLine()) \
 	} else { \
 		DBGLOG(logLevelSemTinyGsmInfo, "### TINY_GSM ### ---> sem available, proceed with code.") \
-		DBGCOD(ms_strncpy(msTinyGsmSemBlockedByFunc, __func__, strlen(__func__), MS_TINY_GSM_SEM_BLOCKEDBY_MAXLEN);) \
-		DBGCOD(ms_strncpy(msTinyGsmSemBlockedByFileName, __FILENAME__, strlen(__FILENAME__), MS_TINY_GSM_SEM_BLOCKEDBY_MAXLEN);) \
-		DBGCOD(msTinyGsmSemBlockedByLineNumber = __LINE__;) \
+		DBGCOD(this->lockScheduler().blockedBy(__func__, __FILENAME__, __LINE__);) \
 
 // End of a block started with [MS_TINY_GSM_SEM_TAKE_WAIT].
 #define MS_TINY_GSM_SEM_GIVE_WAIT \
 	{ \
 		DBGLOG(logLevelSemTinyGsmInfo, "### TINY_GSM ### <--- sem-give.") \
-		DBGCOD(strcpy(msTinyGsmSemBlockedByFunc, "");) \
-		DBGCOD(strcpy(msTinyGsmSemBlockedByFileName, "");) \
-		DBGCOD(msTinyGsmSemBlockedByLineNumber = 0;) \
-		DBGCOD(BaseType_t __r =) \
-    	xSemaphoreGive(msTinyGsmSemProcess); \
-		DBGCHK(Error, __r == pdTRUE, "### TINY_GSM ### <--- sem-give returned error.") \
+		DBGCOD(this->lockScheduler().blockedBy("", "", 0);) \
+		DBGCOD(bool __r =) \
+    	this->lockScheduler().release(); \
+		DBGCHK(Error, __r, "### TINY_GSM ### <--- sem-give returned error.") \
 	} 
 
 // End of a block started with [MS_TINY_GSM_SEM_TAKE_IF_AVAILABLE].
@@ -105,11 +102,21 @@ extern int msTinyGsmSemBlockedByLineNumber;
 		MS_TINY_GSM_SEM_GIVE_WAIT \
 	} 
 
-// Returns true if the semaphore is in use by an other function, 
+// Take the lock of the modem if available, without waiting and without
+// logging; true if taken.  For polling loops, end with [MS_TINY_GSM_SEM_GIVE_WAIT].
+#define MS_TINY_GSM_SEM_TRY_TAKE \
+	(this->lockScheduler().tryAcquire(TINY_GSM_LOCK_SITE))
+
+// Take the lock of the modem like [MS_TINY_GSM_SEM_TAKE_WAIT_CLASS], but
+// waiting at most wait_ms; true if taken.  End with [MS_TINY_GSM_SEM_GIVE_WAIT].
+#define MS_TINY_GSM_SEM_TAKE_WITHIN(cls, mux, wait_ms) \
+	(this->lockScheduler().acquire(cls, mux, wait_ms, TINY_GSM_LOCK_SITE, msTinyGsmSemLogWait))
+
+// Returns true if the lock of the modem is in use by an other function, 
 // or false if it is available.
 // Does not block anything, just checks.
 #define MS_TINY_GSM_SEM_BLOCKED \
-	(uxSemaphoreGetCount(msTinyGsmSemProcess) == 0)
+	(this->lockScheduler().blocked())
 
 
 
@@ -296,4 +303,6 @@ uint32_t TinyGsmAutoBaud(T& SerialAT, uint32_t minimum = 9600,
   return 0;
 }
 
+#include "TinyGsmScheduler.h"
+
 #endif  // SRC_TINYGSMCOMMON_H_
@@ -0,0 +1,348 @@
+/**
+ * @file       TinyGsmCoroutine.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMCOROUTINE_H_
+#define SRC_TINYGSMCOROUTINE_H_
+
+#if !defined(__cpp_impl_coroutine)
+#error TINY_GSM_COROUTINES needs C++20 coroutines (-std=gnu++20 or later)
+#endif
+
+#include "TinyGsmCommon.h"
+#include "TinyGsmATRequest.h"
+#include <atomic>
+#include <coroutine>
+
+// Maximum number of coroutines waiting to be resumed by the event loop.
+#ifndef TINY_GSM_EVENT_LOOP_READY
+#define TINY_GSM_EVENT_LOOP_READY 32
+#endif
+
+/*
+ * Task
+ */
+
+template <typename T>
+class TinyGsmTask;
+
+// Common part of the promise of all tasks: a task starts when it is awaited
+// (or started by the event loop) and resumes its awaiter when it ends.
+class TinyGsmTaskPromiseBase {
+ public:
+  struct FinalAwaiter {
+    bool await_ready() noexcept {
+      return false;
+    }
+    template <class P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+      std::coroutine_handle<> c = h.promise().continuation;
+      return c ? c : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+  };
+
+  std::suspend_always initial_suspend() noexcept {
+    return {};
+  }
+  FinalAwaiter final_suspend() noexcept {
+    return {};
+  }
+  void unhandled_exception() {
+    abort();
+  }
+
+  std::coroutine_handle<> continuation;  /// Resumed when the task ends
+};
+
+template <typename T>
+class TinyGsmTaskPromise : public TinyGsmTaskPromiseBase {
+ public:
+  TinyGsmTask<T> get_return_object();
+  void           return_value(T v) {
+    value = v;
+  }
+  T value{};  /// The co_return value
+};
+
+template <>
+class TinyGsmTaskPromise<void> : public TinyGsmTaskPromiseBase {
+ public:
+  TinyGsmTask<void> get_return_object();
+  void              return_void() {}
+};
+
+/**
+ * @brief The result of a modem coroutine.
+ *
+ * A task does nothing until it is co_awaited by an other coroutine, or
+ * started by the event loop (TinyGsmEventLoop::start()).  The task object
+ * owns the coroutine and must stay alive until the task is done.
+ *
+ * @tparam T The type of the co_return value.
+ */
+template <typename T>
+class TinyGsmTask {
+ public:
+  typedef TinyGsmTaskPromise<T>                promise_type;
+  typedef std::coroutine_handle<promise_type> handle_type;
+
+  explicit TinyGsmTask(handle_type h) : _h(h) {}
+  TinyGsmTask(TinyGsmTask&& other) noexcept : _h(other._h) {
+    other._h = nullptr;
+  }
+  TinyGsmTask(const TinyGsmTask&)            = delete;
+  TinyGsmTask& operator=(const TinyGsmTask&) = delete;
+  ~TinyGsmTask() {
+    if (_h) { _h.destroy(); }
+  }
+
+  bool done() const {
+    return !_h || _h.done();
+  }
+
+  /**
+   * @brief The co_return value, valid once done().
+   */
+  template <typename U = T>
+  typename std::enable_if<!std::is_void<U>::value, U>::type result() const {
+    return _h.promise().value;
+  }
+
+  handle_type handle() const {
+    return _h;
+  }
+
+  /*
+   * Awaiting a task starts it and resumes the awaiter when it ends.
+   */
+  bool await_ready() const {
+    return done();
+  }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) {
+    _h.promise().continuation = awaiter;
+    return _h;
+  }
+  T await_resume() {
+    if constexpr (!std::is_void<T>::value) { return _h.promise().value; }
+  }
+
+ private:
+  handle_type _h;  /// The coroutine
+};
+
+template <typename T>
+inline TinyGsmTask<T> TinyGsmTaskPromise<T>::get_return_object() {
+  return TinyGsmTask<T>(
+      std::coroutine_handle<TinyGsmTaskPromise<T>>::from_promise(*this));
+}
+
+inline TinyGsmTask<void> TinyGsmTaskPromise<void>::get_return_object() {
+  return TinyGsmTask<void>(
+      std::coroutine_handle<TinyGsmTaskPromise<void>>::from_promise(*this));
+}
+
+/*
+ * Event loop
+ */
+
+/**
+ * @brief Resumes modem coroutines when what they wait for has happened.
+ *
+ * runOnce() polls the modem (asynchronous AT commands and URCs, without
+ * blocking), checks the conditions coroutines wait for and resumes the
+ * coroutines which can go on.  All coroutines run in the task calling
+ * runOnce(), so any number of logical flows share that one stack.
+ */
+class TinyGsmEventLoop {
+ public:
+  /**
+   * @brief Polls the modem; returns true if the modem has work pending.
+   */
+  typedef bool (*PollFunction)(void* arg);
+
+  /**
+   * @brief A condition a coroutine waits for, see until().
+   */
+  typedef bool (*Condition)(void* arg);
+
+ private:
+  // A coroutine waiting for a condition, linked into _waiters.
+  struct Waiter {
+    Condition               cond       = nullptr;
+    void*                   arg        = nullptr;
+    uint32_t                start      = 0;
+    uint32_t                timeout_ms = 0;
+    bool                    met        = false;
+    std::coroutine_handle<> h;
+    Waiter*                 next = nullptr;
+  };
+
+ public:
+  TinyGsmEventLoop(PollFunction poll, void* arg) : _poll(poll), _pollArg(arg) {}
+
+  /**
+   * @brief Start a task; it runs at the next runOnce().
+   */
+  template <typename T>
+  void start(TinyGsmTask<T>& task) {
+    if (!task.done()) { post(task.handle()); }
+  }
+
+  /**
+   * @brief Have a coroutine resumed by the next runOnce().  May be called
+   * from an other task (e.g. the rx pump).
+   */
+  void post(std::coroutine_handle<> h) {
+    while (_lock.test_and_set(std::memory_order_acquire)) { TINY_GSM_YIELD(); }
+    if (_count < TINY_GSM_EVENT_LOOP_READY) {
+      _ready[(_first + _count++) % TINY_GSM_EVENT_LOOP_READY] = h;
+    } else {
+      DBGLOG(Error, "[TinyGsmEventLoop] Too many coroutines ready, TINY_GSM_EVENT_LOOP_READY: %i", TINY_GSM_EVENT_LOOP_READY)
+    }
+    _lock.clear(std::memory_order_release);
+  }
+
+  /**
+   * @brief Poll the modem and resume all coroutines which can go on.
+   *
+   * @return *true* Coroutines are waiting or the modem has work pending.
+   * @return *false* Nothing to do.
+   */
+  bool runOnce() {
+    bool busy = _poll ? _poll(_pollArg) : false;
+
+    uint32_t now = millis();
+    for (Waiter** w = &_waiters; *w;) {
+      Waiter* waiter = *w;
+      bool    met    = waiter->cond && waiter->cond(waiter->arg);
+      if (met || now - waiter->start >= waiter->timeout_ms) {
+        waiter->met = met;
+        *w          = waiter->next;
+        post(waiter->h);
+      } else {
+        w = &waiter->next;
+      }
+    }
+
+    // Only the ones ready now, coroutines posted meanwhile wait for the
+    // next round.
+    for (uint8_t n = _count; n > 0; n--) {
+      std::coroutine_handle<> h = pop();
+      if (h) { h.resume(); }
+    }
+    return busy || _waiters != nullptr || _count > 0;
+  }
+
+  /*
+   * Awaitables
+   */
+
+  // Resumes the coroutine when cond(arg) is true or the timeout passed.
+  class Until {
+   public:
+    Until(TinyGsmEventLoop& loop, Condition cond, void* arg,
+          uint32_t timeout_ms)
+        : _loop(loop) {
+      _w.cond       = cond;
+      _w.arg        = arg;
+      _w.timeout_ms = timeout_ms;
+    }
+    bool await_ready() {
+      return _w.cond && _w.cond(_w.arg);
+    }
+    void await_suspend(std::coroutine_handle<> h) {
+      _w.h     = h;
+      _w.start = millis();
+      _w.next  = _loop._waiters;
+      _loop._waiters = &_w;
+    }
+    // true if the condition is met, false on timeout
+    bool await_resume() {
+      return _w.cond && (_w.met || _w.cond(_w.arg));
+    }
+
+   private:
+    TinyGsmEventLoop& _loop;
+    Waiter            _w;
+  };
+
+  /**
+   * @brief co_await loop.until(cond, arg, timeout_ms): wait until cond(arg)
+   * is true; returns false if the timeout passed first.
+   */
+  Until until(Condition cond, void* arg, uint32_t timeout_ms) {
+    return Until(*this, cond, arg, timeout_ms);
+  }
+
+  /**
+   * @brief co_await loop.sleep(ms): let the other coroutines run for a while.
+   */
+  Until sleep(uint32_t timeout_ms) {
+    return Until(*this, nullptr, nullptr, timeout_ms);
+  }
+
+ private:
+  std::coroutine_handle<> pop() {
+    std::coroutine_handle<> h;
+    while (_lock.test_and_set(std::memory_order_acquire)) { TINY_GSM_YIELD(); }
+    if (_count) {
+      h      = _ready[_first];
+      _first = (_first + 1) % TINY_GSM_EVENT_LOOP_READY;
+      _count--;
+    }
+    _lock.clear(std::memory_order_release);
+    return h;
+  }
+
+  PollFunction            _poll;                              /// Polls the modem
+  void*                   _pollArg;                           /// Argument of _poll
+  std::coroutine_handle<> _ready[TINY_GSM_EVENT_LOOP_READY];  /// To resume
+  uint8_t                 _first   = 0;                       /// First in _ready
+  std::atomic<uint8_t>    _count{0};                          /// Number in _ready
+  std::atomic_flag        _lock    = ATOMIC_FLAG_INIT;        /// Guards _ready
+  Waiter*                 _waiters = nullptr;                 /// Waiting for a condition
+};
+
+/**
+ * @brief co_await on an asynchronous AT command, see TinyGsmModem::atAsync().
+ * Returns the result of the request, or -1 if it could not be submitted.
+ */
+template <class modemType>
+class TinyGsmATAwaiter {
+ public:
+  TinyGsmATAwaiter(modemType& modem, TinyGsmEventLoop& loop,
+                   TinyGsmATRequest& req)
+      : _modem(modem), _loop(loop), _req(req) {}
+
+  bool await_ready() {
+    return false;
+  }
+  bool await_suspend(std::coroutine_handle<> h) {
+    _h = h;
+    _req.onDone(done, this);
+    _submitted = _modem.submitAT(_req);
+    return _submitted;
+  }
+  int8_t await_resume() {
+    return _submitted ? _req.result() : -1;
+  }
+
+ private:
+  static void done(TinyGsmATRequest&, void* arg) {
+    TinyGsmATAwaiter* a = static_cast<TinyGsmATAwaiter*>(arg);
+    a->_loop.post(a->_h);
+  }
+
+  modemType&              _modem;
+  TinyGsmEventLoop&       _loop;
+  TinyGsmATRequest&       _req;
+  std::coroutine_handle<> _h;
+  bool                    _submitted = false;
+};
+
+#endif  // SRC_TINYGSMCOROUTINE_H_
@@ -0,0 +1,74 @@
+/**
+ * @file       TinyGsmDeadline.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMDEADLINE_H_
+#define SRC_TINYGSMDEADLINE_H_
+
+#include "TinyGsmCommon.h"
+
+/**
+ * @brief The point in time an operation has to be done by, e.g. a connect
+ * with all its commands.  A default constructed deadline never passes.
+ *
+ * @code
+ * TinyGsmDeadline deadline(75000L);
+ * waitResponse(deadline.cap(60000L));   // at most 60 s, and not beyond
+ * if (deadline.expired()) { ... }
+ * @endcode
+ */
+class TinyGsmDeadline {
+ public:
+  TinyGsmDeadline() {}
+
+  /**
+   * @brief A deadline timeout_ms from now.
+   */
+  explicit TinyGsmDeadline(uint32_t timeout_ms)
+      : _start(millis()), _timeout(timeout_ms), _set(true) {}
+
+  /**
+   * @brief Check if the deadline is set at all.
+   */
+  bool set() const {
+    return _set;
+  }
+
+  /**
+   * @brief The time left; UINT32_MAX if not set.
+   */
+  uint32_t remaining() const {
+    if (!_set) { return UINT32_MAX; }
+    uint32_t elapsed = millis() - _start;
+    return elapsed >= _timeout ? 0 : _timeout - elapsed;
+  }
+
+  bool expired() const {
+    return _set && remaining() == 0;
+  }
+
+  /**
+   * @brief timeout_ms, but not beyond the deadline.
+   */
+  uint32_t cap(uint32_t timeout_ms) const {
+    return TinyGsmMin(timeout_ms, remaining());
+  }
+
+  /**
+   * @brief The earlier of both deadlines.
+   */
+  const TinyGsmDeadline& earlier(const TinyGsmDeadline& other) const {
+    return other.remaining() < remaining() ? other : *this;
+  }
+
+ private:
+  uint32_t _start   = 0;      /// millis() when set
+  uint32_t _timeout = 0;      /// ms from _start
+  bool     _set     = false;  /// false: never passes
+};
+
+#endif  // SRC_TINYGSMDEADLINE_H_
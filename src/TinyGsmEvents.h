@@ -0,0 +1,117 @@
+/**
+ * @file       TinyGsmEvents.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMEVENTS_H_
+#define SRC_TINYGSMEVENTS_H_
+
+#include "TinyGsmCommon.h"
+#include <atomic>
+
+// Text kept with an event (network time, unknown URC, ...).
+#ifndef TINY_GSM_EVENT_TEXT_SIZE
+#define TINY_GSM_EVENT_TEXT_SIZE 40
+#endif
+
+/**
+ * @brief What a TinyGsmEvent tells.
+ */
+enum TinyGsmEventType : uint8_t {
+  TINY_GSM_EVENT_NONE            = 0,
+  TINY_GSM_EVENT_SOCKET_CLOSED   = 1,  /// mux: the socket closed by the modem
+  TINY_GSM_EVENT_NETWORK_TIME    = 2,  /// text: time and time zone by network
+  TINY_GSM_EVENT_TIME_ZONE       = 3,  /// text: time zone by network
+  TINY_GSM_EVENT_DAYLIGHT_SAVING = 4,  /// value: 0 standard, 1 daylight saving
+  TINY_GSM_EVENT_NETWORK_NAME    = 5,  /// text: network name by network
+  TINY_GSM_EVENT_MODEM_RESET     = 6,  /// The modem restarted on its own
+  TINY_GSM_EVENT_UNKNOWN_URC     = 7,  /// text: a line nobody expected
+};
+
+/**
+ * @brief An event published by the URC handlers, see TinyGsmModem::pollEvent().
+ */
+struct TinyGsmEvent {
+  TinyGsmEventType type  = TINY_GSM_EVENT_NONE;
+  uint8_t          mux   = 0xFF;  /// Socket, if any
+  int16_t          value = 0;     /// Numeric parameter, if any
+  char             text[TINY_GSM_EVENT_TEXT_SIZE] = {};  /// Text parameter, if any
+};
+
+/**
+ * @brief Bounded single-producer/single-consumer queue of events.
+ *
+ * The producer is whoever handles the URCs; that always happens with the
+ * modem locked, so there is only ever one producer at a time.  The consumer
+ * is the application.  If the queue is full, new events are dropped and
+ * counted.
+ *
+ * @tparam N The number of events the queue holds.
+ */
+template <size_t N>
+class TinyGsmEventQueue {
+ public:
+  bool push(const TinyGsmEvent& ev) {
+    size_t w    = _w.load(std::memory_order_relaxed);
+    size_t next = (w + 1) % (N + 1);
+    if (next == _r.load(std::memory_order_acquire)) {
+      _dropped++;
+      return false;
+    }
+    _q[w] = ev;
+    _w.store(next, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(TinyGsmEvent& ev) {
+    size_t r = _r.load(std::memory_order_relaxed);
+    if (r == _w.load(std::memory_order_acquire)) { return false; }
+    ev = _q[r];
+    _r.store((r + 1) % (N + 1), std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return _r.load(std::memory_order_acquire) ==
+        _w.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief The number of events dropped because the queue was full.
+   */
+  uint32_t dropped() const {
+    return _dropped;
+  }
+
+ private:
+  TinyGsmEvent          _q[N + 1];     /// One slot stays empty
+  std::atomic<size_t>   _r{0};         /// Read position
+  std::atomic<size_t>   _w{0};         /// Write position
+  std::atomic<uint32_t> _dropped{0};   /// Events lost
+};
+
+/**
+ * @brief A URC handler of the application, see TinyGsmModem::addURCHandler().
+ *
+ * @param params The rest of the URC line behind the prefix, without the line
+ * end.
+ * @param arg The argument given with the handler.
+ * @return *true* The URC was handled.
+ */
+typedef bool (*TinyGsmURCHandler)(const char* params, void* arg);
+
+/**
+ * @brief One entry of the URC table of a modem: the prefix of the URC and the
+ * member function handling it.  The handler reads the parameters of the URC
+ * from the stream itself.
+ */
+template <class modemType>
+struct TinyGsmURCEntry {
+  GsmConstStr prefix;
+  bool (modemType::*handler)();
+};
+
+#endif  // SRC_TINYGSMEVENTS_H_
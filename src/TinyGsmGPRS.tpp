@@ -10,9 +10,19 @@
 #define SRC_TINYGSMGPRS_H_
 
 #include "TinyGsmCommon.h"
+#include "TinyGsmResult.h"
 
 #define TINY_GSM_MODEM_HAS_GPRS
 
+// Default time budget of gprsConnect() and gprsDisconnect(), in ms.
+#ifndef TINY_GSM_GPRS_CONNECT_TIMEOUT_MS
+#define TINY_GSM_GPRS_CONNECT_TIMEOUT_MS 180000L
+#endif
+
+#ifndef TINY_GSM_GPRS_DISCONNECT_TIMEOUT_MS
+#define TINY_GSM_GPRS_DISCONNECT_TIMEOUT_MS 120000L
+#endif
+
 enum SimStatus {
   SIM_ERROR            = 0,
   SIM_READY            = 1,
@@ -47,9 +57,10 @@ class TinyGsmGPRS {
   String getSimCCID() {
     String s;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
-    s = thisModem().getSimCCIDImpl();
+    if (!thisModem().identity.ccid.length()) { thisModem().identity.ccid = thisModem().getSimCCIDImpl(); }
+    s = thisModem().identity.ccid;
 
     MS_TINY_GSM_SEM_GIVE_WAIT
 
@@ -61,9 +72,10 @@ class TinyGsmGPRS {
   String getIMEI() {
     String s;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
-    s = thisModem().getIMEIImpl();
+    if (!thisModem().identity.imei.length()) { thisModem().identity.imei = thisModem().getIMEIImpl(); }
+    s = thisModem().identity.imei;
 
     MS_TINY_GSM_SEM_GIVE_WAIT
 
@@ -75,9 +87,10 @@ class TinyGsmGPRS {
   String getIMSI() {
     String s;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
-    s = thisModem().getIMSIImpl();
+    if (!thisModem().identity.imsi.length()) { thisModem().identity.imsi = thisModem().getIMSIImpl(); }
+    s = thisModem().identity.imsi;
 
     MS_TINY_GSM_SEM_GIVE_WAIT
 
@@ -100,13 +113,34 @@ class TinyGsmGPRS {
   /*
    * GPRS functions
    */
-  bool gprsConnect(const char* apn, const char* user = nullptr,
-                   const char* pwd = nullptr) {
-    return thisModem().gprsConnectImpl(apn, user, pwd);
+  // All steps together take timeout_ms at most.  The result tells why the
+  // connect failed: timeout, ERROR or the error code of the modem.
+  // The steps waiting for a URC (e.g. the activation of the PDP context)
+  // let other callers have the modem in between, but a command answering
+  // only when done keeps it locked: the attach (+CGATT=1) may take up to
+  // 60 s, and all other users of the modem, socket I/O included, wait for
+  // it meanwhile.  Connect before the sockets are busy.
+  TinyGsmResult gprsConnect(const char* apn, const char* user = nullptr,
+                            const char* pwd        = nullptr,
+                            uint32_t    timeout_ms = TINY_GSM_GPRS_CONNECT_TIMEOUT_MS) {
+    return thisModem().gprsConnectImpl(apn, user, pwd, timeout_ms);
+  }
+  TinyGsmResult gprsDisconnect(uint32_t timeout_ms = TINY_GSM_GPRS_DISCONNECT_TIMEOUT_MS) {
+    return thisModem().gprsDisconnectImpl(timeout_ms);
   }
-  bool gprsDisconnect() {
-    return thisModem().gprsDisconnectImpl();
+#if defined TINY_GSM_COROUTINES
+  // co_await modem.gprsConnectAsync(apn): like gprsConnect(), resumed by the
+  // event loop of the modem (see TinyGsmModem::eventLoop()), within the same
+  // time budget.  The strings must stay valid until the task is done.
+  TinyGsmTask<bool> gprsConnectAsync(const char* apn, const char* user = nullptr,
+                                     const char* pwd        = nullptr,
+                                     uint32_t    timeout_ms = TINY_GSM_GPRS_CONNECT_TIMEOUT_MS) {
+    return thisModem().gprsConnectAsyncImpl(apn, user, pwd, timeout_ms);
   }
+  TinyGsmTask<bool> gprsDisconnectAsync(uint32_t timeout_ms = TINY_GSM_GPRS_DISCONNECT_TIMEOUT_MS) {
+    return thisModem().gprsDisconnectAsyncImpl(timeout_ms);
+  }
+#endif
   // Checks if current attached to GPRS/EPS service
   bool isGprsConnected() {
     return thisModem().isGprsConnectedImpl();
@@ -115,7 +149,7 @@ class TinyGsmGPRS {
   String getOperator() {
     String o;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     o = thisModem().getOperatorImpl();
 
@@ -128,7 +162,7 @@ class TinyGsmGPRS {
   String getProvider() {
     String p;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     p = thisModem().getProviderImpl();
 
@@ -146,6 +180,10 @@ class TinyGsmGPRS {
   inline modemType& thisModem() {
     return static_cast<modemType&>(*this);
   }
+  // The lock of the modem, for the MS_TINY_GSM_SEM_* macros
+  inline TinyGsmScheduler& lockScheduler() {
+    return thisModem().lockScheduler();
+  }
   ~TinyGsmGPRS() {}
 
   /* =========================================== */
@@ -183,7 +221,7 @@ class TinyGsmGPRS {
     thisModem().sendAT(GF("+GSN"));
     thisModem().streamSkipUntil('\n');  // skip first newline
     String res = thisModem().stream.readStringUntil('\n');
-    thisModem().waitResponse();
+    if (thisModem().waitResponse() != 1) { return ""; }
     res.trim();
     return res;
   }
@@ -194,7 +232,7 @@ class TinyGsmGPRS {
     thisModem().sendAT(GF("+CIMI"));
     thisModem().streamSkipUntil('\n');  // skip first newline
     String res = thisModem().stream.readStringUntil('\n');
-    thisModem().waitResponse();
+    if (thisModem().waitResponse() != 1) { return ""; }
     res.trim();
     return res;
   }
@@ -27,7 +27,7 @@ class TinyGsmGSMLocation {
   String getGsmLocationRaw() {
     String s;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     s = thisModem().getGsmLocationRawImpl();
 
@@ -39,7 +39,7 @@ class TinyGsmGSMLocation {
   String getGsmLocation() {
     String s;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     s = thisModem().getGsmLocationRawImpl();
 
@@ -53,7 +53,7 @@ class TinyGsmGSMLocation {
                       int* hour = 0, int* minute = 0, int* second = 0) {
     bool b = false;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     b = thisModem().getGsmLocationImpl(lat, lon, accuracy, year, month, day,
                                           hour, minute, second);
@@ -84,6 +84,10 @@ class TinyGsmGSMLocation {
   inline modemType& thisModem() {
     return static_cast<modemType&>(*this);
   }
+  // The lock of the modem, for the MS_TINY_GSM_SEM_* macros
+  inline TinyGsmScheduler& lockScheduler() {
+    return thisModem().lockScheduler();
+  }
   ~TinyGsmGSMLocation() {}
 
   /* =========================================== */
@@ -0,0 +1,253 @@
+/**
+ * @file       TinyGsmLatency.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMLATENCY_H_
+#define SRC_TINYGSMLATENCY_H_
+
+#include "TinyGsmCommon.h"
+
+// Number of commands whose latency is kept; the least used one makes room.
+#ifndef TINY_GSM_LATENCY_COMMANDS
+#define TINY_GSM_LATENCY_COMMANDS 32
+#endif
+
+// 0: only observe the latency, keep the timeouts given in the code.  1: wait
+// for a command only as long as learned.  A network bound command (attach,
+// +CNACT, +CAOPEN) slower than learned then fails at the caller while the
+// modem goes on with it, so learning is off by default.
+#ifndef TINY_GSM_LATENCY_LEARN
+#define TINY_GSM_LATENCY_LEARN 0
+#endif
+
+// Responses of a command needed before its timeout is learned.
+#ifndef TINY_GSM_LATENCY_MIN_SAMPLES
+#define TINY_GSM_LATENCY_MIN_SAMPLES 20
+#endif
+
+// The percentile of the latency the timeout is derived from.
+#ifndef TINY_GSM_LATENCY_PERCENTILE
+#define TINY_GSM_LATENCY_PERCENTILE 99
+#endif
+
+// Learned timeout: TINY_GSM_LATENCY_FACTOR times the percentile plus
+// TINY_GSM_LATENCY_MARGIN_MS, at least TINY_GSM_LATENCY_MIN_TIMEOUT_MS.
+#ifndef TINY_GSM_LATENCY_FACTOR
+#define TINY_GSM_LATENCY_FACTOR 2
+#endif
+
+#ifndef TINY_GSM_LATENCY_MARGIN_MS
+#define TINY_GSM_LATENCY_MARGIN_MS 1000
+#endif
+
+#ifndef TINY_GSM_LATENCY_MIN_TIMEOUT_MS
+#define TINY_GSM_LATENCY_MIN_TIMEOUT_MS 1000
+#endif
+
+// Samples per command after which the old ones are halved, so the
+// distribution follows a change of the network or the firmware.
+#ifndef TINY_GSM_LATENCY_WINDOW
+#define TINY_GSM_LATENCY_WINDOW 512
+#endif
+
+// Characters of a command name kept to tell the commands apart.
+#ifndef TINY_GSM_LATENCY_NAME_SIZE
+#define TINY_GSM_LATENCY_NAME_SIZE 24
+#endif
+
+/**
+ * @brief The observed latency of the AT commands, and the timeouts learned
+ * from it.
+ *
+ * A command is identified by its text up to its first variable argument,
+ * i.e. the first part given to sendAT(), e.g. "+CAOPEN=" or "+CNACT=0,1":
+ * all calls of a command share one distribution, while +CNACT=0,1 (network
+ * bound) and +CNACT=0,0 do not.  A command sent as one text (of a batch, or
+ * submitted) is identified by its first TINY_GSM_LATENCY_NAME_SIZE
+ * characters.
+ * The latency is kept in a histogram with buckets of powers of 2 ms.  With
+ * TINY_GSM_LATENCY_LEARN 1, once a command answered
+ * TINY_GSM_LATENCY_MIN_SAMPLES times, its timeout is the upper bound of the
+ * TINY_GSM_LATENCY_PERCENTILE bucket times TINY_GSM_LATENCY_FACTOR plus
+ * TINY_GSM_LATENCY_MARGIN_MS - but never longer than the timeout given in
+ * the code, which stays the worst case.  A command
+ * timing out after a learned timeout counts as slower than that, so the
+ * timeout grows again if the modem really got slower.
+ *
+ * The table is plain data, it can be saved with save() and loaded with load()
+ * to keep it across reboots.
+ */
+class TinyGsmLatency {
+ public:
+  static constexpr uint8_t buckets = 18;  /// Up to 2^17 ms
+
+  /**
+   * @brief The key of a command.
+   *
+   * @param cmd The name of the command without "AT", see above.
+   */
+  static uint32_t key(const char* cmd, size_t len) {
+    uint32_t h = 2166136261UL;  // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+      h = (h ^ static_cast<uint8_t>(cmd[i])) * 16777619UL;
+    }
+    return h;
+  }
+
+  /**
+   * @brief The timeout for the command: the learned one if there is one and
+   * it is shorter, otherwise timeout_ms.
+   */
+  uint32_t timeout(uint32_t key, uint32_t timeout_ms) const {
+#if !TINY_GSM_LATENCY_LEARN
+    return timeout_ms;
+#endif
+    const Entry* e = find(key);
+    if (e == nullptr || e->total() < TINY_GSM_LATENCY_MIN_SAMPLES) {
+      return timeout_ms;
+    }
+
+    uint32_t need = (e->total() * TINY_GSM_LATENCY_PERCENTILE + 99) / 100;
+    uint32_t sum  = 0;
+    uint8_t  b    = 0;
+    for (; b < buckets - 1; b++) {
+      sum += e->counts[b];
+      if (sum >= need) { break; }
+    }
+    uint32_t learned = (1UL << b) * TINY_GSM_LATENCY_FACTOR +
+        TINY_GSM_LATENCY_MARGIN_MS;
+    learned = TinyGsmMax(learned, static_cast<uint32_t>(TINY_GSM_LATENCY_MIN_TIMEOUT_MS));
+    return TinyGsmMin(learned, timeout_ms);
+  }
+
+  /**
+   * @brief The command answered after latency_ms.
+   */
+  void record(uint32_t key, uint32_t latency_ms) {
+    add(key, bucket(latency_ms), 1);
+  }
+
+  /**
+   * @brief The command did not answer within the learned timeout_ms: count
+   * it as slower than that, with enough weight to move the percentile.
+   */
+  void recordTimeout(uint32_t key, uint32_t timeout_ms) {
+    Entry* e = find(key);
+    if (e == nullptr) { return; }
+    uint32_t n = TinyGsmMax(static_cast<uint32_t>(1),
+        e->total() * (100 - TINY_GSM_LATENCY_PERCENTILE) / 100 + 1);
+    uint8_t b = bucket(timeout_ms);
+    if (b < buckets - 1) { b++; }
+    add(key, b, static_cast<uint16_t>(TinyGsmMin(n, static_cast<uint32_t>(UINT16_MAX))));
+  }
+
+  /**
+   * @brief Forget everything learned.
+   */
+  void clear() {
+    memset(_entries, 0, sizeof(_entries));
+  }
+
+  /**
+   * @brief The size of the data save() writes.
+   */
+  static constexpr size_t saveSize() {
+    return sizeof(Header) + sizeof(_entries);
+  }
+
+  /**
+   * @brief Write the table into buf, e.g. to keep it in NVS.
+   *
+   * @return The number of bytes written, 0 if buf is too small.
+   */
+  size_t save(uint8_t* buf, size_t len) const {
+    if (buf == nullptr || len < saveSize()) { return 0; }
+    Header h;
+    memcpy(buf, &h, sizeof(h));
+    memcpy(buf + sizeof(h), _entries, sizeof(_entries));
+    return saveSize();
+  }
+
+  /**
+   * @brief Read a table written by save().
+   *
+   * @return *false* The data is not a table of this build; nothing changed.
+   */
+  bool load(const uint8_t* buf, size_t len) {
+    Header h;
+    if (buf == nullptr || len != saveSize() ||
+        memcmp(buf, &h, sizeof(h)) != 0) {
+      return false;
+    }
+    memcpy(_entries, buf + sizeof(h), sizeof(_entries));
+    return true;
+  }
+
+ private:
+  struct Entry {
+    uint32_t key;
+    uint16_t counts[buckets];
+
+    uint32_t total() const {
+      uint32_t t = 0;
+      for (uint8_t b = 0; b < buckets; b++) { t += counts[b]; }
+      return t;
+    }
+  };
+
+  // Tells the data of save() from anything else, including a table with
+  // other dimensions.
+  struct Header {
+    char     magic[4] = {'T', 'G', 'L', '2'};
+    uint16_t commands = TINY_GSM_LATENCY_COMMANDS;
+    uint16_t nBuckets = buckets;
+  };
+
+  // 0: 0 ms, b: [2^(b-1), 2^b) ms
+  static uint8_t bucket(uint32_t ms) {
+    uint8_t b = 0;
+    while (ms && b < buckets - 1) {
+      ms >>= 1;
+      b++;
+    }
+    return b;
+  }
+
+  const Entry* find(uint32_t key) const {
+    for (const Entry& e : _entries) {
+      if (e.key == key && key != 0) { return &e; }
+    }
+    return nullptr;
+  }
+
+  Entry* find(uint32_t key) {
+    return const_cast<Entry*>(static_cast<const TinyGsmLatency*>(this)->find(key));
+  }
+
+  void add(uint32_t key, uint8_t b, uint16_t n) {
+    if (key == 0) { return; }
+    Entry* e = find(key);
+    if (e == nullptr) {
+      // A free entry, or the least used one
+      e = &_entries[0];
+      for (Entry& c : _entries) {
+        if (c.total() < e->total()) { e = &c; }
+      }
+      memset(e, 0, sizeof(*e));
+      e->key = key;
+    }
+    if (e->total() + n > TINY_GSM_LATENCY_WINDOW ||
+        e->counts[b] > UINT16_MAX - n) {
+      for (uint16_t& c : e->counts) { c /= 2; }
+    }
+    e->counts[b] += n;
+  }
+
+  Entry _entries[TINY_GSM_LATENCY_COMMANDS] = {};  /// key 0: free
+};
+
+#endif  // SRC_TINYGSMLATENCY_H_
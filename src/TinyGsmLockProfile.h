@@ -0,0 +1,134 @@
+/**
+ * @file       TinyGsmLockProfile.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMLOCKPROFILE_H_
+#define SRC_TINYGSMLOCKPROFILE_H_
+
+#include "TinyGsmCommon.h"
+#include <atomic>
+
+// 0: the MS_TINY_GSM_SEM_* macros do not count per call site.
+#ifndef TINY_GSM_LOCK_PROFILE
+#define TINY_GSM_LOCK_PROFILE 1
+#endif
+
+/**
+ * @brief What the modem lock costs at one call site, see TinyGsmLockSite.
+ */
+struct TinyGsmLockStats {
+  const char* func         = nullptr;  /// Function taking the lock
+  const char* file         = nullptr;  /// Its source file
+  int         line         = 0;        /// Line of the MS_TINY_GSM_SEM_TAKE_* macro
+  uint32_t    acquisitions = 0;        /// Times the lock was taken here
+  uint32_t    contended    = 0;        /// Of those, times it had to wait
+  uint32_t    waitTotal_ms = 0;        /// Time waited for the lock
+  uint32_t    waitMax_ms   = 0;        /// Longest wait
+  uint32_t    holdTotal_ms = 0;        /// Time the lock was held
+  uint32_t    holdMax_ms   = 0;        /// Longest hold
+};
+
+/**
+ * @brief Order of TinyGsmScheduler::topContenders().
+ */
+enum TinyGsmLockOrder : uint8_t {
+  TINY_GSM_LOCK_BY_WAIT_TOTAL = 0,  /// Who waited longest in sum
+  TINY_GSM_LOCK_BY_WAIT_MAX   = 1,  /// Who waited longest once
+  TINY_GSM_LOCK_BY_HOLD_TOTAL = 2,  /// Who kept the others waiting in sum
+  TINY_GSM_LOCK_BY_HOLD_MAX   = 3,  /// Who kept the others waiting longest once
+};
+
+/**
+ * @brief One place taking the modem lock; each MS_TINY_GSM_SEM_TAKE_* macro
+ * has its own, created on first use (TINY_GSM_LOCK_SITE).  All sites are
+ * kept in one list for TinyGsmScheduler::topContenders().  A site is shared
+ * by all modems, so the counters are atomic.
+ */
+class TinyGsmLockSite {
+ public:
+  TinyGsmLockSite(const char* func, const char* file, int line)
+      : func(func), file(file), line(line) {
+    next = head().load(std::memory_order_relaxed);
+    while (!head().compare_exchange_weak(next, this,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {}
+  }
+
+  TinyGsmLockSite(const TinyGsmLockSite&)            = delete;
+  TinyGsmLockSite& operator=(const TinyGsmLockSite&) = delete;
+
+  void waited(uint32_t wait_ms, bool contended) {
+    acquisitions.fetch_add(1, std::memory_order_relaxed);
+    if (contended) { this->contended.fetch_add(1, std::memory_order_relaxed); }
+    waitTotal_ms.fetch_add(wait_ms, std::memory_order_relaxed);
+    raise(waitMax_ms, wait_ms);
+  }
+
+  void held(uint32_t hold_ms) {
+    holdTotal_ms.fetch_add(hold_ms, std::memory_order_relaxed);
+    raise(holdMax_ms, hold_ms);
+  }
+
+  /**
+   * @brief A copy of the counters.
+   */
+  TinyGsmLockStats stats() const {
+    TinyGsmLockStats s;
+    s.func         = func;
+    s.file         = file;
+    s.line         = line;
+    s.acquisitions = acquisitions.load(std::memory_order_relaxed);
+    s.contended    = contended.load(std::memory_order_relaxed);
+    s.waitTotal_ms = waitTotal_ms.load(std::memory_order_relaxed);
+    s.waitMax_ms   = waitMax_ms.load(std::memory_order_relaxed);
+    s.holdTotal_ms = holdTotal_ms.load(std::memory_order_relaxed);
+    s.holdMax_ms   = holdMax_ms.load(std::memory_order_relaxed);
+    return s;
+  }
+
+  void reset() {
+    acquisitions = 0;
+    contended    = 0;
+    waitTotal_ms = 0;
+    waitMax_ms   = 0;
+    holdTotal_ms = 0;
+    holdMax_ms   = 0;
+  }
+
+  static std::atomic<TinyGsmLockSite*>& head() {
+    static std::atomic<TinyGsmLockSite*> h{nullptr};
+    return h;
+  }
+
+  const char*           func;                /// Function taking the lock
+  const char*           file;                /// Its source file
+  int                   line;                /// Line of the macro
+  std::atomic<uint32_t> acquisitions{0};     /// See TinyGsmLockStats
+  std::atomic<uint32_t> contended{0};
+  std::atomic<uint32_t> waitTotal_ms{0};
+  std::atomic<uint32_t> waitMax_ms{0};
+  std::atomic<uint32_t> holdTotal_ms{0};
+  std::atomic<uint32_t> holdMax_ms{0};
+  TinyGsmLockSite*      next = nullptr;      /// Next site in the list
+
+ private:
+  static void raise(std::atomic<uint32_t>& max, uint32_t v) {
+    uint32_t cur = max.load(std::memory_order_relaxed);
+    while (v > cur && !max.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+  }
+};
+
+// The site of the macro it is expanded in; the lambda gives every expansion
+// its own static, also where a declaration is not possible.
+#if TINY_GSM_LOCK_PROFILE
+#define TINY_GSM_LOCK_SITE \
+  ([](const char* f) { static TinyGsmLockSite s(f, __FILE__, __LINE__); return &s; }(__func__))
+#else
+#define TINY_GSM_LOCK_SITE (static_cast<TinyGsmLockSite*>(nullptr))
+#endif
+
+#endif  // SRC_TINYGSMLOCKPROFILE_H_
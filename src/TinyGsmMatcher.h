@@ -0,0 +1,158 @@
+/**
+ * @file       TinyGsmMatcher.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMMATCHER_H_
+#define SRC_TINYGSMMATCHER_H_
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Multi-pattern "ends with" matcher (Aho-Corasick automaton).
+ *
+ * All patterns are compiled into one deterministic automaton, so every
+ * received character costs exactly one table lookup, independent of the
+ * number and the length of the patterns.  feed() reports the id of the
+ * pattern the input seen since the last reset() now ends with; if several
+ * patterns match at the same position the lowest id wins, which gives the
+ * same priority order as a chain of endsWith() checks.
+ *
+ * Characters are mapped to classes first (only characters used in any
+ * pattern get their own class), which keeps the transition table small.
+ *
+ * @tparam maxStates  Maximum number of trie nodes (sum of pattern lengths + 1
+ * is always enough), at most 255.
+ * @tparam maxClasses Maximum number of distinct characters in all patterns + 1.
+ */
+template <uint8_t maxStates, uint8_t maxClasses>
+class TinyGsmMatcher {
+ public:
+  TinyGsmMatcher() {
+    clear();
+  }
+
+  /**
+   * @brief Remove all patterns.
+   */
+  void clear() {
+    memset(_cls, 0, sizeof(_cls));
+    memset(_next, 0, sizeof(_next));
+    memset(_out, 0, sizeof(_out));
+    _nStates = 1;
+    _nCls    = 1;
+    _s       = 0;
+    _valid   = true;
+  }
+
+  /**
+   * @brief Add a pattern.  build() has to be called after the last pattern
+   * has been added.
+   *
+   * @param pattern The zero terminated pattern, empty or nullptr is ignored.
+   * @param id The id reported by feed() when the pattern matches, must be > 0.
+   * @return *true* The pattern was added.
+   * @return *false* The capacity of the matcher is exceeded; the matcher is
+   * invalid until the next clear().
+   */
+  bool add(const char* pattern, int8_t id) {
+    if (pattern == nullptr || *pattern == '\0' || id <= 0) { return true; }
+    uint8_t s = 0;
+    for (const char* p = pattern; *p; p++) {
+      uint8_t c = static_cast<uint8_t>(*p);
+      if (_cls[c] == 0) {
+        if (_nCls >= maxClasses) { _valid = false; return false; }
+        _cls[c] = _nCls++;
+      }
+      uint8_t k = _cls[c];
+      if (_next[s][k] == 0) {
+        if (_nStates >= maxStates) { _valid = false; return false; }
+        _next[s][k] = _nStates++;
+      }
+      s = _next[s][k];
+    }
+    _out[s] = best(_out[s], id);
+    return true;
+  }
+
+  /**
+   * @brief Compute the failure transitions and complete the transition table.
+   */
+  void build() {
+    uint8_t fail[maxStates];
+    uint8_t queue[maxStates];
+    uint8_t head = 0;
+    uint8_t tail = 0;
+
+    fail[0] = 0;
+    for (uint8_t k = 1; k < _nCls; k++) {
+      uint8_t u = _next[0][k];
+      if (u) {
+        fail[u]       = 0;
+        queue[tail++] = u;
+      }
+    }
+    while (head < tail) {
+      uint8_t s = queue[head++];
+      for (uint8_t k = 1; k < _nCls; k++) {
+        uint8_t u = _next[s][k];
+        if (u) {
+          // Trie child: its failure state is where the failure state of the
+          // parent goes with the same character.
+          fail[u]       = _next[fail[s]][k];
+          _out[u]       = best(_out[u], _out[fail[u]]);
+          queue[tail++] = u;
+        } else {
+          _next[s][k] = _next[fail[s]][k];
+        }
+      }
+    }
+    _s = 0;
+  }
+
+  /**
+   * @brief Restart matching, i.e. forget all characters fed so far.
+   */
+  void reset() {
+    _s = 0;
+  }
+
+  /**
+   * @brief Advance the automaton by one character.
+   *
+   * @param c The received character.
+   * @return *int8_t* The id of the matching pattern, or 0 if none matches.
+   */
+  int8_t feed(char c) {
+    _s = _next[_s][_cls[static_cast<uint8_t>(c)]];
+    return _out[_s];
+  }
+
+  /**
+   * @brief Check if all patterns fitted into the matcher.
+   */
+  bool valid() const {
+    return _valid;
+  }
+
+ private:
+  static int8_t best(int8_t a, int8_t b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+    return (a < b) ? a : b;
+  }
+
+  uint8_t _cls[256];                     /// Character to class
+  uint8_t _next[maxStates][maxClasses];  /// Transitions, class 0 = unused char
+  int8_t  _out[maxStates];               /// Pattern id matching in a state
+  uint8_t _nStates;                      /// Number of used states
+  uint8_t _nCls;                         /// Number of used classes
+  uint8_t _s;                            /// The current state
+  bool    _valid;                        /// All patterns fitted
+};
+
+#endif  // SRC_TINYGSMMATCHER_H_
@@ -10,6 +10,27 @@
 #define SRC_TINYGSMMODEM_H_
 
 #include "TinyGsmCommon.h"
+#include "TinyGsmMatcher.h"
+#include "TinyGsmResponseBuffer.h"
+#include "TinyGsmBufferedStream.h"
+#include "TinyGsmCommandBuffer.h"
+#include "TinyGsmATRequest.h"
+#include "TinyGsmRxSignal.h"
+#include "TinyGsmEvents.h"
+#include "TinyGsmStatusCache.h"
+#include "TinyGsmDeadline.h"
+#include "TinyGsmBudget.h"
+#include "TinyGsmLatency.h"
+#include "TinyGsmResult.h"
+#if defined(ESP_PLATFORM)
+#include <nvs.h>
+#endif
+#if defined TINY_GSM_RX_PUMP
+#include "TinyGsmRxPump.h"
+#endif
+#if defined TINY_GSM_COROUTINES
+#include "TinyGsmCoroutine.h"
+#endif
 
 #ifndef AT_NL
 #define AT_NL "\r\n"
@@ -23,7 +44,6 @@
 #define AT_ERROR "ERROR"
 #endif
 
-#if defined TINY_GSM_DEBUG
 #ifndef AT_VERBOSE
 #define AT_VERBOSE "+CME ERROR:"
 #endif
@@ -31,6 +51,84 @@
 #ifndef AT_VERBOSE_2
 #define AT_VERBOSE_2 "+CMS ERROR:"
 #endif
+
+// Capacity of the automatons matching the responses (r1..r7) and the URCs
+// while waiting for a response, see TinyGsmMatcher.
+#ifndef TINY_GSM_RESPONSE_MATCHER_STATES
+#define TINY_GSM_RESPONSE_MATCHER_STATES 96
+#endif
+
+#ifndef TINY_GSM_URC_MATCHER_STATES
+#define TINY_GSM_URC_MATCHER_STATES 128
+#endif
+
+#ifndef TINY_GSM_MATCHER_CLASSES
+#define TINY_GSM_MATCHER_CLASSES 40
+#endif
+
+// Size of the buffer collecting the response in waitResponse, and what to do
+// if a response is longer, see TinyGsmResponseBuffer.
+#ifndef TINY_GSM_RESPONSE_BUFFER_SIZE
+#define TINY_GSM_RESPONSE_BUFFER_SIZE 256
+#endif
+
+#ifndef TINY_GSM_RESPONSE_BUFFER_OVERFLOW
+#define TINY_GSM_RESPONSE_BUFFER_OVERFLOW TINY_GSM_OVERFLOW_KEEP_TAIL
+#endif
+
+// Number of bytes read from the modem UART at once, see TinyGsmBufferedStream.
+#ifndef TINY_GSM_STREAM_CHUNK_SIZE
+#define TINY_GSM_STREAM_CHUNK_SIZE 256
+#endif
+
+// Size of the stack buffer an AT command is formatted into, see
+// TinyGsmCommandBuffer.  Longer commands are written in several parts.
+#ifndef TINY_GSM_COMMAND_BUFFER_SIZE
+#define TINY_GSM_COMMAND_BUFFER_SIZE 128
+#endif
+
+// Size and maximum number of commands of a command batch, see sendATBatch().
+#ifndef TINY_GSM_COMMAND_BATCH_SIZE
+#define TINY_GSM_COMMAND_BATCH_SIZE 384
+#endif
+
+#ifndef TINY_GSM_COMMAND_BATCH_COUNT
+#define TINY_GSM_COMMAND_BATCH_COUNT 8
+#endif
+
+typedef TinyGsmCommandBatch<TINY_GSM_COMMAND_BATCH_SIZE,
+                            TINY_GSM_COMMAND_BATCH_COUNT>
+    TinyGsmATBatch;
+
+// Number of URC handlers the application can add, and of events kept until
+// the application polls them.
+#ifndef TINY_GSM_URC_HANDLERS
+#define TINY_GSM_URC_HANDLERS 8
+#endif
+
+#ifndef TINY_GSM_EVENT_QUEUE_SIZE
+#define TINY_GSM_EVENT_QUEUE_SIZE 16
+#endif
+
+// Number of commands whose completion line can be waited for at once, and
+// how long the waiting caller listens for it before letting the others have
+// the modem, see expectCompletion().
+#ifndef TINY_GSM_COMPLETIONS
+#define TINY_GSM_COMPLETIONS 4
+#endif
+
+#ifndef TINY_GSM_COMPLETION_SLICE_MS
+#define TINY_GSM_COMPLETION_SLICE_MS 200
+#endif
+
+// Size of the pipe between the rx pump task and the readers, and how long the
+// task sleeps if there is nothing to do, see TinyGsmRxPump.
+#ifndef TINY_GSM_RX_PUMP_BUFFER
+#define TINY_GSM_RX_PUMP_BUFFER 1024
+#endif
+
+#ifndef TINY_GSM_RX_PUMP_IDLE_MS
+#define TINY_GSM_RX_PUMP_IDLE_MS 10
 #endif
 
 #ifndef MODEM_MANUFACTURER
@@ -44,13 +142,11 @@
 static const char GSM_OK[] TINY_GSM_PROGMEM    = AT_OK AT_NL;
 static const char GSM_ERROR[] TINY_GSM_PROGMEM = AT_ERROR AT_NL;
 
-#if defined       TINY_GSM_DEBUG
 static const char GSM_VERBOSE[] TINY_GSM_PROGMEM   = AT_VERBOSE;
 static const char GSM_VERBOSE_2[] TINY_GSM_PROGMEM = AT_VERBOSE_2;
-#endif
 
 namespace {
-const char* tag_tgm = "[TinyGsmModem] ";
+[[maybe_unused]] const char* tag_tgm = "[TinyGsmModem] ";
 }
 template <class modemType>
 class TinyGsmModem {
@@ -96,11 +192,96 @@ class TinyGsmModem {
    */
   template <typename... Args>
   inline void sendAT(Args... cmd) {
+    beginCommand(commandKey(cmd...));
     thisModem().streamWrite("AT", cmd..., AT_NL);
     thisModem().stream.flush();
     TINY_GSM_YIELD(); /* DBG("### AT:", cmd...); */
   }
 
+  /**
+   * @brief Run a batch of AT commands.
+   *
+   * If the modem accepts command concatenation (TINY_GSM_AT_CHAINING), each
+   * run of consecutive commands is sent in one line separated by ';', and one
+   * final OK covers them all.  If that line fails with an error - a
+   * concatenated line stops at the first failing command without telling
+   * which one - its commands are run again one by one, so every command gets
+   * its own result and a failing optional command is ignored; the commands
+   * before the line are not repeated.  Commands added with addUnchained(),
+   * and all commands without chaining, are run one by one.  Only chain
+   * commands which may be repeated, like settings.
+   *
+   * The batch stops at the first failing required command.  Like sendAT(),
+   * must be called with the modem locked.
+   *
+   * @param batch The commands with their timeouts; the result of each command
+   * is stored in it.
+   * @return *true* All commands returned OK, except optional ones.
+   * @return *false* A required command failed, see batch.result().
+   */
+  template <size_t N, uint8_t maxCmds>
+  bool sendATBatch(TinyGsmCommandBatch<N, maxCmds>& batch) {
+    DBGCHK(Error, batch.valid(), "[TinyGsmModem] Command batch too long, %hhu commands fit.", batch.count())
+    if (!batch.valid()) { return false; }
+
+    for (uint8_t i = 0; i < batch.count(); i++) { batch.setResult(i, 0); }
+
+    uint8_t i      = 0;
+    uint8_t single = 0;  // Up to here one by one, the rest of a failed line
+    while (i < batch.count()) {
+      if (deadlinePassed()) { return false; }
+#if defined TINY_GSM_AT_CHAINING
+      // The run of chainable commands starting at i
+      uint8_t  end        = i;
+      uint32_t timeout_ms = 0;
+      while (end < batch.count() && !batch.unchained(end)) {
+        timeout_ms += batch.timeout(end++);
+      }
+      if (i >= single && end - i > 1) {
+        // The line is timed like a command of its own, see sendAT()
+        TinyGsmCommandBuffer<TINY_GSM_LATENCY_NAME_SIZE> name;
+        for (uint8_t k = i; k < end; k++) {
+          if (k > i) { name.add(';'); }
+          name.add(batch.command(k));
+        }
+        beginCommand(TinyGsmLatency::key(name.data(), name.length()));
+
+        TinyGsmCommandBuffer<TINY_GSM_COMMAND_BUFFER_SIZE> cmd(
+            thisModem().stream);
+        cmd.add("AT");
+        for (uint8_t k = i; k < end; k++) {
+          if (k > i) { cmd.add(';'); }
+          cmd.add(batch.command(k));
+        }
+        cmd.add(AT_NL);
+        cmd.send();
+        thisModem().stream.flush();
+        TINY_GSM_YIELD();
+
+        int8_t res = thisModem().waitResponse(timeout_ms);
+        if (res == 1) {
+          for (; i < end; i++) { batch.setResult(i, 1); }
+          continue;
+        }
+        // No answer at all: the line may still be running, sending it again
+        // command by command would mix up the answers.
+        if (res == 0) {
+          DBGLOG(Warn, "[TinyGsmModem] Chained commands AT%s... timed out.", batch.command(i))
+          return false;
+        }
+        DBGLOG(Warn, "[TinyGsmModem] Chained commands failed, running them one by one.")
+        single = end;
+      }
+#endif
+      thisModem().sendAT(batch.command(i));
+      batch.setResult(i, thisModem().waitResponse(batch.timeout(i)));
+      DBGCHK(Warn, batch.result(i) == 1, "[TinyGsmModem] AT%s failed: %hhi", batch.command(i), batch.result(i))
+      if (batch.result(i) != 1 && !batch.optional(i)) { return false; }
+      i++;
+    }
+    return true;
+  }
+
   /**
    * @brief Set the module baud rate
    *
@@ -121,6 +302,333 @@ class TinyGsmModem {
     return b;
   }
 
+#if defined TINY_GSM_RX_PUMP
+  /**
+   * @brief Start the rx pump task, which from now on is the only reader of
+   * the modem UART.
+   *
+   * The task moves everything arriving into a pipe.  While no command is
+   * running it handles URCs right away and fetches announced socket data
+   * into the rx fifos of the clients; while a command is running, the
+   * requester gets its response out of the pipe as before.
+   *
+   * @return *true* The task is running.
+   */
+  bool startRxPump() {
+    return thisModem().rxPump.start(rxPumpStep, this, TINY_GSM_RX_PUMP_IDLE_MS);
+  }
+
+  /**
+   * @brief Stop the rx pump task; the UART is read directly again.
+   */
+  void stopRxPump() {
+    thisModem().rxPump.stop();
+  }
+
+  bool rxPumpRunning() {
+    return thisModem().rxPump.running();
+  }
+#endif
+
+  /**
+   * @brief Queue an AT command to be run without blocking the calling task.
+   *
+   * The commands are run one after the other by pollAT(), in the order they
+   * were submitted.  Several requests can be in flight at the same time, but
+   * each request object only once.
+   *
+   * @param req The request, see TinyGsmATRequest; must stay alive until it is
+   * done.
+   * @return *true* The request is queued.
+   * @return *false* The request is still in flight, or its command is empty
+   * or too long.
+   */
+  bool submitAT(TinyGsmATRequest& req) {
+    TinyGsmATState s = req._state;
+    if (s == TINY_GSM_AT_QUEUED || s == TINY_GSM_AT_RUNNING || !req.valid()) {
+      DBGLOG(Warn, "[TinyGsmModem] submitAT: request in flight or invalid, state: %i", static_cast<int>(s))
+      return false;
+    }
+    if (req._r[0] == nullptr && req._r[1] == nullptr) {
+      req.expect(GFP(GSM_OK), GFP(GSM_ERROR));
+    }
+    req._result    = 0;
+    req._response.clear();
+    req._submitted = millis();
+    req._state     = TINY_GSM_AT_QUEUED;
+    atQueue.push(&req);
+    return true;
+  }
+
+  /**
+   * @brief Drive the submitted AT commands: send the next one if the modem is
+   * free, and check for the response of the running one.  Never waits for a
+   * response.
+   *
+   * Call it regularly from one task (for example the loop of the
+   * application); with a running rx pump the pump task does it and this
+   * function does nothing.  The modem is locked only within the call; a
+   * function taking the modem while a command is in flight first waits for
+   * its response, so the polling task may call blocking functions as well.
+   * Callbacks run in the polling task after the modem is unlocked.
+   * maintain() steps the requests as well.
+   *
+   * @return *true* Requests are queued or running.
+   * @return *false* Nothing to do.
+   */
+  bool pollAT() {
+#if defined TINY_GSM_RX_PUMP
+    if (rxPumpRunning()) { return atRunning != nullptr || !atQueue.empty(); }
+#endif
+    return pollATImpl();
+  }
+
+  /**
+   * @brief Wait for a submitted request to be done, polling meanwhile.
+   *
+   * @return *int8_t* The result of the request, see TinyGsmATRequest::result().
+   */
+  int8_t waitAT(TinyGsmATRequest& req) {
+    while (req._state == TINY_GSM_AT_QUEUED ||
+           req._state == TINY_GSM_AT_RUNNING) {
+      if (!pollAT() || atRunning == nullptr) { delay(1); }
+      TINY_GSM_YIELD();
+    }
+    return req._result;
+  }
+
+  /**
+   * @brief Tell the modem that bytes arrived on its UART, so a waiting
+   * response wakes up at once instead of sleeping; call it from the receive
+   * callback of the UART, see TinyGsmRxSignal.
+   */
+  void notifyRxData() {
+    rxSignal.notify();
+  }
+
+#if defined(ESP_PLATFORM)
+  /**
+   * @brief notifyRxData() for interrupt handlers.
+   */
+  void notifyRxDataFromISR() {
+    rxSignal.notifyFromISR();
+  }
+#endif
+
+  /**
+   * @brief Handle a URC in the application.
+   *
+   * The prefix is added to the URC matcher of waitResponse(); when it
+   * arrives, the handler gets the rest of the line.  Handlers run in the task
+   * holding the modem, so they must be short and must not call the modem.
+   *
+   * @code
+   * bool onNetlight(const char* params, void*) { ... return true; }
+   * modem.addURCHandler(GF("+CNETLIGHT:"), onNetlight);
+   * @endcode
+   *
+   * @param prefix The start of the URC; must stay valid.
+   * @param handler Called with the parameters of the URC.
+   * @param arg Passed to the handler.
+   * @return *true* Added.
+   * @return *false* TINY_GSM_URC_HANDLERS handlers are there already.
+   */
+  bool addURCHandler(GsmConstStr prefix, TinyGsmURCHandler handler,
+                     void* arg = nullptr) {
+    bool b = false;
+
+    MS_TINY_GSM_SEM_TAKE_WAIT
+
+    if (urcHandlerCount < TINY_GSM_URC_HANDLERS) {
+      urcHandlers[urcHandlerCount++] = {prefix, handler, arg};
+      urcMatcherBuilt = false;
+#if defined TINY_GSM_COROUTINES
+      urcScanning = false;
+#endif
+      b = true;
+    }
+
+    MS_TINY_GSM_SEM_GIVE_WAIT
+
+    DBGCHK(Error, b, "%s""addURCHandler: too many handlers, TINY_GSM_URC_HANDLERS: %i", tag_tgm, TINY_GSM_URC_HANDLERS)
+    return b;
+  }
+
+  /**
+   * @brief Write the latency learned for the AT commands into buf, to load
+   * it again after a reboot, see TinyGsmLatency.
+   *
+   * @return The number of bytes written (latencySaveSize()), 0 if buf is too
+   * small.
+   */
+  size_t saveLatency(uint8_t* buf, size_t len) {
+    MS_TINY_GSM_SEM_TAKE_WAIT
+    size_t n = latency.save(buf, len);
+    MS_TINY_GSM_SEM_GIVE_WAIT
+    return n;
+  }
+
+  static constexpr size_t latencySaveSize() {
+    return TinyGsmLatency::saveSize();
+  }
+
+  /**
+   * @brief Load the latency saved with saveLatency().
+   *
+   * @return *false* Not saved by this build; nothing is loaded.
+   */
+  bool loadLatency(const uint8_t* buf, size_t len) {
+    MS_TINY_GSM_SEM_TAKE_WAIT
+    bool b = latency.load(buf, len);
+    MS_TINY_GSM_SEM_GIVE_WAIT
+    DBGCHK(Warn, b, "%s""loadLatency: no latency of this build", tag_tgm)
+    return b;
+  }
+
+  /**
+   * @brief Forget the learned latency, e.g. after a firmware update of the
+   * module; the timeouts given in the code apply until it is learned again.
+   */
+  void clearLatency() {
+    MS_TINY_GSM_SEM_TAKE_WAIT
+    latency.clear();
+    MS_TINY_GSM_SEM_GIVE_WAIT
+  }
+
+#if defined(ESP_PLATFORM)
+  /**
+   * @brief saveLatency() into NVS; nvs_flash_init() must have been called
+   * (the Arduino core does).
+   */
+  bool saveLatencyToNVS(const char* nvsNamespace = "tinygsm") {
+    uint8_t      buf[latencySaveSize()];
+    nvs_handle_t h;
+    bool         b = false;
+    if (saveLatency(buf, sizeof(buf)) &&
+        nvs_open(nvsNamespace, NVS_READWRITE, &h) == ESP_OK) {
+      b = nvs_set_blob(h, "latency", buf, sizeof(buf)) == ESP_OK &&
+          nvs_commit(h) == ESP_OK;
+      nvs_close(h);
+    }
+    DBGCHK(Error, b, "%s""saveLatencyToNVS failed", tag_tgm)
+    return b;
+  }
+
+  /**
+   * @brief loadLatency() from NVS.
+   */
+  bool loadLatencyFromNVS(const char* nvsNamespace = "tinygsm") {
+    uint8_t      buf[latencySaveSize()];
+    size_t       len = sizeof(buf);
+    nvs_handle_t h;
+    bool         b = false;
+    if (nvs_open(nvsNamespace, NVS_READONLY, &h) == ESP_OK) {
+      b = nvs_get_blob(h, "latency", buf, &len) == ESP_OK &&
+          loadLatency(buf, len);
+      nvs_close(h);
+    }
+    return b;
+  }
+#endif
+
+  /**
+   * @brief Get the next event published by the URC handlers (socket closed,
+   * network time, modem reset, unknown URC, ...).  Call it from one task.
+   *
+   * @return *true* ev is filled.
+   * @return *false* No event.
+   */
+  bool pollEvent(TinyGsmEvent& ev) {
+    return events.pop(ev);
+  }
+
+  /**
+   * @brief The number of events lost because nobody polled them in time.
+   */
+  uint32_t eventsDropped() const {
+    return events.dropped();
+  }
+
+#if defined TINY_GSM_COROUTINES
+  /**
+   * @brief The event loop driving the coroutines of this modem.
+   *
+   * Call eventLoop().runOnce() regularly from the task running the
+   * coroutines; it runs the asynchronous AT commands, handles URCs arriving
+   * while the modem is idle and resumes the coroutines whose response or
+   * event has arrived.
+   *
+   * @code
+   * TinyGsmTask<bool> t = modem.gprsConnectAsync(apn);
+   * modem.eventLoop().start(t);
+   * while (!t.done()) { modem.eventLoop().runOnce(); delay(1); }
+   * @endcode
+   */
+  TinyGsmEventLoop& eventLoop() {
+    return coLoop;
+  }
+
+  /**
+   * @brief co_await modem.atAsync(req): run an AT command without blocking;
+   * the coroutine resumes when the response arrived or the deadline passed.
+   *
+   * @return *int8_t* The result of the request (see
+   * TinyGsmATRequest::result()), or -1 if it could not be submitted.
+   */
+  TinyGsmATAwaiter<modemType> atAsync(TinyGsmATRequest& req) {
+    return TinyGsmATAwaiter<modemType>(thisModem(), coLoop, req);
+  }
+
+  /**
+   * @brief co_await modem.sendATBatchAsync(batch, deadline): like
+   * sendATBatch(), but the commands are awaited one by one (atAsync()), so
+   * the modem is free for the others in between.  No command is started once
+   * the deadline passed, nor waits beyond it.
+   *
+   * @return *bool* All commands returned OK, except optional ones.
+   */
+  template <size_t N, uint8_t maxCmds>
+  TinyGsmTask<bool> sendATBatchAsync(TinyGsmCommandBatch<N, maxCmds>& batch,
+                                     TinyGsmDeadline deadline = TinyGsmDeadline()) {
+    DBGCHK(Error, batch.valid(), "[TinyGsmModem] Command batch too long, %hhu commands fit.", batch.count())
+    if (!batch.valid()) { co_return false; }
+
+    TinyGsmATRequest req;
+    for (uint8_t i = 0; i < batch.count(); i++) { batch.setResult(i, 0); }
+    for (uint8_t i = 0; i < batch.count(); i++) {
+      if (deadline.expired()) { co_return false; }
+      req.command(batch.command(i)).timeout(deadline.cap(batch.timeout(i)));
+      int8_t r = co_await atAsync(req);
+      batch.setResult(i, TinyGsmMax(r, static_cast<int8_t>(0)));
+      DBGCHK(Warn, r == 1, "[TinyGsmModem] AT%s failed: %hhi", batch.command(i), r)
+      if (r != 1 && !batch.optional(i)) { co_return false; }
+    }
+    co_return true;
+  }
+
+  /**
+   * @brief Awaitable testAT().
+   */
+  TinyGsmTask<bool> testATAsync(uint32_t timeout_ms = 10000L) {
+    TinyGsmATRequest req;
+    for (uint32_t start = millis(); millis() - start < timeout_ms;) {
+      if (co_await atAsync(req.command("").timeout(200)) == 1) { co_return true; }
+      co_await coLoop.sleep(100);
+    }
+    co_return false;
+  }
+
+  /**
+   * @brief Awaitable getSignalQuality(); 99 if unknown.
+   */
+  TinyGsmTask<int16_t> getSignalQualityAsync() {
+    TinyGsmATRequest req;
+    if (co_await atAsync(req.command(GF("+CSQ"))) != 1) { co_return 99; }
+    const char* p = strstr(req.response(), "+CSQ:");
+    co_return p ? static_cast<int16_t>(atoi(p + 5)) : 99;
+  }
+#endif
+
   /**
    * @brief Test response to AT commands
    *
@@ -136,6 +644,9 @@ class TinyGsmModem {
   /**
    * @brief Listen for responses to commands and handle URCs
    *
+   * @note Prefer the overloads without data and lastResponse(), they do not
+   * allocate any heap memory.
+   *
    * @param timeout_ms The time to wait for a response
    * @param data A string of data to fill in with response results
    * @param r1 The first output to test against, optional with a default value
@@ -159,8 +670,13 @@ class TinyGsmModem {
                       GsmConstStr r2 = GFP(GSM_ERROR), GsmConstStr r3 = nullptr,
                       GsmConstStr r4 = nullptr, GsmConstStr r5 = nullptr,
                       GsmConstStr r6 = nullptr, GsmConstStr r7 = nullptr) {
-    return thisModem().waitResponseImpl(timeout_ms, data, r1, r2, r3, r4, r5,
-                                        r6, r7);
+    // The whole response, also if it does not fit into the response buffer
+    data         = "";
+    responseSink = &data;
+    int8_t index = thisModem().waitResponseImpl(timeout_ms, r1, r2, r3, r4, r5,
+                                                r6, r7);
+    responseSink = nullptr;
+    return index;
   }
 
   /**
@@ -187,8 +703,8 @@ class TinyGsmModem {
                       GsmConstStr r2 = GFP(GSM_ERROR), GsmConstStr r3 = nullptr,
                       GsmConstStr r4 = nullptr, GsmConstStr r5 = nullptr,
                       GsmConstStr r6 = nullptr, GsmConstStr r7 = nullptr) {
-    String data;
-    return waitResponse(timeout_ms, data, r1, r2, r3, r4, r5, r6, r7);
+    return thisModem().waitResponseImpl(timeout_ms, r1, r2, r3, r4, r5, r6,
+                                        r7);
   }
 
   /**
@@ -217,6 +733,16 @@ class TinyGsmModem {
                       GsmConstStr r6 = nullptr, GsmConstStr r7 = nullptr) {
     return waitResponse(1000L, r1, r2, r3, r4, r5, r6, r7);
   }
+
+  /**
+   * @brief The response received by the last waitResponse, including the
+   * matched response or the +CME/+CMS ERROR line; empty if nothing matched.
+   *
+   * @return *const char\** The response, valid until the next waitResponse.
+   */
+  const char* lastResponse() const {
+    return responseBuffer.c_str();
+  }
   // <MS>
   bool waitResponsePlain(unsigned long timeout_ms, std::string& data) {
     return thisModem().waitResponsePlainImpl(timeout_ms, data);
@@ -233,7 +759,7 @@ class TinyGsmModem {
   String getModemInfo() {
     String s;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     s = thisModem().getModemInfoImpl();
 
@@ -251,7 +777,7 @@ class TinyGsmModem {
   String getModemName() {
     String s;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     s = thisModem().getModemNameImpl();
 
@@ -260,13 +786,29 @@ class TinyGsmModem {
     return s;
   }
 
+  /*
+   * The identity of the modem and the SIM (manufacturer, model, revision,
+   * serial number, IMEI, CCID, IMSI) is read once and kept until the modem
+   * restarts: restart(), factoryDefault(), the "SMS Ready" URC of a reset or
+   * invalidateIdentity().  A failed read is not kept.  The identity is read
+   * and changed only with the modem locked.
+   */
+
   /**
    * @brief Get the modem manufacturer
    *
    * @return *String* The modem manufacturer
    */
   String getModemManufacturer() {
-    return thisModem().getModemManufacturerImpl();
+    String s;
+
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
+
+    s = identityManufacturer();
+
+    MS_TINY_GSM_SEM_GIVE_WAIT
+
+    return s;
   }
 
   /**
@@ -275,7 +817,15 @@ class TinyGsmModem {
    * @return *String* The modem model, as it calls itself
    */
   String getModemModel() {
-    return thisModem().getModemModelImpl();
+    String s;
+
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
+
+    s = identityModel();
+
+    MS_TINY_GSM_SEM_GIVE_WAIT
+
+    return s;
   }
 
   /**
@@ -287,7 +837,16 @@ class TinyGsmModem {
    * @return *String* The modem revision information
    */
   String getModemRevision() {
-    return thisModem().getModemRevisionImpl();
+    String s;
+
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
+
+    if (!identity.revision.length()) { identity.revision = thisModem().getModemRevisionImpl(); }
+    s = identity.revision.length() ? identity.revision : String("unknown");
+
+    MS_TINY_GSM_SEM_GIVE_WAIT
+
+    return s;
   }
 
   /**
@@ -296,7 +855,16 @@ class TinyGsmModem {
    * @return *String* The modem serial number
    */
   String getModemSerialNumber() {
-    return thisModem().getModemSerialNumberImpl();
+    String s;
+
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
+
+    if (!identity.serial.length()) { identity.serial = thisModem().getModemSerialNumberImpl(); }
+    s = identity.serial.length() ? identity.serial : String("unknown");
+
+    MS_TINY_GSM_SEM_GIVE_WAIT
+
+    return s;
   }
 
   /**
@@ -308,8 +876,21 @@ class TinyGsmModem {
    * @return *false* The module failed to reset to default.
    */
   bool factoryDefault() {
+    invalidateIdentity();
     return thisModem().factoryDefaultImpl();
   }
+
+  /**
+   * @brief Forget the identity read from the modem, e.g. after the module
+   * was power cycled or the SIM changed.
+   */
+  void invalidateIdentity() {
+    MS_TINY_GSM_SEM_TAKE_WAIT
+
+    forgetIdentity();
+
+    MS_TINY_GSM_SEM_GIVE_WAIT
+  }
   /**@}*/
 
   /**
@@ -328,6 +909,7 @@ class TinyGsmModem {
    */
   bool restart(const char* pin = nullptr) {
     bool b = false;
+    invalidateIdentity();
     b = thisModem().restartImpl(pin);
     return b;
   }
@@ -419,17 +1001,21 @@ class TinyGsmModem {
    * This is often a "CSQ" value ranging from 0 to 32, but may be an RSSI or a
    * percent.
    *
+   * @param maxAge_ms The maximum age of a cached value to accept; callers
+   * asking while the modem is asked get the same answer.
    * @return *int16_t* The signal quality
    */
-  int16_t getSignalQuality() {
-    int16_t i = 0;
+  int16_t getSignalQuality(uint32_t maxAge_ms = TINY_GSM_CACHE_CSQ_MS) {
+    int16_t i = 99;
+    if (csqCache.begin(i, maxAge_ms) != TINY_GSM_CACHE_QUERY) { return i; }
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     i = thisModem().getSignalQualityImpl();
 
     MS_TINY_GSM_SEM_GIVE_WAIT
 
+    csqCache.end(i != 99, i);
     return i;
   }
 
@@ -467,8 +1053,29 @@ class TinyGsmModem {
     return static_cast<modemType&>(*this);
   }
   /**@}*/
+  TinyGsmModem() {
+    // A new owner of the modem first lets a submitted command still in
+    // flight finish, see settleAT()
+    modemLock.onAcquired(&settleATHook, this);
+  }
   ~TinyGsmModem() {}
 
+  /**
+   * @anchor modem_lock
+   * @name Lock
+   */
+  /**@{*/
+ public:
+  /**
+   * @brief The lock of this modem and the scheduler ordering its callers,
+   * used by the MS_TINY_GSM_SEM_* macros.  Every modem has its own, so two
+   * modems do not wait for each other.
+   */
+  TinyGsmScheduler& lockScheduler() {
+    return modemLock;
+  }
+  /**@}*/
+
 
   /**
    * @anchor modem_utilities
@@ -477,15 +1084,14 @@ class TinyGsmModem {
   /**@{*/
  public:
   // Utility templates for writing/skipping characters on a stream
-  template <typename T>
-  inline void streamWrite(T last) {
-    thisModem().stream.print(last);
-  }
-
-  template <typename T, typename... Args>
-  inline void streamWrite(T head, Args... tail) {
-    thisModem().stream.print(head);
-    thisModem().streamWrite(tail...);
+  // All parts are formatted into one stack buffer and written at once,
+  // instead of one print() per part.
+  template <typename... Args>
+  inline void streamWrite(Args... parts) {
+    TinyGsmCommandBuffer<TINY_GSM_COMMAND_BUFFER_SIZE> cmd(
+        thisModem().stream);
+    (cmd.add(parts), ...);
+    cmd.send();
   }
 
   inline void streamClear() {
@@ -501,10 +1107,8 @@ class TinyGsmModem {
 
     int8_t   numCharsReady = -1;
     uint32_t startMillis   = millis();
-    while (millis() - startMillis < timeout_ms &&
-           (numCharsReady = static_cast<int8_t>(thisModem().stream.available())) < numChars) {
-      TINY_GSM_YIELD();
-    }
+    while ((numCharsReady = static_cast<int8_t>(thisModem().stream.available())) < numChars &&
+           waitForRx(startMillis, timeout_ms, numCharsReady > 0)) {}
 
     if (numCharsReady >= numChars) {
       thisModem().stream.readBytes(buf, static_cast<size_t>(numChars));
@@ -621,19 +1225,24 @@ class TinyGsmModem {
 
   inline bool streamSkipUntil(const char c, const uint32_t timeout_ms = 1000L) {
     DBGLOG(Verbose, "[TinyGsmModem] >> c: '%c', timeout_ms: %" PRIu32, c, timeout_ms)
-    DBGCOD(int idx = 0;)
+    DBGCOD(size_t idx = 0;)
     uint32_t startMillis = millis();
     while (millis() - startMillis < timeout_ms) {
-      while (millis() - startMillis < timeout_ms &&
-             !thisModem().stream.available()) {
+      size_t n = thisModem().bufferedStream.fill();
+      if (n == 0) {
         TINY_GSM_YIELD();
+        continue;
       }
-      if (thisModem().stream.read() == c) { 
-        DBGLOG(Verbose, "[TinyGsmModem] '%c' found at idx: %i", c, idx)
+      const char* chunk = thisModem().bufferedStream.buffer();
+      const char* found = static_cast<const char*>(memchr(chunk, c, n));
+      if (found) { 
+        thisModem().bufferedStream.consume(static_cast<size_t>(found - chunk) + 1);
+        DBGLOG(Verbose, "[TinyGsmModem] '%c' found at idx: %zu", c, idx + static_cast<size_t>(found - chunk))
         DBGLOG(Verbose, "[TinyGsmModem] << return: t")
         return true; 
       }
-      DBGCOD(idx++;)
+      thisModem().bufferedStream.consume(n);
+      DBGCOD(idx += n;)
     }
     DBGLOG(Verbose, "[TinyGsmModem] << return: f")
     return false;
@@ -702,15 +1311,465 @@ class TinyGsmModem {
   // Therefore, call delay after xxx ms.
   #define MS_WAITRESPONSE_DELAY_TIMER_INTERVAL 100
 
-  // TODO(vshymanskyy): Optimize this!
-  int8_t waitResponseImpl(uint32_t timeout_ms, String& data,
+  // Wait until (more) bytes are available on the modem stream or the deadline
+  // startMillis + timeout_ms has passed: blocks on rxSignal instead of
+  // polling.  With partial set, the available bytes are not enough yet, so
+  // it waits for more even though some are there.  While bytes keep
+  // arriving the loops never block, so the idle task (watchdog) gets a tick
+  // every MS_WAITRESPONSE_DELAY_TIMER_INTERVAL.
+  // Returns false if the deadline has passed.
+  bool waitForRx(uint32_t startMillis, uint32_t timeout_ms,
+                 bool partial = false) {
+    uint32_t elapsed = millis() - startMillis;
+    if (elapsed >= timeout_ms) { return false; }
+    if (!partial && thisModem().stream.available() > 0) {
+      if (millis() - rxBusySince > MS_WAITRESPONSE_DELAY_TIMER_INTERVAL) {
+        delay(1);
+        rxBusySince = millis();
+      }
+      return true;
+    }
+    rxSignal.wait(timeout_ms - elapsed);
+    rxBusySince = millis();
+    return true;
+  }
+
+  // Matcher ids of +CME ERROR and +CMS ERROR, behind the ids 1..7 of r1..r7.
+  #define MS_MATCH_VERBOSE 8
+  #define MS_MATCH_VERBOSE_2 9
+
+  // (Re-)compile the response automaton if the wanted responses changed since
+  // the last call. Responses are always string literals (GF/GFP), therefore
+  // comparing the pointers is enough.
+  void prepareResponseMatcher(GsmConstStr r1, GsmConstStr r2, GsmConstStr r3,
+                              GsmConstStr r4, GsmConstStr r5, GsmConstStr r6,
+                              GsmConstStr r7) {
+    const GsmConstStr r[7] = {r1, r2, r3, r4, r5, r6, r7};
+    if (responseMatcherBuilt &&
+        memcmp(responseMatcherKey, r, sizeof(responseMatcherKey)) == 0) {
+      return;
+    }
+    responseMatcher.clear();
+    for (int8_t i = 0; i < 7; i++) {
+      responseMatcher.add(reinterpret_cast<const char*>(r[i]),
+                          static_cast<int8_t>(i + 1));
+    }
+    // A command failing with an error code ends the wait at once
+    responseMatcher.add(reinterpret_cast<const char*>(GFP(GSM_VERBOSE)),
+                        MS_MATCH_VERBOSE);
+    responseMatcher.add(reinterpret_cast<const char*>(GFP(GSM_VERBOSE_2)),
+                        MS_MATCH_VERBOSE_2);
+    responseMatcher.build();
+    DBGCHK(Error, responseMatcher.valid(),
+           "%s""response matcher capacity exceeded, fall back to endsWith()", tag_tgm)
+    memcpy(responseMatcherKey, r, sizeof(responseMatcherKey));
+    responseMatcherBuilt = true;
+  }
+
+  // Compile the automaton of the URC prefixes the modem handles.
+  // The URC matcher is the prefix trie of the URC table of the modem (ids
+  // 1..urcTableSize) followed by the handlers added by the application and
+  // the completions waited for.
+  void prepareURCMatcher() {
+    if (urcMatcherBuilt) { return; }
+    urcMatcher.clear();
+    const TinyGsmURCEntry<modemType>* urcs = thisModem().urcTable();
+    urcTableSize                           = 0;
+    while (urcs != nullptr && urcs[urcTableSize].prefix != nullptr) {
+      urcMatcher.add(reinterpret_cast<const char*>(urcs[urcTableSize].prefix),
+                     static_cast<int8_t>(urcTableSize + 1));
+      urcTableSize++;
+    }
+    for (uint8_t i = 0; i < urcHandlerCount; i++) {
+      urcMatcher.add(reinterpret_cast<const char*>(urcHandlers[i].prefix),
+                     static_cast<int8_t>(urcTableSize + i + 1));
+    }
+    for (uint8_t i = 0; i < TINY_GSM_COMPLETIONS; i++) {
+      if (completions[i].prefix[0] == '\0') { continue; }
+      urcMatcher.add(completions[i].prefix,
+                     static_cast<int8_t>(urcTableSize + urcHandlerCount + i + 1));
+    }
+    urcMatcher.build();
+    DBGCHK(Error, urcMatcher.valid(), "%s""URC matcher capacity exceeded!", tag_tgm)
+    urcMatcherBuilt = true;
+  }
+
+  // Call the handler of the URC with matcher id urc: a member function of the
+  // modem from its URC table, or a handler added by the application; or keep
+  // the line of a completion.
+  bool dispatchURC(int8_t urc) {
+    if (urc <= urcTableSize) {
+      return (thisModem().*(thisModem().urcTable()[urc - 1].handler))();
+    }
+    if (urc > urcTableSize + urcHandlerCount) {
+      Completion& c = completions[urc - urcTableSize - urcHandlerCount - 1];
+      streamReadLine(c.line, sizeof(c.line));
+      c.done = true;
+      return true;
+    }
+    const URCHandlerEntry& h = urcHandlers[urc - urcTableSize - 1];
+    char params[TINY_GSM_EVENT_TEXT_SIZE * 2];
+    streamReadLine(params, sizeof(params));
+    return h.handler(params, h.arg);
+  }
+
+  // Read the rest of the line without the line end; what does not fit is
+  // skipped.
+  void streamReadLine(char* buf, size_t size) {
+    size_t n = thisModem().stream.readBytesUntil('\n', buf, size - 1);
+    if (n == size - 1) { streamSkipUntil('\n'); }
+    if (n > 0 && buf[n - 1] == '\r') { n--; }
+    buf[n] = '\0';
+  }
+
+  // Some commands answer OK at once and tell in a line later how they ended,
+  // e.g. "+APP PDP: 0,ACTIVE" after AT+CNACT=0,1.  Register the start of that
+  // line before sending the command, so whoever reads it (any waitResponse)
+  // keeps it, then wait for it with waitCompletion(), which lets the others
+  // have the modem in between.  Call with the modem locked:
+  //
+  //   int8_t c = expectCompletion(GF("+APP PDP: "), 0);   // "+APP PDP: 0,"
+  //   sendAT(GF("+CNACT=0,1"));
+  //   if (waitResponse() == 1 && waitCompletion(c, 60000L)) {
+  //     ... completionLine(c) ...                         // "ACTIVE"
+  //   }
+  //   endCompletion(c);
+  //
+  // param (if not negative) and ',' are appended to prefix.
+  // Returns the slot, -1 if TINY_GSM_COMPLETIONS are waited for already.
+  int8_t expectCompletion(GsmConstStr prefix, int param = -1) {
+    for (uint8_t i = 0; i < TINY_GSM_COMPLETIONS; i++) {
+      Completion& c = completions[i];
+      if (c.prefix[0] != '\0') { continue; }
+      if (param < 0) {
+        snprintf(c.prefix, sizeof(c.prefix), "%s", reinterpret_cast<const char*>(prefix));
+      } else {
+        snprintf(c.prefix, sizeof(c.prefix), "%s%d,", reinterpret_cast<const char*>(prefix), param);
+      }
+      c.line[0] = '\0';
+      c.done    = false;
+      urcMatcherBuilt = false;
+#if defined TINY_GSM_COROUTINES
+      urcScanning = false;
+#endif
+      return static_cast<int8_t>(i);
+    }
+    DBGLOG(Error, "%s""too many completions waited for, TINY_GSM_COMPLETIONS: %i", tag_tgm, TINY_GSM_COMPLETIONS)
+    return -1;
+  }
+
+  // Wait for the completion line, at most timeout_ms and not beyond the
+  // deadline of the operation.  Listens for it TINY_GSM_COMPLETION_SLICE_MS
+  // at a time and hands the modem over to the callers waiting for it in
+  // between (see handOver()); the modem is locked again on return.
+  bool waitCompletion(int8_t slot, uint32_t timeout_ms) {
+    if (slot < 0) { return false; }
+    const Completion& c = completions[slot];
+    return waitUntil([&c] { return c.done; }, timeout_ms);
+  }
+
+  // Like waitCompletion(), for a condition set by a URC handler of the modem.
+  template <typename Done>
+  bool waitUntil(Done done, uint32_t timeout_ms) {
+    timeout_ms     = opDeadline.cap(timeout_ms);
+    uint32_t start = millis();
+    while (!done()) {
+      uint32_t elapsed = millis() - start;
+      if (elapsed >= timeout_ms) { break; }
+      uint32_t slice = TinyGsmMin(timeout_ms - elapsed,
+                                  static_cast<uint32_t>(TINY_GSM_COMPLETION_SLICE_MS));
+      waitResponseBegin(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                        nullptr);
+      uint32_t sliceStart = millis();
+      while (waitResponseStep() >= 0 && !done() && waitForRx(sliceStart, slice)) {}
+      waitResponseEnd(0);
+      if (!done()) { handOver(); }
+    }
+    if (!done() && opDeadline.expired()) { opTimedOut = true; }
+    return done();
+  }
+
+  // The rest of the completion line, e.g. "ACTIVE" for "+APP PDP: 0,ACTIVE".
+  const char* completionLine(int8_t slot) const {
+    return slot < 0 ? "" : completions[slot].line;
+  }
+
+  // Stop waiting for the completion, also if it did not come; -1 is ignored.
+  void endCompletion(int8_t slot) {
+    if (slot < 0) { return; }
+    completions[slot].prefix[0] = '\0';
+    urcMatcherBuilt             = false;
+#if defined TINY_GSM_COROUTINES
+    urcScanning = false;
+#endif
+  }
+
+  // Let the callers waiting for the modem have it, then lock it again, in
+  // the class the caller took it with.  The state of the running operation
+  // (deadline, result) is kept; the others get the modem without it.
+  void handOver() {
+    TinyGsmDeadline   deadline = opDeadline;
+    bool              timedOut = opTimedOut;
+    TinyGsmResult     result   = lastCmdResult;
+    TinyGsmSchedClass cls      = this->lockScheduler().ownerClass();
+    uint8_t           mux      = this->lockScheduler().ownerMux();
+    opDeadline                 = TinyGsmDeadline();
+
+    MS_TINY_GSM_SEM_GIVE_WAIT
+    TINY_GSM_YIELD();
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(cls, mux)
+
+    opDeadline    = deadline;
+    opTimedOut    = timedOut;
+    lastCmdResult = result;
+  }
+
+  // Start an operation which has to be done by deadline: every waitResponse
+  // up to endDeadline() waits at most until then.  Nested operations keep the
+  // earlier deadline.  Call with the modem locked, and end before unlocking:
+  //
+  //   TinyGsmDeadline deadline(timeout_ms);
+  //   MS_TINY_GSM_SEM_TAKE_WAIT
+  //   TinyGsmDeadline outer = beginDeadline(deadline);
+  //   ... if (deadlinePassed()) { goto end; } ...
+  // end:
+  //   endDeadline(outer);
+  //   MS_TINY_GSM_SEM_GIVE_WAIT
+  TinyGsmDeadline beginDeadline(const TinyGsmDeadline& deadline) {
+    TinyGsmDeadline outer = opDeadline;
+    if (!outer.set()) { opTimedOut = false; }
+    opDeadline = outer.earlier(deadline);
+    return outer;
+  }
+
+  void endDeadline(const TinyGsmDeadline& outer) {
+    opDeadline = outer;
+  }
+
+  // Fail fast: true (and a timeout result) if the deadline of the operation
+  // passed.
+  bool deadlinePassed() {
+    if (!opDeadline.expired()) { return false; }
+    DBGLOG(Warn, "%s""deadline passed, operation aborted", tag_tgm)
+    opTimedOut = true;
+    return true;
+  }
+
+  // Why an operation failed, as far as its last command tells: timeout if
+  // its deadline passed, the error code the modem gave, or just ERROR.  Call
+  // with the modem locked: the state is shared by all callers.
+  TinyGsmResult operationResult(bool ok) const {
+    if (ok) { return TinyGsmResult(); }
+    if (opTimedOut) { return TinyGsmResult(TINY_GSM_RESULT_TIMEOUT); }
+    if (lastCmdResult) { return TinyGsmResult(TINY_GSM_RESULT_ERROR); }
+    return lastCmdResult;
+  }
+
+  // The key of a command in TinyGsmLatency: its first part, the rest are the
+  // variable arguments.
+  static uint32_t commandKey() {
+    return TinyGsmLatency::key("", 0);
+  }
+
+  template <typename First, typename... Rest>
+  static uint32_t commandKey(First name, Rest...) {
+    TinyGsmCommandBuffer<TINY_GSM_LATENCY_NAME_SIZE> text;
+    text.add(name);
+    return TinyGsmLatency::key(text.data(), text.length());
+  }
+
+  // A command is sent: the response of the one before, late after its
+  // learned timeout, must not be taken for the response to this one; the
+  // response of this one is timed under key, see TinyGsmLatency.
+  void beginCommand(uint32_t key) {
+    if (lateResponse.set()) { drainLateResponse(); }
+    latencyKey     = key;
+    latencySent    = millis();
+    latencyLearned = 0;
+  }
+
+  // The first response to the command sent by sendAT() ended: learn from its
+  // latency, or from the learned timeout passing.  In that case its response
+  // may still come, up to the timeout given in the code, see
+  // drainLateResponse().
+  void recordLatency(int8_t index) {
+    uint32_t latency_ms = millis() - latencySent;
+    if (index != 0) {
+      latency.record(latencyKey, latency_ms);
+    } else if (latencyLearned != 0 && latency_ms >= latencyLearned) {
+      DBGLOG(Warn, "%s""no response within the learned timeout of %" PRIu32 "ms", tag_tgm, latencyLearned)
+      latency.recordTimeout(latencyKey, latencyLearned);
+      if (latencyGiven > latency_ms) {
+        lateResponse = TinyGsmDeadline(latencyGiven - latency_ms);
+      }
+    }
+    latencyKey = 0;
+  }
+
+  // Wait for the final response of the command which missed its learned
+  // timeout, up to the timeout given in the code; URCs arriving meanwhile are
+  // handled as usual.
+  void drainLateResponse() {
+    uint32_t timeout_ms = lateResponse.remaining();
+    lateResponse        = TinyGsmDeadline();
+    int8_t index        = 0;
+
+    waitResponseBegin(GFP(GSM_OK), GFP(GSM_ERROR), nullptr, nullptr, nullptr,
+                      nullptr, nullptr);
+    uint32_t startMillis = millis();
+    do {
+      index = waitResponseStep();
+    } while (index == 0 && waitForRx(startMillis, timeout_ms));
+    DBGLOG(Warn, "%s""late response %s", tag_tgm, index != 0 ? "drained" : "did not come")
+    waitResponseEnd(index);
+  }
+
+  // A URC may have been lost (response buffer overflow, modem reset, socket
+  // command failed): state kept up to date by URCs has to be queried again by
+  // the modem, e.g. the socket states.
+  void suspectURCLoss() {
+    urcLossSuspected = true;
+  }
+
+  // Queue an event for the application.
+  void publishEvent(TinyGsmEventType type, uint8_t mux = 0xFF,
+                    int16_t value = 0, const char* text = nullptr) {
+    TinyGsmEvent ev;
+    ev.type  = type;
+    ev.mux   = mux;
+    ev.value = value;
+    if (text) { strncpy(ev.text, text, sizeof(ev.text) - 1); }
+    [[maybe_unused]] bool queued = events.push(ev);
+    DBGCHK(Warn, queued, "%s""event queue full, event %i dropped", tag_tgm, static_cast<int>(type))
+  }
+
+  // A wait for URCs only ended: its complete lines starting like a URC ('+'
+  // or '*') were sent by the modem without being asked and without a
+  // handler.  They are published as TINY_GSM_EVENT_UNKNOWN_URC; other lines
+  // (echo, empty, stray OK) and an incomplete last line are only logged.
+  void publishUnknownURCs() {
+    const char* line = responseBuffer.c_str();
+    while (*line) {
+      const char* end = strchr(line, '\n');
+      if (end == nullptr) { break; }
+      size_t len = static_cast<size_t>(end - line);
+      if (len > 0 && line[len - 1] == '\r') { len--; }
+      if (len > 0) {
+        char text[TINY_GSM_EVENT_TEXT_SIZE];
+        size_t n = TinyGsmMin(len, sizeof(text) - 1);
+        memcpy(text, line, n);
+        text[n] = '\0';
+        if (text[0] == '+' || text[0] == '*') {
+          DBGLOG(Debug, "%s""unknown URC: %s", tag_tgm, text)
+          publishEvent(TINY_GSM_EVENT_UNKNOWN_URC, 0xFF, 0, text);
+        } else {
+          DBGLOG(Debug, "%s""Unhandled: %s", tag_tgm, text)
+        }
+      }
+      line = end + 1;
+    }
+  }
+
+  // Only used if the responses do not fit into the response matcher.
+  int8_t matchResponseEndsWith() {
+    for (int8_t i = 0; i < 7; i++) {
+      if (responseBuffer.endsWith(
+              reinterpret_cast<const char*>(responseMatcherKey[i]))) {
+        return static_cast<int8_t>(i + 1);
+      }
+    }
+    if (responseBuffer.endsWith(reinterpret_cast<const char*>(GFP(GSM_VERBOSE)))) {
+      return MS_MATCH_VERBOSE;
+    }
+    if (responseBuffer.endsWith(reinterpret_cast<const char*>(GFP(GSM_VERBOSE_2)))) {
+      return MS_MATCH_VERBOSE_2;
+    }
+    return 0;
+  }
+
+  // Every received character advances the response and the URC automaton by
+  // one step each, instead of checking every response and URC with endsWith().
+  // The response is collected in responseBuffer, no heap memory is used.
+  int8_t waitResponseImpl(uint32_t timeout_ms,
                           GsmConstStr r1 = GFP(GSM_OK),
                           GsmConstStr r2 = GFP(GSM_ERROR),
                           GsmConstStr r3 = nullptr, GsmConstStr r4 = nullptr,
                           GsmConstStr r5 = nullptr, GsmConstStr r6 = nullptr,
                           GsmConstStr r7 = nullptr) {
-    unsigned long ms_delay_timer;
-    data.reserve(64);
+    int8_t index = 0;
+
+    waitResponseBegin(r1, r2, r3, r4, r5, r6, r7);
+
+    // The first response to a command gets the timeout learned for it, if
+    // shorter, see TinyGsmLatency
+    if (latencyKey != 0) {
+      uint32_t learned = latency.timeout(latencyKey, timeout_ms);
+      if (learned < timeout_ms) {
+        latencyLearned = learned;
+        latencyGiven   = timeout_ms;
+        timeout_ms     = learned;
+      }
+    }
+
+    // Not beyond the deadline of the operation, see beginDeadline()
+    timeout_ms = opDeadline.cap(timeout_ms);
+
+    uint32_t startMillis = millis();
+    do {
+      index = waitResponseStep();
+    } while (index == 0 && waitForRx(startMillis, timeout_ms));
+
+    if (index == 0 && opDeadline.expired()) { opTimedOut = true; }
+    return waitResponseEnd(index);
+  } // int8_t waitResponseImpl(...)
+
+  // Handle the URCs arriving within timeout_ms, like waitResponse(timeout_ms,
+  // nullptr, nullptr), but within budget: once it is spent, stop at the last
+  // line end of what was received, without waiting for more.  A line still
+  // arriving is left unread for the next call; if its start was already read,
+  // its rest is waited for up to timeout_ms instead.
+  void handleURCs(uint32_t timeout_ms, TinyGsmBudget& budget) {
+    int8_t index = 0;
+
+    waitResponseBegin(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                      nullptr);
+    uint32_t startMillis = millis();
+    uint32_t capped      = opDeadline.cap(budget.cap(timeout_ms));
+    do {
+      index = waitResponseStep(&budget);
+    } while (index == 0 && !budget.exhausted() &&
+             waitForRx(startMillis, capped));
+
+    // The rest of a line already partly read, up to its end
+    if (index == 0 && responseBuffer.length() > 0 &&
+        !responseBuffer.endsWith("\n")) {
+      TinyGsmBudget lineEnd(0);
+      startMillis = millis();
+      do {
+        index = waitResponseStep(&lineEnd);
+      } while (index == 0 && responseBuffer.length() > 0 &&
+               !responseBuffer.endsWith("\n") &&
+               waitForRx(startMillis, timeout_ms));
+      DBGCHK(Warn, index != 0 || responseBuffer.length() == 0 ||
+                       responseBuffer.endsWith("\n"),
+             "%s""URC line cut: %s", tag_tgm, responseBuffer.c_str())
+      if (index == 0 && responseBuffer.length() > 0 &&
+          !responseBuffer.endsWith("\n")) {
+        suspectURCLoss();
+      }
+    }
+
+    waitResponseEnd(index);
+  }
+
+  // waitResponseImpl() in three parts, so a response can also be waited for
+  // without blocking (see pollAT()): Begin once, Step as often as wanted (it
+  // only scans what has arrived), End once.
+
+  void waitResponseBegin(GsmConstStr r1, GsmConstStr r2, GsmConstStr r3,
+                         GsmConstStr r4, GsmConstStr r5, GsmConstStr r6,
+                         GsmConstStr r7) {
+    responseBuffer.clear();
 
 #ifdef TINY_GSM_DEBUG_DEEP
     DBG(GF("r1 <"), r1 ? r1 : GF("NULL"), GF("> r2 <"), r2 ? r2 : GF("NULL"),
@@ -718,305 +1777,354 @@ class TinyGsmModem {
         GF("> r5 <"), r5 ? r5 : GF("NULL"), GF("> r6 <"), r6 ? r6 : GF("NULL"),
         GF("> r7 <"), r7 ? r7 : GF("NULL"), '>');
 #endif
-    int8_t index = 0;
-    uint32_t startMillis = millis();
-    ms_delay_timer = millis() + MS_WAITRESPONSE_DELAY_TIMER_INTERVAL;
-    do {
-      if (millis() > ms_delay_timer) {
-        delay(10);
-        ms_delay_timer = millis() + MS_WAITRESPONSE_DELAY_TIMER_INTERVAL;
-      }
+    prepareResponseMatcher(r1, r2, r3, r4, r5, r6, r7);
+    prepareURCMatcher();
+    urcWait = r1 == nullptr && r2 == nullptr && r3 == nullptr &&
+              r4 == nullptr && r5 == nullptr && r6 == nullptr && r7 == nullptr;
+    responseMatcher.reset();
+    urcMatcher.reset();
+    atErrorCode = TINY_GSM_RESULT_OK;
+#if defined TINY_GSM_COROUTINES
+    urcScanning = false;
+#endif
+  }
+
+  // Scan whatever arrived, consuming only up to the matched response or URC;
+  // the rest stays buffered for the following reads.
+  // With a budget, it stops at the first line end after the budget is spent;
+  // a line the chunk ends within is then left unread (see handleURCs()).
+  // Returns the index of the matched response, 0 if none matched yet, or -1
+  // if +CME ERROR or +CMS ERROR ended the wait (see atErrorCode).
+  int8_t waitResponseStep(TinyGsmBudget* budget = nullptr) {
+    while (thisModem().bufferedStream.fill() > 0) {
       TINY_GSM_YIELD();
-      while (thisModem().stream.available() > 0) {
-        TINY_GSM_YIELD();
-        int a = thisModem().stream.read();
-        if (a <= 0) continue;  // Skip 0x00 bytes, just in case
-        DBGCHK(Error, a <= 0xFF, "%s""stream.read() not valid, returned > 0xFF: %i", tag_tgm, a)
-        data += static_cast<char>(a);
-        if (r1 && data.endsWith(r1)) {
-          index = 1;
-          goto finish;
-        } else if (r2 && data.endsWith(r2)) {
-          index = 2;
-          goto finish;
-        } else if (r3 && data.endsWith(r3)) {
-          index = 3;
-          goto finish;
-        } else if (r4 && data.endsWith(r4)) {
-          index = 4;
-          goto finish;
-        } else if (r5 && data.endsWith(r5)) {
-          index = 5;
-          goto finish;
-        } else if (r6 && data.endsWith(r6)) {
-          index = 6;
-          goto finish;
-        } else if (r7 && data.endsWith(r7)) {
-          index = 7;
-          goto finish;
+      const char* chunk = thisModem().bufferedStream.buffer();
+      size_t      n     = thisModem().bufferedStream.buffered();
+      size_t      used  = 0;
+      size_t      sunk  = 0;  // Up to here the chunk went to responseSink
+      int8_t      urc   = 0;
+      // Where the line being scanned starts, if within this chunk
+      bool     lineHere    = responseBuffer.length() == 0 ||
+                             responseBuffer.endsWith("\n");
+      size_t   lineStart   = 0;
+      unsigned lineLen     = responseBuffer.length();
+      uint32_t lineDropped = responseBuffer.dropped();
+      while (used < n && urc <= 0) {
+        if (budget != nullptr && budget->exhausted(used) &&
+            (responseBuffer.length() == 0 || responseBuffer.endsWith("\n"))) {
+          sinkChunk(chunk, sunk, used);
+          thisModem().bufferedStream.consume(used);
+          budget->spend(used);
+          return 0;
         }
-#if defined TINY_GSM_DEBUG
-        else if (data.endsWith(GFP(GSM_VERBOSE)) ||
-                 data.endsWith(GFP(GSM_VERBOSE_2))) {
-          // check how long the new line is
-          // should be either 1 ('\r' or '\n') or 2 ("\r\n"))
-          int len_atnl = strnlen(AT_NL, 3);
-          // Read out the verbose message, until the last character of the new
-          // line
-          data += thisModem().stream.readStringUntil(AT_NL[len_atnl]);
-#ifdef TINY_GSM_DEBUG_DEEP
-          data.trim();
-          DBG(GF("Verbose details <<<"), data, GF(">>>"));
-#endif
-          data = "";
-          goto finish;
+        char c = chunk[used++];
+        if (c == '\0') continue;  // Skip 0x00 bytes, just in case
+        responseBuffer.append(c);
+        if (c == '\n') {
+          lineHere    = true;
+          lineStart   = used;
+          lineLen     = responseBuffer.length();
+          lineDropped = responseBuffer.dropped();
         }
-#endif
-        else if (thisModem().handleURCs(data)) {
-          data = "";
+        int8_t match = responseMatcher.feed(c);
+        urc          = urcMatcher.feed(c);
+        if (!responseMatcher.valid()) { match = matchResponseEndsWith(); }
+        if (atErrorCode != TINY_GSM_RESULT_OK) {
+          // The <error> of +CME/+CMS ERROR, up to the end of the line
+          if (c == AT_NL[sizeof(AT_NL) - 2]) {
+            sinkChunk(chunk, sunk, used);
+            thisModem().bufferedStream.consume(used);
+            if (budget != nullptr) { budget->spend(used); }
+            return -1;
+          }
+          if (c >= '0' && c <= '9' && atError >= 0 && atError < 3000) {
+            atError = static_cast<int16_t>(atError * 10 + (c - '0'));
+          } else if (c != ' ' && c != '\r') {
+            atError = -1;  // Verbose text, see AT+CMEE
+          }
+          continue;
         }
-      } // while
-    } while (millis() - startMillis < timeout_ms);
-  finish:
-#ifdef TINY_GSM_DEBUG_DEEP
-    data.replace("\r", "←");
-    data.replace("\n", "↓");
-#endif
-    if (!index) {
-      data.trim();
-      if (data.length()) { DBG("### Unhandled:", data); }
-      data = "";
+        if (match > 0 && match < MS_MATCH_VERBOSE) {
+          sinkChunk(chunk, sunk, used);
+          thisModem().bufferedStream.consume(used);
+          if (budget != nullptr) { budget->spend(used); }
+          return match;
+        } else if (match >= MS_MATCH_VERBOSE) {
+          atErrorCode = match == MS_MATCH_VERBOSE ? TINY_GSM_RESULT_CME_ERROR
+                                                  : TINY_GSM_RESULT_CMS_ERROR;
+          atError     = 0;
+        }
+      }
+      // The line is still arriving, also if a URC handler would wait for it
+      bool lineCut = urc > 0 ? memchr(&chunk[used], '\n', n - used) == nullptr
+                             : !responseBuffer.endsWith("\n");
+      if (budget != nullptr && lineHere && lineCut &&
+          budget->exhausted(used) && responseBuffer.dropped() == lineDropped) {
+        // Spent within a line still arriving: it is scanned again next time
+        sinkChunk(chunk, sunk, lineStart);
+        responseBuffer.truncate(lineLen);
+        responseMatcher.reset();
+        urcMatcher.reset();
+        atErrorCode = TINY_GSM_RESULT_OK;
+        thisModem().bufferedStream.consume(lineStart);
+        budget->spend(lineStart);
+        return 0;
+      }
+      sinkChunk(chunk, sunk, used);
+      thisModem().bufferedStream.consume(used);
+      if (budget != nullptr) { budget->spend(used); }
+      // The URC handler reads its parameters from the stream itself.
+      if (urc > 0) {
+        uint32_t read    = thisModem().bufferedStream.consumed();
+        bool     handled = dispatchURC(urc);
+        if (budget != nullptr) {
+          budget->spend(thisModem().bufferedStream.consumed() - read);
+        }
+        if (handled) {
+          responseBuffer.clear();
+          if (responseSink != nullptr) { *responseSink = ""; }
+          responseMatcher.reset();
+          urcMatcher.reset();
+        }
+      }
+    } // while
+    return 0;
+  }
+
+  // The data of waitResponse(timeout_ms, data, ...) gets the bytes of the
+  // chunk scanned since sunk in one piece (without the 0x00 bytes skipped).
+  void sinkChunk(const char* chunk, size_t& sunk, size_t upTo) {
+    if (responseSink == nullptr || upTo <= sunk) { return; }
+    const char* p   = chunk + sunk;
+    const char* end = chunk + upTo;
+    sunk            = upTo;
+    while (p < end) {
+      const char* zero = static_cast<const char*>(memchr(p, '\0', end - p));
+      const char* stop = zero != nullptr ? zero : end;
+      responseSink->concat(p, static_cast<unsigned>(stop - p));
+      p = stop + 1;
+    }
+  }
+
+  int8_t waitResponseEnd(int8_t index) {
+    bool atFailed = index < 0;  // +CME/+CMS ERROR
+    if (atFailed) { index = 0; }
+    // The result of the command: its first response after sendAT(), and any
+    // error
+    if (atFailed) {
+      lastCmdResult = TinyGsmResult(atErrorCode, atError);
+      DBGLOG(Warn, "%s""%s: %hi", tag_tgm, lastCmdResult.text(), lastCmdResult.error)
+    } else if (index != 0 && responseMatcherKey[index - 1] == GFP(GSM_ERROR)) {
+      lastCmdResult = TinyGsmResult(TINY_GSM_RESULT_ERROR);
+    } else if (latencyKey != 0) {
+      lastCmdResult = TinyGsmResult(index != 0 ? TINY_GSM_RESULT_OK
+                                               : TINY_GSM_RESULT_TIMEOUT);
+    }
+    if (latencyKey != 0) { recordLatency(atFailed ? 1 : index); }
+    // Nothing is lost if the whole response went into the data of the caller
+    if (responseSink == nullptr) {
+      DBGCHK(Warn, responseBuffer.dropped() == 0,
+             "%s""response buffer overflow, %" PRIu32 " characters dropped",
+             tag_tgm, responseBuffer.dropped())
+      if (responseBuffer.dropped()) { suspectURCLoss(); }
+    }
+    if (atFailed) {
+      // The error line stays the response, see lastResponse()
+    } else if (!index) {
+      // Lines within the response window of a command belong to it
+      if (urcWait) {
+        publishUnknownURCs();
+      } else if (responseBuffer.length() > 0) {
+        DBGLOG(Debug, "%s""Unhandled: %s", tag_tgm, responseBuffer.c_str())
+      }
+      responseBuffer.clear();
+      if (responseSink != nullptr) { *responseSink = ""; }
     } else {
 #ifdef TINY_GSM_DEBUG_DEEP
-      DBG('<', index, '>', data);
+      DBG('<', index, '>', responseBuffer.c_str());
 #endif
     }
     return index;
-  } // int8_t waitResponseImpl(...)
+  }
 
 
-  // <MS>
-  bool waitResponsePlainImpl(unsigned long timeout_ms, std::string& data) {
-    DBGLOG(Debug, "[TinyGsmModem] >> timeout_ms: %lu", timeout_ms)
-    unsigned long ms_delay_timer;
-    unsigned long startMillis = millis();
-    ms_delay_timer = millis() + MS_WAITRESPONSE_DELAY_TIMER_INTERVAL;
-    bool ret = false;
-    data = "";
-    do {
-      if (millis() > ms_delay_timer) {
-        delay(10);
-        ms_delay_timer = millis() + MS_WAITRESPONSE_DELAY_TIMER_INTERVAL;
-      }
-      TINY_GSM_YIELD();
-      while (thisModem().stream.available() > 0) {
-        TINY_GSM_YIELD();
-        int a = thisModem().stream.read();
-        DBGLOG(Debug, "[TinyGsmModem] a: %i-%c", a, static_cast<char>(a))
-        if (a <= 0) continue;  // Skip 0x00 bytes, just in case
-        data += static_cast<char>(a);
-      } // while
-    } while ((millis() - startMillis < timeout_ms) && (!data.contains(GF("OK"))));
-    ret = data.contains(GF("OK"));
-    DBGLOG(Debug, "[TinyGsmModem] << return: %s, data: %s", DBGB2S(ret), data.c_str())
-    return ret;
-  }
+  // The lock is held only within one call: between the calls the request in
+  // flight is marked by atRunning, and whoever takes the modem meanwhile
+  // waits for its response first (settleAT()).  So the polling task may call
+  // blocking functions, and another task may take over the polling.
+  bool pollATImpl() {
+    // Finished by another owner of the modem, see settleAT()
+    TinyGsmATRequest* done = atSettled.exchange(nullptr);
+    if (done != nullptr) {
+      if (done->_cb) { done->_cb(*done, done->_cbArg); }
+      return true;
+    }
+
+    if (atRunning == nullptr && atQueue.empty()) { return false; }
+    // Somebody else is talking to the modem.  Not settling: the request in
+    // flight is stepped below.
+    if (!this->lockScheduler().tryAcquire(TINY_GSM_LOCK_SITE, false)) {
+      return true;
+    }
 
+    TinyGsmATRequest* req = atRunning;
+    if (req == nullptr) {
+      while ((req = atQueue.pop()) != nullptr && req->expired(millis())) {
+        // The deadline passed while waiting in the queue
+        DBGLOG(Warn, "[TinyGsmModem] AT%s expired in the queue", req->commandText())
+        req->_result = 0;
+        req->_state  = TINY_GSM_AT_DONE;
+        if (req->_cb) {
+          // Unlock for the callback, the next request is taken afterwards.
+          MS_TINY_GSM_SEM_GIVE_WAIT
+          req->_cb(*req, req->_cbArg);
+          return true;
+        }
+      }
+      if (req == nullptr) {
+        MS_TINY_GSM_SEM_GIVE_WAIT
+        return false;
+      }
+      req->_state = TINY_GSM_AT_RUNNING;
+      thisModem().sendAT(req->commandText());
+      waitResponseBegin(req->_r[0], req->_r[1], req->_r[2], req->_r[3],
+                        req->_r[4], req->_r[5], req->_r[6]);
+      atRunning = req;
+    }
 
-#ifdef MS_INACTIVE
-// <MS> OLD 0.11.5 with changes
-  #define dbglvlmsg Error
+    int8_t index = waitResponseStep();
+    if (index == 0 && !req->expired(millis())) {
+      MS_TINY_GSM_SEM_GIVE_WAIT
+      return true;
+    }
 
+    finishAT(index);
+    MS_TINY_GSM_SEM_GIVE_WAIT
 
-  int msCallLevelWaitResponse = 0;
-  int8_t waitResponse(uint32_t timeout_ms, String& data,
-                      GsmConstStr r1 = GFP(GSM_OK),
-                      GsmConstStr r2 = GFP(GSM_ERROR),
-#if defined TINY_GSM_DEBUG
-                      GsmConstStr r3 = GFP(GSM_CME_ERROR),
-                      GsmConstStr r4 = GFP(GSM_CMS_ERROR),
-#else
-                      GsmConstStr r3 = NULL, GsmConstStr r4 = NULL,
-#endif
-                      GsmConstStr r5 = NULL) {
-    msCallLevelWaitResponse++;
-    DBGLOG(Debug, "[TinyGsmSim7080]-%i >>", msCallLevelWaitResponse)
-    DBGCHK(Warn, MS_TINY_GSM_SEM_BLOCKED, "[TinyGsmSim7080]-%i Not blocked by calling function", msCallLevelWaitResponse)
+    if (req->_cb) { req->_cb(*req, req->_cbArg); }
+    return true;
+  }
 
-    data.reserve(64);
-    uint8_t  index       = 0;
-    uint32_t startMillis = millis();
+  // The request in flight got its response index (0: none in time).  Called
+  // with the modem locked.
+  void finishAT(int8_t index) {
+    TinyGsmATRequest* req = atRunning;
+    index                 = waitResponseEnd(index);
+    for (const char* p = responseBuffer.c_str(); *p; p++) {
+      req->_response.append(*p);
+    }
+    req->_result = index;
+    req->_state  = TINY_GSM_AT_DONE;
+    DBGCHK(Warn, index != 0, "[TinyGsmModem] AT%s timed out", req->commandText())
+    atRunning = nullptr;
+  }
 
-//    const unsigned long ms_timeout = 300;
-//    uint32_t ms_startMillisDelay = millis();
+  static void settleATHook(void* arg) {
+    static_cast<TinyGsmModem*>(arg)->settleAT();
+  }
 
+  // Called by the lock scheduler for every new owner of the modem: a command
+  // of submitAT() still in flight gets its response (up to its deadline)
+  // before the owner uses the AT channel.  Its callback runs with the next
+  // pollAT().
+  void settleAT() {
+    TinyGsmATRequest* req = atRunning;
+    if (req == nullptr) { return; }
+    uint32_t startMillis = millis();
+    uint32_t timeout_ms  = req->remaining(startMillis);
+    int8_t   index       = 0;
     do {
+      index = waitResponseStep();
+    } while (index == 0 && waitForRx(startMillis, timeout_ms));
+    finishAT(index);
+    atSettled = req;
+  }
 
-//
-      TINY_GSM_YIELD();
-/*
-      if (millis() - ms_timeout > ms_startMillisDelay) { 
-          delay(10);
-          DBGLOG(Debug, "[TinyGsmSim7080] time-out-1")
-          ms_startMillisDelay = millis();
-      }
-*/      
-      while (stream.available() > 0) {
+#if defined TINY_GSM_RX_PUMP
+  static bool rxPumpStep(void* arg) {
+    return static_cast<TinyGsmModem*>(arg)->rxPumpStepImpl();
+  }
 
-//
-//
-        TINY_GSM_YIELD();
-/*        
-        if (millis() - ms_timeout > ms_startMillisDelay) { 
-            delay(10);
-            DBGLOG(Debug, "[TinyGsmSim7080] time-out-2")
-            ms_startMillisDelay = millis();
-        }
-*/
-        int8_t a = stream.read();
-        if (a <= 0) continue;  // Skip 0x00 bytes, just in case
-        data += static_cast<char>(a);
-        if (r1 && data.endsWith(r1)) {
-          index = 1;
-          goto finish;
-        } else if (r2 && data.endsWith(r2)) {
-          index = 2;
-          goto finish;
-        } else if (r3 && data.endsWith(r3)) {
-#if defined TINY_GSM_DEBUG
-          if (r3 == GFP(GSM_CME_ERROR)) {
-            streamSkipUntil('\n');  // Read out the error
-          }
-#endif
-          index = 3;
-          goto finish;
-        } else if (r4 && data.endsWith(r4)) {
-          index = 4;
-          goto finish;
-        } else if (r5 && data.endsWith(r5)) {
-          index = 5;
-          goto finish;
-        } else if (data.endsWith(GF("+CARECV:"))) {
-          int8_t  mux = streamGetIntBefore(',');
-          int16_t len = streamGetIntBefore('\n');
-
-          DBGLOG(Info, "[TinyGsmSim7080]-%i mux: %hhi, len: %hi", msCallLevelWaitResponse, mux, len);
-
-          if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-            sockets[mux]->got_data = true;
-// <MS>            
-//            if (len >= 0 && len <= 1024) { sockets[mux]->sock_available = len; }
-/* */            
-            if (len >= 0) { sockets[mux]->sock_available = len; }
-            if ((len < 0) || (len > TINY_GSM_RX_BUFFER)) {
-              DBGLOG(Warn, "[TinyGsmSim7080]-%i WARN len out of range: %hi", msCallLevelWaitResponse, len);
-            }
-           
-// <MS>            
-          }
-          data = "";
-          DBGLOG(Info, "[TinyGsmSim7080]-%i Got Data: %hi on mux: %hhi", msCallLevelWaitResponse, len, mux)
-        } else if (data.endsWith(GF("+CADATAIND:"))) {
-          int8_t mux = streamGetIntBefore('\n');
-          if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-            sockets[mux]->got_data = true;
-          }
-          data = "";
-          DBGLOG(Info, "[TinyGsmSim7080]-%i Got data on mux: %hhi", msCallLevelWaitResponse, mux)
-        } else if (data.endsWith(GF("+CASTATE:"))) {
-          int8_t mux   = streamGetIntBefore(',');
-          int8_t state = streamGetIntBefore('\n');
-          if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-            if (state != 1) {
-              sockets[mux]->sock_connected = false;
-              DBGLOG(Info, "[TinyGsmSim7080]-%i Closed, mux: %hhi, state: %hhi", msCallLevelWaitResponse, mux, state)
-            }
-          }
-          data = "";
-        } else if (data.endsWith(GF("*PSNWID:"))) {
-          streamSkipUntil('\n');  // Refresh network name by network
-          DBGLOG(dbglvlmsg, "[TinyGsmSim7080]-%i Network name updated: %s", msCallLevelWaitResponse, asCharString(data.c_str(), 0, data.length()).c_str())
-          data = "";
-        } else if (data.endsWith(GF("*PSUTTZ:"))) {
-          streamSkipUntil('\n');  // Refresh time and time zone by network
-          DBGLOG(dbglvlmsg, "[TinyGsmSim7080]-%i Network time and time zone updated: %s", msCallLevelWaitResponse, asCharString(data.c_str(), 0, data.length()).c_str())
-          data = "";
-        } else if (data.endsWith(GF("+CTZV:"))) {
-          streamSkipUntil('\n');  // Refresh network time zone by network
-          DBGLOG(dbglvlmsg, "[TinyGsmSim7080]-%i Network time zone updated: %s", msCallLevelWaitResponse, asCharString(data.c_str(), 0, data.length()).c_str())
-          data = "";
-        } else if (data.endsWith(GF("DST: "))) {
-          streamSkipUntil('\n');  // Refresh Network Daylight Saving Time by network
-          DBGLOG(dbglvlmsg, "[TinyGsmSim7080]-%i Daylight savings time state updated: %s", msCallLevelWaitResponse, asCharString(data.c_str(), 0, data.length()).c_str())
-          data = "";
-        } else if (data.endsWith(GF(GSM_NL "SMS Ready" GSM_NL))) {
-          DBGLOG(Warn, "[TinyGsmSim7080]-%i Unexpected module reset: %s", msCallLevelWaitResponse, asCharString(data.c_str(), 0, data.length()).c_str())
-          data = "";
-// <MS>          
-//          init();
-// <MS>          
-          data = "";
-        } else if (data.indexOf(GF("VOLTAGE")) >= 0) {
-          DBGLOG(dbglvlmsg, "[TinyGsmSim7080]-%i Voltage-message: %s.", msCallLevelWaitResponse, asCharString(data.c_str(), 0, data.length()).c_str())
-          data = "";
-        } else {
-          String tmp = data;
-          tmp.replace(GSM_NL, "/");
-          tmp.trim();
-          if ((tmp.length() > 10) && 
-              (tmp.indexOf(GF("CNACT")) < 0) && 
-              (tmp.indexOf(GF("SLEDS")) < 0) && 
-              (tmp.indexOf(GF("CNET")) < 0) && 
-              (tmp.indexOf(GF("CSGS")) < 0) && 
-              (tmp.indexOf(GF("CGNAP")) < 0) && 
-              (tmp.indexOf(GF("CLTS")) < 0) )
-            {
-            DBGLOG(dbglvlmsg, "[TinyGsmSim7080]-%i Unknown message: '%s' (%s)", 
-              msCallLevelWaitResponse, asCharString(tmp.c_str(), 0, tmp.length()).c_str(), asHexString(tmp.c_str(), 0, tmp.length()).c_str())
-          }
-        }
+  // One round of the rx pump task.  The modem lock decides who reads the
+  // pipe: if a requester holds it, the bytes are left for its waitResponse.
+  bool rxPumpStepImpl() {
+    bool work = thisModem().rxPump.pull() > 0;
+    // While an asynchronous command is in flight, its waitResponse handles
+    // the URCs.
+    if (pollATImpl()) { work = true; }
+    if (atRunning == nullptr && thisModem().stream.available() &&
+        MS_TINY_GSM_SEM_TRY_TAKE) {
+      while (thisModem().stream.available()) {
+        thisModem().waitResponse(15, nullptr, nullptr);
       }
-    } while (millis() - startMillis < timeout_ms);
-  finish:
-    if (!index) {
-      data.trim();
-      if (data.length()) { 
-        DBGLOG(Warn, "[TinyGsmSim7080]-%i Unhandled: '%s' (%s)", 
-          msCallLevelWaitResponse, 
-          asCharString(data.c_str(), 0, data.length()).c_str(), 
-          asHexString(data.c_str(), 0, data.length()).c_str() )
-        }
-      data = "";
+      MS_TINY_GSM_SEM_GIVE_WAIT
+      work = true;
     }
-    data.replace(GSM_NL, "/");
-    // DBG('<', index, '>', data);
-/**/
-#if defined TINY_GSM_DEBUG
-//    if (index != 1) {
-      String r1s(r1); r1s.trim();
-      String r2s(r2); r2s.trim();
-      String r3s(r3); r3s.trim();
-      String r4s(r4); r4s.trim();
-      String r5s(r5); r5s.trim();
-      DBGLOG(Info, "[TinyGsmSim7080]-%i Input r1:%s, r2:%s, r3:%s, r4:%s, r5:%s", 
-        msCallLevelWaitResponse, 
-        asCharString(r1s.c_str(), 0, r1s.length()).c_str(),
-        asCharString(r2s.c_str(), 0, r2s.length()).c_str(),
-        asCharString(r3s.c_str(), 0, r3s.length()).c_str(),
-        asCharString(r4s.c_str(), 0, r4s.length()).c_str(),
-        asCharString(r5s.c_str(), 0, r5s.length()).c_str()
-        )
-      DBGLOG(Info, "[TinyGsmSim7080]-%i Return data: %s, return index: %hhu", msCallLevelWaitResponse, asCharString(data.c_str(), 0, data.length()).c_str(), index)
-//    }
+    if (thisModem().pumpSocketsImpl()) { work = true; }
+    return work;
+  }
 #endif
 
-    DBGLOG(Debug, "[TinyGsmSim7080]-%i << return index: %hhu", msCallLevelWaitResponse, index)
-    msCallLevelWaitResponse--;
+#if defined TINY_GSM_COROUTINES
+  static bool pollEvents(void* arg) {
+    return static_cast<TinyGsmModem*>(arg)->pollEventsImpl();
+  }
 
-    return index;
-  } // waitResponse(...)
+  // Poll function of the event loop: run the asynchronous commands and, while
+  // the modem is idle, handle the URCs which have arrived and read the data
+  // of the sockets (see TinyGsmTCP::fetchSocketsImpl()).  The URC scan is
+  // begun once and then only stepped, so a URC arriving in pieces is matched
+  // across polls; the sockets are only read between URC lines.
+  bool pollEventsImpl() {
+    bool work = pollAT();
+#if defined TINY_GSM_RX_PUMP
+    // The pump task handles the URCs and reads the sockets
+    if (rxPumpRunning()) { return work; }
+#endif
+    if (atRunning == nullptr &&
+        (thisModem().stream.available() || thisModem().fetchDue()) &&
+        MS_TINY_GSM_SEM_TRY_TAKE) {
+      if (!urcScanning) {
+        waitResponseBegin(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                          nullptr);
+        urcScanning = true;
+      }
+      waitResponseStep();
+      if (responseBuffer.length() == 0 || responseBuffer.endsWith("\n")) {
+        if (thisModem().fetchSocketsImpl()) { urcScanning = false; }
+      }
+      MS_TINY_GSM_SEM_GIVE_WAIT
+      work = true;
+    }
+    return work;
+  }
+#endif
 
-#endif // INACTIVE
+  // <MS>
+  bool waitResponsePlainImpl(unsigned long timeout_ms, std::string& data) {
+    DBGLOG(Debug, "[TinyGsmModem] >> timeout_ms: %lu", timeout_ms)
+    timeout_ms = opDeadline.cap(static_cast<uint32_t>(timeout_ms));
+    uint32_t startMillis = millis();
+    bool ret = false;
+    data = "";
+    do {
+      while (thisModem().bufferedStream.fill() > 0) {
+        TINY_GSM_YIELD();
+        const char* chunk = thisModem().bufferedStream.buffer();
+        size_t      n     = thisModem().bufferedStream.buffered();
+        for (size_t i = 0; i < n; i++) {
+          // Skip 0x00 bytes, just in case
+          if (chunk[i] != '\0') { data += chunk[i]; }
+        }
+        thisModem().bufferedStream.consume(n);
+        DBGLOG(Debug, "[TinyGsmModem] received %u bytes", n)
+      } // while
+    } while (!data.contains(GF("OK")) && waitForRx(startMillis, timeout_ms));
+    ret = data.contains(GF("OK"));
+    if (latencyKey != 0) { recordLatency(ret ? 1 : 0); }
+    DBGLOG(Debug, "[TinyGsmModem] << return: %s, data: %s", DBGB2S(ret), data.c_str())
+    return ret;
+  }
 
   String getModemInfoImpl() {
     thisModem().sendAT(GF("I"));  // 3GPP TS 27.007
@@ -1027,29 +2135,48 @@ class TinyGsmModem {
   }
 
   String getModemNameImpl() {
-    String manufacturer = getModemManufacturer();
-    String model        = getModemModel();
+    String manufacturer = identityManufacturer();
+    String model        = identityModel();
     String name         = manufacturer + String(" ") + model;
     DBG("### Modem:", name);
     return name;
   }
 
-  // Gets the modem manufacturer
+  // The manufacturer and the model, read from the modem if not known yet.
+  // Called with the modem locked, see invalidateIdentity().
+  String identityManufacturer() {
+    if (!identity.manufacturer.length()) { identity.manufacturer = thisModem().getModemManufacturerImpl(); }
+    if (!identity.manufacturer.length()) { return MODEM_MANUFACTURER; }
+    return identity.manufacturer;
+  }
+
+  String identityModel() {
+    if (!identity.model.length()) { identity.model = thisModem().getModemModelImpl(); }
+    if (!identity.model.length()) { return MODEM_MODEL; }
+    return identity.model;
+  }
+
+  // Forget the identity; called with the modem locked, e.g. by the handler
+  // of the "SMS Ready" URC.
+  void forgetIdentity() {
+    identity = {};
+  }
+
+  // Gets the modem manufacturer; the identity functions return "" if the
+  // modem did not answer, see getModemManufacturer().
   String getModemManufacturerImpl() {
-    String manufacturer = MODEM_MANUFACTURER;
     thisModem().sendAT(GF("+CGMI"));  // 3GPP TS 27.007 standard
     String res;
-    if (thisModem().waitResponse(1000L, res) != 1) { return manufacturer; }
+    if (thisModem().waitResponse(1000L, res) != 1) { return ""; }
     thisModem().cleanResponseString(res);
     return res;
   }
 
   // Gets the modem hardware version
   String getModemModelImpl() {
-    String model = MODEM_MODEL;
     thisModem().sendAT(GF("+CGMM"));  // 3GPP TS 27.007 standard
     String res;
-    if (thisModem().waitResponse(1000L, res) != 1) { return model; }
+    if (thisModem().waitResponse(1000L, res) != 1) { return ""; }
     thisModem().cleanResponseString(res);
     return res;
   }
@@ -1058,7 +2185,7 @@ class TinyGsmModem {
   String getModemRevisionImpl() {
     thisModem().sendAT(GF("+CGMR"));  // 3GPP TS 27.007 standard
     String res;
-    if (thisModem().waitResponse(1000L, res) != 1) { return "unknown"; }
+    if (thisModem().waitResponse(1000L, res) != 1) { return ""; }
     thisModem().cleanResponseString(res);
     return res;
   }
@@ -1067,7 +2194,7 @@ class TinyGsmModem {
   String getModemSerialNumberImpl() {
     thisModem().sendAT(GF("+CGSN"));  // 3GPP TS 27.007 standard
     String res;
-    if (thisModem().waitResponse(1000L, res) != 1) { return "unknown"; }
+    if (thisModem().waitResponse(1000L, res) != 1) { return ""; }
     thisModem().cleanResponseString(res);
     return res;
   }
@@ -1143,6 +2270,87 @@ class TinyGsmModem {
     if (thisModem().waitResponse() != 1) { return ""; }
     return res;
   }
+
+  /*
+   * Response and URC matching
+   */
+ protected:
+  TinyGsmMatcher<TINY_GSM_RESPONSE_MATCHER_STATES, TINY_GSM_MATCHER_CLASSES>
+      responseMatcher;
+  GsmConstStr responseMatcherKey[7] = {};
+  bool        responseMatcherBuilt  = false;
+  TinyGsmMatcher<TINY_GSM_URC_MATCHER_STATES, TINY_GSM_MATCHER_CLASSES>
+       urcMatcher;
+  bool urcMatcherBuilt = false;
+  uint8_t urcTableSize = 0;  /// Number of entries in the URC table of the modem
+
+  struct URCHandlerEntry {
+    GsmConstStr       prefix;
+    TinyGsmURCHandler handler;
+    void*             arg;
+  };
+  URCHandlerEntry urcHandlers[TINY_GSM_URC_HANDLERS];  /// Added by the application
+  uint8_t         urcHandlerCount = 0;
+
+  struct Completion {
+    char prefix[24];  /// Start of the line, "": free
+    char line[40];    /// The rest of it, once done
+    bool done;
+  };
+  Completion completions[TINY_GSM_COMPLETIONS] = {};  /// See expectCompletion()
+
+  TinyGsmEventQueue<TINY_GSM_EVENT_QUEUE_SIZE> events;  /// See pollEvent()
+  bool urcLossSuspected = false;  /// See suspectURCLoss()
+  bool urcWait          = false;  /// No response wanted, see publishUnknownURCs()
+
+  TinyGsmDeadline opDeadline;          /// Of the running operation, see beginDeadline()
+  bool            opTimedOut = false;  /// See operationResult()
+
+  TinyGsmResult     lastCmdResult;                      /// See operationResult()
+  TinyGsmResultCode atErrorCode = TINY_GSM_RESULT_OK;  /// +CME/+CMS ERROR being read
+  int16_t           atError     = 0;                   /// Its <error>
+
+  TinyGsmScheduler modemLock;  /// The AT channel, see lockScheduler()
+
+  TinyGsmLatency  latency;             /// Of the AT commands, see saveLatency()
+  uint32_t        latencyKey     = 0;  /// Of the command waiting for its response
+  uint32_t        latencySent    = 0;  /// millis() it was sent
+  uint32_t        latencyLearned = 0;  /// Learned timeout applied, 0: none
+  uint32_t        latencyGiven   = 0;  /// The timeout in the code it replaced
+  TinyGsmDeadline lateResponse;        /// Of a command past its learned timeout
+
+  /*
+   * Identity of the modem and the SIM, read once, see invalidateIdentity()
+   */
+  struct Identity {
+    String manufacturer;
+    String model;
+    String revision;
+    String serial;
+    String imei;
+    String ccid;
+    String imsi;
+  };
+  Identity identity;
+
+  TinyGsmStatusCache<int16_t> csqCache;  /// See getSignalQuality()
+
+  TinyGsmResponseBuffer<TINY_GSM_RESPONSE_BUFFER_SIZE,
+                        TINY_GSM_RESPONSE_BUFFER_OVERFLOW>
+      responseBuffer;
+  String* responseSink = nullptr;  /// Data of waitResponse(timeout_ms, data, ...)
+
+  TinyGsmATQueue                 atQueue;             /// Submitted asynchronous commands
+  std::atomic<TinyGsmATRequest*> atRunning{nullptr};  /// The command in flight, if any
+  std::atomic<TinyGsmATRequest*> atSettled{nullptr};  /// Done by settleAT(), callback due
+
+  TinyGsmRxSignal rxSignal;         /// Bytes arrived, see waitForRx()
+  uint32_t        rxBusySince = 0;  /// Last time waitForRx() blocked
+
+#if defined TINY_GSM_COROUTINES
+  TinyGsmEventLoop coLoop{pollEvents, this};  /// Resumes the coroutines
+  bool urcScanning = false;  /// The idle URC scan is begun, see pollEventsImpl()
+#endif
 }; // class TinyGsmModem
 
 #endif  // SRC_TINYGSMMODEM_H_
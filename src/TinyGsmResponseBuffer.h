@@ -0,0 +1,116 @@
+/**
+ * @file       TinyGsmResponseBuffer.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMRESPONSEBUFFER_H_
+#define SRC_TINYGSMRESPONSEBUFFER_H_
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief What to do if a response does not fit into the response buffer.
+ */
+enum TinyGsmOverflowPolicy {
+  /// Keep the first characters, drop everything received after the buffer
+  /// became full.
+  TINY_GSM_OVERFLOW_KEEP_HEAD = 0,
+  /// Keep the last characters: if the buffer is full, the oldest half is
+  /// dropped, so the buffer always ends with the latest characters received.
+  TINY_GSM_OVERFLOW_KEEP_TAIL = 1,
+};
+
+/**
+ * @brief Fixed-capacity, zero terminated character buffer collecting the
+ * response of an AT command without any heap allocation.
+ *
+ * @tparam N The maximum number of characters (without the terminating zero).
+ * @tparam policy What to do if more than N characters are appended.
+ */
+template <unsigned N, TinyGsmOverflowPolicy policy>
+class TinyGsmResponseBuffer {
+ public:
+  TinyGsmResponseBuffer() {
+    clear();
+  }
+
+  /**
+   * @brief Empty the buffer and reset the number of dropped characters.
+   */
+  void clear() {
+    _len     = 0;
+    _dropped = 0;
+    _b[0]    = '\0';
+  }
+
+  /**
+   * @brief Append a character, applying the overflow policy if the buffer is
+   * full.
+   *
+   * @param c The character to append.
+   * @return *true* The character was appended without dropping anything.
+   * @return *false* Characters were dropped.
+   */
+  bool append(char c) {
+    if (_len < N) {
+      _b[_len++] = c;
+      _b[_len]   = '\0';
+      return true;
+    }
+    _dropped++;
+    if (policy == TINY_GSM_OVERFLOW_KEEP_TAIL) {
+      unsigned keep = N / 2;
+      memmove(_b, &_b[_len - keep], keep);
+      _dropped += _len - keep - 1;
+      _len       = keep;
+      _b[_len++] = c;
+      _b[_len]   = '\0';
+    }
+    return false;
+  }
+
+  /**
+   * @brief Check if the buffer ends with a string.
+   */
+  bool endsWith(const char* s) const {
+    if (s == nullptr) { return false; }
+    size_t n = strlen(s);
+    return n <= _len && memcmp(&_b[_len - n], s, n) == 0;
+  }
+
+  /**
+   * @brief Drop the characters behind the first len ones.
+   */
+  void truncate(unsigned len) {
+    if (len < _len) {
+      _len     = len;
+      _b[_len] = '\0';
+    }
+  }
+
+  const char* c_str() const {
+    return _b;
+  }
+
+  unsigned length() const {
+    return _len;
+  }
+
+  /**
+   * @brief The number of characters dropped since the last clear().
+   */
+  uint32_t dropped() const {
+    return _dropped;
+  }
+
+ private:
+  char     _b[N + 1];  /// The characters, zero terminated
+  unsigned _len;       /// The number of characters in the buffer
+  uint32_t _dropped;   /// The number of characters lost by overflow
+};
+
+#endif  // SRC_TINYGSMRESPONSEBUFFER_H_
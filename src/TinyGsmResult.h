@@ -0,0 +1,63 @@
+/**
+ * @file       TinyGsmResult.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMRESULT_H_
+#define SRC_TINYGSMRESULT_H_
+
+#include "TinyGsmCommon.h"
+
+/**
+ * @brief How a command or an operation ended.
+ */
+enum TinyGsmResultCode : uint8_t {
+  TINY_GSM_RESULT_OK        = 0,
+  TINY_GSM_RESULT_ERROR     = 1,  /// ERROR, or a response telling the failure
+  TINY_GSM_RESULT_CME_ERROR = 2,  /// +CME ERROR: <error>
+  TINY_GSM_RESULT_CMS_ERROR = 3,  /// +CMS ERROR: <error>
+  TINY_GSM_RESULT_TIMEOUT   = 4,  /// No response, or the deadline passed
+};
+
+/**
+ * @brief The result of a command or an operation, with the error code the
+ * modem gave.
+ *
+ * Converts to bool (true: ok), so it can be used like the bool the functions
+ * returned before:
+ *
+ * @code
+ * TinyGsmResult r = modem.gprsConnect(apn);
+ * if (!r && r.code == TINY_GSM_RESULT_CME_ERROR && r.error == 30) {
+ *   // No network service, try again later
+ * }
+ * @endcode
+ */
+struct TinyGsmResult {
+  TinyGsmResultCode code  = TINY_GSM_RESULT_OK;
+  int16_t           error = 0;  /// The <error> of +CME/+CMS ERROR (-1 if not numeric), or of the response telling the failure
+
+  TinyGsmResult() {}
+  explicit TinyGsmResult(TinyGsmResultCode c, int16_t e = 0)
+      : code(c), error(e) {}
+
+  operator bool() const {
+    return code == TINY_GSM_RESULT_OK;
+  }
+
+  const char* text() const {
+    switch (code) {
+      case TINY_GSM_RESULT_OK: return "OK";
+      case TINY_GSM_RESULT_ERROR: return "ERROR";
+      case TINY_GSM_RESULT_CME_ERROR: return "+CME ERROR";
+      case TINY_GSM_RESULT_CMS_ERROR: return "+CMS ERROR";
+      case TINY_GSM_RESULT_TIMEOUT: return "timeout";
+    }
+    return "?";
+  }
+};
+
+#endif  // SRC_TINYGSMRESULT_H_
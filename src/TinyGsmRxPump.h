@@ -0,0 +1,258 @@
+/**
+ * @file       TinyGsmRxPump.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMRXPUMP_H_
+#define SRC_TINYGSMRXPUMP_H_
+
+#include "TinyGsmCommon.h"
+#include "TinyGsmRxSignal.h"
+#include <atomic>
+
+#if !defined(ESP_PLATFORM)
+#include <thread>
+#endif
+
+// Stack size and priority of the pump task (FreeRTOS only).
+#ifndef TINY_GSM_RX_PUMP_STACK
+#define TINY_GSM_RX_PUMP_STACK 4096
+#endif
+
+#ifndef TINY_GSM_RX_PUMP_PRIORITY
+#define TINY_GSM_RX_PUMP_PRIORITY 5
+#endif
+
+/**
+ * @brief Stream in front of the modem UART, filled by a reader task.
+ *
+ * While the pump is running, only the pump reads the UART: whatever arrives
+ * is moved into a lock-free single-producer/single-consumer pipe, and all
+ * readers of this stream (the requester waiting for its response, or the
+ * pump itself dispatching URCs) get the bytes from there, in order.  A reader
+ * finding the pipe empty pulls from the UART itself, so a reader never waits
+ * for the pump task to be scheduled.  Moving bytes into the pipe is guarded by
+ * a flag, so there is only ever one producer.
+ *
+ * With a TinyGsmRxSignal the idle task sleeps until the UART notifies it
+ * (or the idle time passed), and waiters are woken as soon as bytes are in
+ * the pipe.
+ *
+ * While the pump is stopped, this stream reads the rest of the pipe and then
+ * the UART directly.  Writing always goes to the UART.
+ *
+ * The task runs on FreeRTOS (ESP_PLATFORM) or as a std::thread otherwise, so
+ * the pump can be used with a fake Stream on a host as well.
+ *
+ * @tparam N The size of the pipe.
+ */
+template <size_t N>
+class TinyGsmRxPump : public Stream {
+ public:
+  /**
+   * @brief One step of the work of the pump task.
+   *
+   * @return *true* Something was done; the next step follows immediately.
+   * @return *false* Nothing to do; the task sleeps for the idle time.
+   */
+  typedef bool (*StepFunction)(void* arg);
+
+  /**
+   * @param uart The modem UART.
+   * @param signal Woken after bytes were moved into the pipe, and waited on
+   * by the idle task; optional.
+   */
+  explicit TinyGsmRxPump(Stream& uart, TinyGsmRxSignal* signal = nullptr)
+      : _uart(uart), _signal(signal) {
+    setTimeout(uart.getTimeout());
+  }
+
+  ~TinyGsmRxPump() {
+    stop();
+  }
+
+  /*
+   * Stream
+   */
+  int available() override {
+    if (!_running) { return static_cast<int>(size()) + _uart.available(); }
+    if (!size()) { pull(); }
+    return static_cast<int>(size());
+  }
+
+  int read() override {
+    if (!size()) {
+      if (!_running) { return _uart.read(); }
+      pull();
+      if (!size()) { return -1; }
+    }
+    size_t r = _r.load(std::memory_order_relaxed);
+    int    c = static_cast<uint8_t>(_b[r]);
+    _r.store((r + 1) % (N + 1), std::memory_order_release);
+    return c;
+  }
+
+  int peek() override {
+    if (!size()) {
+      if (!_running) { return _uart.peek(); }
+      pull();
+      if (!size()) { return -1; }
+    }
+    return static_cast<uint8_t>(_b[_r.load(std::memory_order_relaxed)]);
+  }
+
+  using Stream::readBytes;
+  size_t readBytes(char* buf, size_t length) override {
+    size_t n = 0;
+    size_t avail;
+    while (n < length && (avail = size()) > 0) {
+      size_t r = _r.load(std::memory_order_relaxed);
+      size_t c = TinyGsmMin(TinyGsmMin(avail, N + 1 - r), length - n);
+      memcpy(buf + n, &_b[r], c);
+      _r.store((r + c) % (N + 1), std::memory_order_release);
+      n += c;
+    }
+    if (n < length && !_running) {
+      n += _uart.readBytes(buf + n, length - n);
+    } else if (n < length) {
+      n += Stream::readBytes(buf + n, length - n);
+    }
+    return n;
+  }
+
+  size_t write(uint8_t c) override {
+    return _uart.write(c);
+  }
+
+  size_t write(const uint8_t* buf, size_t size) override {
+    return _uart.write(buf, size);
+  }
+
+  void flush() override {
+    _uart.flush();
+  }
+
+  /*
+   * Pump
+   */
+
+  /**
+   * @brief Move whatever the UART has available into the pipe, as far as it
+   * fits.  Does nothing if an other thread is doing it right now.
+   *
+   * @return *size_t* The number of bytes moved.
+   */
+  size_t pull() {
+    if (_pulling.test_and_set(std::memory_order_acquire)) { return 0; }
+    size_t moved = 0;
+    int    a     = _uart.available();
+    while (a > 0) {
+      size_t w    = _w.load(std::memory_order_relaxed);
+      size_t r    = _r.load(std::memory_order_acquire);
+      // Contiguous free space behind w, one slot stays empty.
+      size_t room = (r > w) ? (r - w - 1) : (N + 1 - w - (r == 0 ? 1 : 0));
+      if (room == 0) { break; }
+      size_t n = _uart.readBytes(&_b[w], TinyGsmMin(room, static_cast<size_t>(a)));
+      if (n == 0) { break; }
+      _w.store((w + n) % (N + 1), std::memory_order_release);
+      moved += n;
+      a -= static_cast<int>(n);
+    }
+    _pulling.clear(std::memory_order_release);
+    if (moved && _signal) { _signal->wake(); }
+    return moved;
+  }
+
+  /**
+   * @brief The number of bytes in the pipe.
+   */
+  size_t size() const {
+    size_t w = _w.load(std::memory_order_acquire);
+    size_t r = _r.load(std::memory_order_relaxed);
+    return (w + N + 1 - r) % (N + 1);
+  }
+
+  /**
+   * @brief Start the pump task.
+   *
+   * @param step The work of the task, called in a loop.
+   * @param arg The argument of step.
+   * @param idle_ms How long to sleep if step had nothing to do.
+   * @return *true* The task is running.
+   */
+  bool start(StepFunction step, void* arg, uint32_t idle_ms) {
+    if (_running) { return true; }
+    _step    = step;
+    _arg     = arg;
+    _idle_ms = idle_ms;
+    _stop    = false;
+    _running = true;
+#if defined(ESP_PLATFORM)
+    if (xTaskCreate(task, "TinyGsmRxPump", TINY_GSM_RX_PUMP_STACK, this,
+                    TINY_GSM_RX_PUMP_PRIORITY, &_task) != pdPASS) {
+      _running = false;
+    }
+#else
+    _thread = std::thread(task, this);
+#endif
+    return _running;
+  }
+
+  /**
+   * @brief Stop the pump task and wait until it has finished its last step.
+   * Must not be called from the task itself or with the modem locked.
+   */
+  void stop() {
+    if (!_running) { return; }
+    _stop = true;
+#if defined(ESP_PLATFORM)
+    while (_running) { delay(1); }
+#else
+    if (_thread.joinable()) { _thread.join(); }
+#endif
+  }
+
+  bool running() const {
+    return _running;
+  }
+
+ private:
+  static void task(void* arg) {
+    TinyGsmRxPump* pump = static_cast<TinyGsmRxPump*>(arg);
+    while (!pump->_stop) {
+      if (pump->_step(pump->_arg)) { continue; }
+      // Sleep until the UART notifies, if it does.
+      if (pump->_signal && pump->_signal->active()) {
+        pump->_signal->wait(pump->_idle_ms);
+      } else {
+        delay(pump->_idle_ms);
+      }
+    }
+    pump->_running = false;
+#if defined(ESP_PLATFORM)
+    vTaskDelete(nullptr);
+#endif
+  }
+
+  Stream&             _uart;                         /// The modem UART
+  TinyGsmRxSignal*    _signal;                       /// Bytes arrived, or nullptr
+  char                _b[N + 1];                     /// The pipe
+  std::atomic<size_t> _r{0};                         /// Read position
+  std::atomic<size_t> _w{0};                         /// Write position
+  std::atomic_flag    _pulling = ATOMIC_FLAG_INIT;   /// A thread fills the pipe
+  std::atomic<bool>   _running{false};               /// The task is running
+  std::atomic<bool>   _stop{false};                  /// The task shall stop
+  StepFunction        _step    = nullptr;            /// The work of the task
+  void*               _arg     = nullptr;            /// Argument of _step
+  uint32_t            _idle_ms = 0;                  /// Sleep if nothing to do
+#if defined(ESP_PLATFORM)
+  TaskHandle_t _task = nullptr;  /// The pump task
+#else
+  std::thread _thread;  /// The pump thread
+#endif
+};
+
+#endif  // SRC_TINYGSMRXPUMP_H_
@@ -0,0 +1,139 @@
+/**
+ * @file       TinyGsmRxSignal.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMRXSIGNAL_H_
+#define SRC_TINYGSMRXSIGNAL_H_
+
+#include "TinyGsmCommon.h"
+#include <atomic>
+
+#if !defined(ESP_PLATFORM)
+#include <condition_variable>
+#include <mutex>
+#endif
+
+// Longest wait without a notification while notifications are coming in;
+// only a safety net for a notification that got lost.
+#ifndef TINY_GSM_RX_WAIT_MAX_MS
+#define TINY_GSM_RX_WAIT_MAX_MS 100
+#endif
+
+// Wait while nobody has ever notified, i.e. the application has not hooked
+// up the UART: a short sleep, so the wait still costs no CPU.
+#ifndef TINY_GSM_RX_WAIT_POLL_MS
+#define TINY_GSM_RX_WAIT_POLL_MS 1
+#endif
+
+/**
+ * @brief "Bytes arrived" signal of the modem UART.
+ *
+ * Whoever sees bytes arrive wakes the waiter: the rx pump after moving bytes
+ * into its pipe (wake()), and the application from the receive callback of
+ * its UART (notify()), e.g. with the Arduino-ESP32 core:
+ *
+ * @code
+ * SerialAT.onReceive([]() { modem.notifyRxData(); });
+ * @endcode
+ *
+ * A waiter blocks in wait() until the next notification or its deadline,
+ * without using CPU.  A notification is kept until it is waited for, so bytes
+ * arriving between checking the stream and waiting are not missed.  As long
+ * as notify() was never called, wait() sleeps TINY_GSM_RX_WAIT_POLL_MS at
+ * most.
+ *
+ * On FreeRTOS (ESP_PLATFORM) this is a statically allocated binary semaphore,
+ * otherwise a condition variable.
+ */
+class TinyGsmRxSignal {
+ public:
+  TinyGsmRxSignal() {
+#if defined(ESP_PLATFORM)
+    _sem = xSemaphoreCreateBinaryStatic(&_semBuffer);
+#endif
+  }
+
+  TinyGsmRxSignal(const TinyGsmRxSignal&)            = delete;
+  TinyGsmRxSignal& operator=(const TinyGsmRxSignal&) = delete;
+
+  /**
+   * @brief Bytes arrived on the UART; wakes up the waiter.
+   */
+  void notify() {
+    _active = true;
+    wake();
+  }
+
+  /**
+   * @brief Wake up the waiter, e.g. after moving bytes into a pipe.  Unlike
+   * notify() this does not tell that the UART is hooked up.
+   */
+  void wake() {
+#if defined(ESP_PLATFORM)
+    xSemaphoreGive(_sem);
+#else
+    {
+      std::lock_guard<std::mutex> l(_m);
+      _pending = true;
+    }
+    _cv.notify_all();
+#endif
+  }
+
+  /**
+   * @brief Check if the UART is hooked up, i.e. notify() was called.
+   */
+  bool active() const {
+    return _active;
+  }
+
+#if defined(ESP_PLATFORM)
+  /**
+   * @brief notify() for interrupt handlers.
+   */
+  void IRAM_ATTR notifyFromISR() {
+    BaseType_t woken = pdFALSE;
+    _active          = true;
+    xSemaphoreGiveFromISR(_sem, &woken);
+    if (woken == pdTRUE) { portYIELD_FROM_ISR(); }
+  }
+#endif
+
+  /**
+   * @brief Wait for the next notification, at most timeout_ms.
+   *
+   * @return *true* Notified.
+   * @return *false* The time passed (or the safety net struck).
+   */
+  bool wait(uint32_t timeout_ms) {
+    uint32_t ms = TinyGsmMin(timeout_ms, static_cast<uint32_t>(
+        _active ? TINY_GSM_RX_WAIT_MAX_MS : TINY_GSM_RX_WAIT_POLL_MS));
+#if defined(ESP_PLATFORM)
+    TickType_t ticks = pdMS_TO_TICKS(ms);
+    if (ticks == 0 && ms > 0) { ticks = 1; }
+    return xSemaphoreTake(_sem, ticks) == pdTRUE;
+#else
+    std::unique_lock<std::mutex> l(_m);
+    bool r   = _cv.wait_for(l, std::chrono::milliseconds(ms), [this] { return _pending; });
+    _pending = false;
+    return r;
+#endif
+  }
+
+ private:
+  std::atomic<bool> _active{false};  /// Somebody notifies
+#if defined(ESP_PLATFORM)
+  StaticSemaphore_t _semBuffer;  /// Storage of _sem
+  SemaphoreHandle_t _sem;        /// Given by notify()
+#else
+  std::mutex              _m;                /// Guards _pending
+  std::condition_variable _cv;               /// Wakes the waiter
+  bool                    _pending = false;  /// Notified, not waited for yet
+#endif
+};
+
+#endif  // SRC_TINYGSMRXSIGNAL_H_
@@ -0,0 +1,468 @@
+/**
+ * @file       TinyGsmScheduler.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMSCHEDULER_H_
+#define SRC_TINYGSMSCHEDULER_H_
+
+#include "TinyGsmCommon.h"
+#include "TinyGsmLockProfile.h"
+#include <atomic>
+
+#if !defined(ESP_PLATFORM)
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#endif
+
+// How long after socket I/O housekeeping queries are still held back, so a
+// burst of sends or reads gets the modem back to back.
+#ifndef TINY_GSM_SCHED_DATA_HOLD_MS
+#define TINY_GSM_SCHED_DATA_HOLD_MS 100
+#endif
+
+// A waiter older than this is served before all others, whatever its class.
+#ifndef TINY_GSM_SCHED_MAX_DEFER_MS
+#define TINY_GSM_SCHED_MAX_DEFER_MS 5000
+#endif
+
+// Mux of commands not bound to a socket.
+#define TINY_GSM_SCHED_NO_MUX 0xFF
+
+/**
+ * @brief Priority classes of the users of the AT channel, highest first.
+ */
+enum TinyGsmSchedClass : uint8_t {
+  TINY_GSM_SCHED_DATA         = 0,  /// Interactive socket I/O
+  TINY_GSM_SCHED_CONTROL      = 1,  /// Connection control and configuration
+  TINY_GSM_SCHED_HOUSEKEEPING = 2,  /// Periodic status queries
+};
+
+/**
+ * @brief Decides who gets the modem (the AT channel) next.
+ *
+ * Behind the MS_TINY_GSM_SEM_* macros: instead of whoever the semaphore
+ * happens to wake up, a waiting caller of a higher class gets the modem
+ * first; socket I/O waiters are served round-robin across the muxes, and
+ * housekeeping queries are held back while socket I/O waits or happened
+ * within TINY_GSM_SCHED_DATA_HOLD_MS.  Nobody waits longer than
+ * TINY_GSM_SCHED_MAX_DEFER_MS for lower class callers.
+ *
+ * Every modem has its own scheduler (TinyGsmModem::lockScheduler()), with
+ * the diagnostics who holds it, so two modems do not wait for each other.
+ * The scheduler is the lock of the modem: whoever it admits owns the modem
+ * until release().  On FreeRTOS (ESP_PLATFORM) its state is guarded by a
+ * statically allocated mutex and every waiter sleeps on its own binary
+ * semaphore on its stack; otherwise a std::mutex and a condition variable.
+ *
+ * It also counts, per call site of the macros (TinyGsmLockSite), how often
+ * the lock was taken, how long the caller waited for it and how long it was
+ * held; topContenders() / printContenders() tell who starves whom.
+ */
+class TinyGsmScheduler {
+ public:
+  TinyGsmScheduler() = default;
+
+  TinyGsmScheduler(const TinyGsmScheduler&)            = delete;
+  TinyGsmScheduler& operator=(const TinyGsmScheduler&) = delete;
+
+  /**
+   * @brief Get the modem, waiting for the turn of the caller.
+   *
+   * @param cls The class of the caller.
+   * @param mux The socket, or TINY_GSM_SCHED_NO_MUX.
+   * @param wait_ms How long to wait at most; UINT32_MAX waits forever.
+   * @param site The call site, for the statistics.
+   * @param onWait Called (without lock) if the caller has to wait, e.g. to
+   * log who blocks it.
+   * @param settle false: do not call the function set with onAcquired().
+   * @return *true* The caller owns the modem, end with release().
+   * @return *false* Not the turn of the caller within wait_ms.
+   */
+  bool acquire(TinyGsmSchedClass cls, uint8_t mux, uint32_t wait_ms,
+               TinyGsmLockSite* site = nullptr,
+               void (*onWait)(const TinyGsmScheduler&) = nullptr,
+               bool settle = true) {
+    lock();
+    uint32_t now = millis();
+    if (!_owned && _waiters == nullptr && !deferred(cls, now)) {
+      grant(cls, mux, now, site, 0, false);
+    } else {
+      if (wait_ms == 0) {
+        unlock();
+        return false;
+      }
+      if (onWait) {
+        unlock();
+        onWait(*this);
+        lock();
+        now = millis();
+      }
+      Waiter w;
+      w.cls   = cls;
+      w.mux   = mux;
+      w.since = now;
+      w.seq   = _seq++;
+      w.site  = site;
+      w.next  = _waiters;
+      _waiters = &w;
+      while (!w.granted) {
+        // A free modem with nobody admitted: all waiters were held back,
+        // check again.
+        if (!_owned) { grantNext(now); }
+        if (w.granted) { break; }
+        uint32_t waited = now - w.since;
+        if (wait_ms != UINT32_MAX && waited >= wait_ms) {
+          unlink(&w);
+          unlock();
+          return false;
+        }
+        uint32_t slice = TINY_GSM_SCHED_DATA_HOLD_MS;
+        if (wait_ms != UINT32_MAX) { slice = TinyGsmMin(slice, wait_ms - waited); }
+        sleep(w, slice);
+        now = millis();
+      }
+    }
+    unlock();
+    if (settle && _onAcquired) { _onAcquired(_onAcquiredArg); }
+    return true;
+  }
+
+  /**
+   * @brief Get the modem only if it is free and no waiter would get it now;
+   * housekeeping waiters held back do not count.
+   *
+   * @param settle false: do not call the function set with onAcquired().
+   */
+  bool tryAcquire(TinyGsmLockSite* site = nullptr, bool settle = true) {
+    lock();
+    if (_owned || next(millis()) != nullptr) {
+      unlock();
+      return false;
+    }
+    _owned    = true;
+    _ownerCls = TINY_GSM_SCHED_CONTROL;
+    _ownerMux = TINY_GSM_SCHED_NO_MUX;
+    hold(site, millis(), 0, false);
+    unlock();
+    if (settle && _onAcquired) { _onAcquired(_onAcquiredArg); }
+    return true;
+  }
+
+  /**
+   * @brief Set the function called by acquire() and tryAcquire() when the
+   * caller got the modem, before they return; e.g. to finish what the owner
+   * before left running on the AT channel.
+   */
+  void onAcquired(void (*fn)(void* arg), void* arg) {
+    _onAcquired    = fn;
+    _onAcquiredArg = arg;
+  }
+
+  /**
+   * @brief Give the modem to the next waiter.
+   *
+   * @return *false* Nobody owned the modem.
+   */
+  bool release() {
+    lock();
+    bool     r   = _owned;
+    uint32_t now = millis();
+    if (_holder) { _holder->held(now - _heldSince); }
+    _holder = nullptr;
+    _owned  = false;
+    grantNext(now);
+    unlock();
+    return r;
+  }
+
+  /**
+   * @brief Check if somebody holds the modem; does not block.
+   */
+  bool blocked() const {
+    return _owned;
+  }
+
+  /**
+   * @brief The class and the socket the modem was taken with; a try counts
+   * as TINY_GSM_SCHED_CONTROL.  Only meaningful for the owner.
+   */
+  TinyGsmSchedClass ownerClass() const {
+    return _ownerCls;
+  }
+
+  uint8_t ownerMux() const {
+    return _ownerMux;
+  }
+
+  /**
+   * @brief Note who holds the modem, for the log of those waiting for it;
+   * the strings have to be static, like __func__.  Empty when released.
+   */
+  void blockedBy(const char* func, const char* file, int line) {
+    _byFunc = func;
+    _byFile = file;
+    _byLine = line;
+  }
+
+  const char* blockedByFunc() const {
+    return _byFunc;
+  }
+
+  const char* blockedByFile() const {
+    return _byFile;
+  }
+
+  int blockedByLine() const {
+    return _byLine;
+  }
+
+  /**
+   * @brief The number of times the modem was given to each class.
+   */
+  uint32_t granted(TinyGsmSchedClass cls) const {
+    return _granted[cls];
+  }
+
+  /**
+   * @brief The call sites costing most, highest first, summed over all modems.
+   *
+   * @param out Filled with copies of the statistics of up to n sites.
+   * @param n The number of entries of out.
+   * @param order What "costing" means.
+   * @return The number of entries filled.
+   */
+  static size_t topContenders(TinyGsmLockStats* out, size_t n,
+                              TinyGsmLockOrder order = TINY_GSM_LOCK_BY_WAIT_TOTAL) {
+    size_t cnt = 0;
+    for (TinyGsmLockSite* s = TinyGsmLockSite::head().load(std::memory_order_acquire);
+         s; s = s->next) {
+      TinyGsmLockStats st = s->stats();
+      if (st.acquisitions == 0) { continue; }
+      // Insert into the sorted list, dropping the last if full
+      size_t i = cnt < n ? cnt++ : n;
+      while (i > 0 && key(st, order) > key(out[i - 1], order)) {
+        if (i < n) { out[i] = out[i - 1]; }
+        i--;
+      }
+      if (i < n) { out[i] = st; }
+    }
+    return cnt;
+  }
+
+  /**
+   * @brief Print topContenders(), one line per call site.
+   */
+  static void printContenders(Print& p, size_t n = 10,
+                              TinyGsmLockOrder order = TINY_GSM_LOCK_BY_WAIT_TOTAL) {
+    TinyGsmLockStats top[10];
+    n = topContenders(top, TinyGsmMin(n, sizeof(top) / sizeof(top[0])), order);
+    char line[160];
+    for (size_t i = 0; i < n; i++) {
+      const char* file = strrchr(top[i].file, '/');
+      snprintf(line, sizeof(line),
+               "%s (%s:%d): %" PRIu32 "x, %" PRIu32 " waited, wait %" PRIu32
+               "/%" PRIu32 " ms, hold %" PRIu32 "/%" PRIu32 " ms (total/max)",
+               top[i].func, file ? file + 1 : top[i].file, top[i].line,
+               top[i].acquisitions, top[i].contended, top[i].waitTotal_ms,
+               top[i].waitMax_ms, top[i].holdTotal_ms, top[i].holdMax_ms);
+      p.println(line);
+    }
+  }
+
+  /**
+   * @brief Set the statistics of all call sites to 0.
+   */
+  static void resetContenders() {
+    for (TinyGsmLockSite* s = TinyGsmLockSite::head().load(std::memory_order_acquire);
+         s; s = s->next) {
+      s->reset();
+    }
+  }
+
+ private:
+  struct Waiter {
+#if defined(ESP_PLATFORM)
+    Waiter() {
+      sem = xSemaphoreCreateBinaryStatic(&semBuffer);
+    }
+    ~Waiter() {
+      vSemaphoreDelete(sem);
+    }
+    StaticSemaphore_t semBuffer;  /// Storage of sem
+    SemaphoreHandle_t sem;        /// Given when granted
+#endif
+    TinyGsmSchedClass cls;
+    uint8_t           mux;
+    uint32_t          since;
+    uint32_t          seq;
+    bool              granted = false;
+    TinyGsmLockSite*  site    = nullptr;
+    Waiter*           next    = nullptr;
+  };
+
+  // The state (waiters, owner, statistics) is only used locked.
+#if defined(ESP_PLATFORM)
+  void lock() {
+    xSemaphoreTake(_m, portMAX_DELAY);
+  }
+
+  void unlock() {
+    xSemaphoreGive(_m);
+  }
+
+  // Wait (unlocked) until w is granted, at most ms.
+  void sleep(Waiter& w, uint32_t ms) {
+    TickType_t ticks = pdMS_TO_TICKS(ms);
+    if (ticks == 0 && ms > 0) { ticks = 1; }
+    unlock();
+    xSemaphoreTake(w.sem, ticks);
+    lock();
+  }
+
+  void wake(Waiter* w) {
+    xSemaphoreGive(w->sem);
+  }
+#else
+  void lock() {
+    _m.lock();
+  }
+
+  void unlock() {
+    _m.unlock();
+  }
+
+  void sleep(Waiter&, uint32_t ms) {
+    std::unique_lock<std::mutex> l(_m, std::adopt_lock);
+    _cv.wait_for(l, std::chrono::milliseconds(ms));
+    l.release();
+  }
+
+  void wake(Waiter*) {
+    _cv.notify_all();
+  }
+#endif
+
+  static uint32_t key(const TinyGsmLockStats& s, TinyGsmLockOrder order) {
+    switch (order) {
+      case TINY_GSM_LOCK_BY_WAIT_MAX: return s.waitMax_ms;
+      case TINY_GSM_LOCK_BY_HOLD_TOTAL: return s.holdTotal_ms;
+      case TINY_GSM_LOCK_BY_HOLD_MAX: return s.holdMax_ms;
+      default: return s.waitTotal_ms;
+    }
+  }
+
+  // The lock goes to site; it waited wait_ms for it.
+  void hold(TinyGsmLockSite* site, uint32_t now, uint32_t wait_ms,
+            bool contended) {
+    _holder    = site;
+    _heldSince = now;
+    if (site) { site->waited(wait_ms, contended); }
+  }
+
+  // Housekeeping waits while socket I/O is going on.
+  bool deferred(TinyGsmSchedClass cls, uint32_t now) const {
+    if (cls != TINY_GSM_SCHED_HOUSEKEEPING) { return false; }
+    if (now - _lastData < TINY_GSM_SCHED_DATA_HOLD_MS) { return true; }
+    for (Waiter* w = _waiters; w; w = w->next) {
+      if (w->cls == TINY_GSM_SCHED_DATA) { return true; }
+    }
+    return false;
+  }
+
+  // true if a is to be served before b
+  bool before(const Waiter* a, const Waiter* b, uint32_t now) const {
+    bool agedA = now - a->since >= TINY_GSM_SCHED_MAX_DEFER_MS;
+    bool agedB = now - b->since >= TINY_GSM_SCHED_MAX_DEFER_MS;
+    if (agedA != agedB) { return agedA; }
+    if (agedA) { return static_cast<int32_t>(a->seq - b->seq) < 0; }
+    if (a->cls != b->cls) { return a->cls < b->cls; }
+    if (a->cls == TINY_GSM_SCHED_DATA && a->mux != b->mux) {
+      // Round-robin: the next mux after the one served last comes first.
+      return static_cast<uint8_t>(a->mux - _lastMux - 1) <
+          static_cast<uint8_t>(b->mux - _lastMux - 1);
+    }
+    return static_cast<int32_t>(a->seq - b->seq) < 0;
+  }
+
+  // The waiter to be admitted now, nullptr if none or all are held back.
+  Waiter* next(uint32_t now) const {
+    Waiter* best = nullptr;
+    for (Waiter* w = _waiters; w; w = w->next) {
+      if (now - w->since < TINY_GSM_SCHED_MAX_DEFER_MS && deferred(w->cls, now)) {
+        continue;
+      }
+      if (best == nullptr || before(w, best, now)) { best = w; }
+    }
+    return best;
+  }
+
+  void grantNext(uint32_t now) {
+    Waiter* best = next(now);
+    if (best == nullptr) { return; }
+    unlink(best);
+    best->granted = true;
+    grant(best->cls, best->mux, now, best->site, now - best->since, true);
+    wake(best);
+  }
+
+  void grant(TinyGsmSchedClass cls, uint8_t mux, uint32_t now,
+             TinyGsmLockSite* site, uint32_t wait_ms, bool contended) {
+    _owned    = true;
+    _ownerCls = cls;
+    _ownerMux = mux;
+    _granted[cls]++;
+    hold(site, now, wait_ms, contended);
+    if (cls == TINY_GSM_SCHED_DATA) {
+      _lastData = now;
+      if (mux != TINY_GSM_SCHED_NO_MUX) { _lastMux = mux; }
+    }
+  }
+
+  void unlink(Waiter* w) {
+    for (Waiter** p = &_waiters; *p; p = &(*p)->next) {
+      if (*p == w) {
+        *p = w->next;
+        return;
+      }
+    }
+  }
+
+#if defined(ESP_PLATFORM)
+  StaticSemaphore_t       _mBuffer;                       /// Storage of _m
+  SemaphoreHandle_t       _m = xSemaphoreCreateMutexStatic(&_mBuffer);  /// Guards the state
+#else
+  std::mutex              _m;                             /// Guards the state
+  std::condition_variable _cv;                            /// Wakes the waiters
+#endif
+  const char*             _byFunc   = "";                 /// Holder of the modem, see blockedBy()
+  const char*             _byFile   = "";
+  int                     _byLine   = 0;
+  Waiter*                 _waiters  = nullptr;            /// Waiting callers
+  void (*_onAcquired)(void*)        = nullptr;            /// See onAcquired()
+  void*                   _onAcquiredArg = nullptr;
+  std::atomic<bool>       _owned{false};                  /// Somebody was admitted, the modem is locked
+  TinyGsmSchedClass       _ownerCls = TINY_GSM_SCHED_CONTROL;  /// Class of the admitted one
+  uint8_t                 _ownerMux = TINY_GSM_SCHED_NO_MUX;   /// Its socket
+  uint8_t                 _lastMux  = TINY_GSM_SCHED_NO_MUX;  /// Last mux served
+  uint32_t                _lastData = 0U - TINY_GSM_SCHED_DATA_HOLD_MS;  /// millis() of last socket I/O
+  uint32_t                _seq      = 0;                  /// Arrival order
+  uint32_t                _granted[3] = {};               /// Grants per class
+  TinyGsmLockSite*        _holder    = nullptr;           /// Call site holding the modem
+  uint32_t                _heldSince = 0;                 /// millis() it got it
+};
+
+// Logs that the caller has to wait for the modem, and for whom.
+inline void msTinyGsmSemLogWait(const TinyGsmScheduler& s) {
+	(void)s;
+	DBGLOG(
+		logLevelSemTinyGsmError,
+		"### TINY_GSM ### ---> sem not available, wait until it becomes available. Blocked by: %s<%s:%i>",
+		s.blockedByFunc(), s.blockedByFile(), s.blockedByLine())
+}
+
+#endif  // SRC_TINYGSMSCHEDULER_H_
@@ -0,0 +1,133 @@
+/**
+ * @file       TinyGsmStatusCache.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ */
+
+#ifndef SRC_TINYGSMSTATUSCACHE_H_
+#define SRC_TINYGSMSTATUSCACHE_H_
+
+#include "TinyGsmCommon.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+// Default maximum age of the cached status query results, in ms; 0 (the
+// default) always asks the modem, but still shares a query in flight.
+#ifndef TINY_GSM_CACHE_CSQ_MS
+#define TINY_GSM_CACHE_CSQ_MS 0  // getSignalQuality()
+#endif
+
+#ifndef TINY_GSM_CACHE_REG_MS
+#define TINY_GSM_CACHE_REG_MS 0  // getRegistrationStatus()
+#endif
+
+#ifndef TINY_GSM_CACHE_CBC_MS
+#define TINY_GSM_CACHE_CBC_MS 0  // Battery functions
+#endif
+
+#ifndef TINY_GSM_CACHE_CPSI_MS
+#define TINY_GSM_CACHE_CPSI_MS 0  // getUserEquipmentSystemInfo()
+#endif
+
+/**
+ * @brief What TinyGsmStatusCache::begin() tells the caller to do.
+ */
+enum TinyGsmStatusCacheResult : uint8_t {
+  TINY_GSM_CACHE_FRESH   = 0,  /// The cached value is young enough
+  TINY_GSM_CACHE_JOINED  = 1,  /// Got the result of the query in flight
+  TINY_GSM_CACHE_QUERY   = 2,  /// Ask the modem, then call end()
+  TINY_GSM_CACHE_TIMEOUT = 3,  /// The query in flight did not end in time
+};
+
+/**
+ * @brief The last result of a status query (signal quality, registration,
+ * battery, ...), shared by all callers.
+ *
+ * A caller gets the cached value if it is younger than the maximum age it
+ * accepts.  Otherwise the first caller asks the modem, and callers coming
+ * while that query is in flight wait for its result instead of queuing for
+ * the modem with the same query:
+ *
+ * @code
+ * int16_t csq;
+ * if (cache.begin(csq, maxAge_ms) != TINY_GSM_CACHE_QUERY) { return csq; }
+ * csq = <ask the modem>;
+ * cache.end(csq != 99, csq);
+ * @endcode
+ *
+ * The internal lock is never held while the modem is asked.
+ *
+ * @tparam T The type of the result, including a failure indication if needed.
+ */
+template <typename T>
+class TinyGsmStatusCache {
+ public:
+  /**
+   * @brief Get the cached value, the result of the query in flight, or the
+   * job to ask the modem.
+   *
+   * @param value Set to the result, if TINY_GSM_CACHE_FRESH or
+   * TINY_GSM_CACHE_JOINED is returned.
+   * @param maxAge_ms The maximum age of a cached value the caller accepts.
+   * @param wait_ms How long to wait for the query in flight, as long as the
+   * caller would wait for the modem by default.
+   */
+  TinyGsmStatusCacheResult begin(T& value, uint32_t maxAge_ms,
+                                 uint32_t wait_ms = static_cast<uint32_t>(
+                                     MS_TINY_GSM_SEM_WAIT_FOR_MS)) {
+    std::unique_lock<std::mutex> l(_m);
+    if (_valid && millis() - _time < maxAge_ms) {
+      value = _value;
+      return TINY_GSM_CACHE_FRESH;
+    }
+    if (_busy) {
+      uint32_t gen = _gen;
+      if (!_cv.wait_for(l, std::chrono::milliseconds(wait_ms),
+                        [&] { return _gen != gen; })) {
+        return TINY_GSM_CACHE_TIMEOUT;
+      }
+      value = _value;
+      return TINY_GSM_CACHE_JOINED;
+    }
+    _busy = true;
+    return TINY_GSM_CACHE_QUERY;
+  }
+
+  /**
+   * @brief End the query begun by begin(): hand the result to the waiting
+   * callers and, if ok, keep it for the next ones.
+   */
+  void end(bool ok, const T& value) {
+    {
+      std::lock_guard<std::mutex> l(_m);
+      _value = value;
+      _valid = ok;
+      _time  = millis();
+      _busy  = false;
+      _gen++;
+    }
+    _cv.notify_all();
+  }
+
+  /**
+   * @brief Forget the cached value, the next caller asks the modem.
+   */
+  void invalidate() {
+    std::lock_guard<std::mutex> l(_m);
+    _valid = false;
+  }
+
+ private:
+  std::mutex              _m;              /// Guards the state
+  std::condition_variable _cv;             /// Wakes the callers waiting for the query
+  T                       _value{};        /// Last result
+  uint32_t                _time  = 0;      /// millis() of the last result
+  uint32_t                _gen   = 0;      /// Number of queries ended
+  bool                    _valid = false;  /// _value may be used
+  bool                    _busy  = false;  /// A query is in flight
+};
+
+#endif  // SRC_TINYGSMSTATUSCACHE_H_
@@ -14,6 +14,7 @@
 #define TINY_GSM_MODEM_HAS_TCP
 
 #include "TinyGsmFifo.h"
+#include "TinyGsmBudget.h"
 
 
 // Logging
@@ -74,6 +75,24 @@
 // // of the buffer
 // #define TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
 
+// With TINY_GSM_BUFFER_READ_AND_CHECK_SIZE: default range of the interval of
+// the check-in with the modem for data which arrived without a URC.  The
+// interval of a socket starts at the minimum after traffic and doubles with
+// every check finding nothing, see GsmClient::setPollInterval().
+#ifndef TINY_GSM_POLL_INTERVAL_MIN_MS
+#define TINY_GSM_POLL_INTERVAL_MIN_MS 50
+#endif
+
+#ifndef TINY_GSM_POLL_INTERVAL_MAX_MS
+#define TINY_GSM_POLL_INTERVAL_MAX_MS 2000
+#endif
+
+// maintain(budget) checks the sizes of the sockets only with this much of
+// the budget left (ms); otherwise it reports the check as pending work.
+#ifndef TINY_GSM_MAINTAIN_MIN_POLL_MS
+#define TINY_GSM_MAINTAIN_MIN_POLL_MS 50
+#endif
+
 template <class modemType, uint8_t muxCount>
 class TinyGsmTCP {
   /* =========================================== */
@@ -89,6 +108,21 @@ class TinyGsmTCP {
     return thisModem().maintainImpl();
   }
 
+  /**
+   * @brief Like maintain(), but within a budget, for a control loop needing
+   * a bound on the time spent in the modem per tick: it returns after
+   * budget_us microseconds (waits for the lock and the modem included), and
+   * stops after budget_bytes received bytes.  Either way it finishes the line
+   * it is in, as far as it has been received, so no URC is cut.
+   *
+   * @return *true* More work is pending (received bytes, a due size check
+   * of the sockets, the modem busy): call it again soon.
+   */
+  bool maintain(uint32_t budget_us, size_t budget_bytes = SIZE_MAX) {
+    TinyGsmBudget budget(budget_us, budget_bytes);
+    return thisModem().maintainImpl(budget);
+  }
+
   /*
    * CRTP Helper
    */
@@ -149,7 +183,12 @@ class TinyGsmTCP {
     size_t write(const uint8_t* buf, size_t size) override {
       TINY_GSM_YIELD();
       at->maintain();
-      return at->modemSend(buf, size, mux);
+      size_t n = at->modemSend(buf, size, mux);
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
+      // an answer is likely to come soon
+      if (n > 0) { pollActive(); }
+#endif
+      return n;
     }
 
     size_t write(uint8_t c) override {
@@ -179,12 +218,9 @@ class TinyGsmTCP {
       // fifo and the modem chips internal fifo, doing an extra check-in
       // with the modem to see if anything has arrived without a UURC.
       if (!rx.size()) {
-        if (millis() - prev_check > 500) {
-          // setting got_data to true will tell maintain to run
-          // modemGetAvailable(mux)
-          got_data   = true;
-          prev_check = millis();
-        }
+        // maintain checks the sizes of all sockets if due, see
+        // TinyGsmTCP::pollDue()
+        if (!sock_available) { poll_wanted = true; }
         at->maintain();
       }
       return static_cast<int>(rx.size() + sock_available);
@@ -195,7 +231,7 @@ class TinyGsmTCP {
     }
 
     int read(uint8_t* buf, size_t size) override {
-      DBGLOG(Verbose, "[TinyGsmTCP] >> size: %u", size)
+      DBGLOG(Verbose, "[TinyGsmTCP] >> size: %zu", size)
 
       TINY_GSM_YIELD();
       size_t cnt = 0;
@@ -252,13 +288,9 @@ class TinyGsmTCP {
           cnt += chunk;
           continue;
         }
-        // Workaround: Some modules "forget" to notify about data arrival
-        if (millis() - prev_check > 500) {
-          // setting got_data to true will tell maintain to run
-          // modemGetAvailable()
-          got_data   = true;
-          prev_check = millis();
-        }
+        // Workaround: Some modules "forget" to notify about data arrival,
+        // see TinyGsmTCP::pollDue()
+        poll_wanted = true;
         // TODO(vshymanskyy): Read directly into user buffer?
         at->maintain();
         if (sock_available > 0) {
@@ -268,8 +300,9 @@ class TinyGsmTCP {
           break;
         }
       }
+      if (cnt > 0) { pollActive(); }
 
-      DBGLOG(Verbose, "[TinyGsmTCP] << cnt: %u", cnt)
+      DBGLOG(Verbose, "[TinyGsmTCP] << cnt: %zu", cnt)
       return static_cast<int>(cnt);
 
 #else
@@ -277,6 +310,51 @@ class TinyGsmTCP {
 #endif
     } // int read(uint8_t* buf, size_t size)
 
+#if defined TINY_GSM_COROUTINES
+    /**
+     * @brief co_await client.readAsync(buf, size, timeout_ms): like read(),
+     * but the coroutine only waits in the event loop of the modem (see
+     * TinyGsmModem::eventLoop()) until data is in the rx fifo or the socket
+     * closed.  The event loop reads the data the modem announced into the
+     * fifo when the modem is free, or the rx pump does; the coroutine never
+     * talks to the modem itself.
+     *
+     * @return *int* The number of bytes read; 0 if nothing arrived within
+     * timeout_ms or the socket is closed.
+     */
+    TinyGsmTask<int> readAsync(uint8_t* buf, size_t size, uint32_t timeout_ms) {
+      uint32_t start = millis();
+      for (;;) {
+        if (rx.size() > 0) {
+          size_t n = TinyGsmMin(size, rx.size());
+          rx.get(buf, n);
+          co_return static_cast<int>(n);
+        }
+        uint32_t elapsed = millis() - start;
+        if (dataEnded(this) || elapsed >= timeout_ms) { co_return 0; }
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
+        // Workaround, see read(): have the size checked now and then even
+        // without a URC announcing data
+        if (!co_await at->eventLoop().until(dataArrived, this,
+                                            TinyGsmMin(timeout_ms - elapsed, poll_interval))) {
+          poll_wanted = true;
+        }
+#else
+        co_await at->eventLoop().until(dataArrived, this, timeout_ms - elapsed);
+#endif
+      }
+    }
+
+    /**
+     * @brief co_await client.readAsync(buf): fill up to the whole array, with
+     * the stream timeout.
+     */
+    template <size_t N>
+    TinyGsmTask<int> readAsync(uint8_t (&buf)[N]) {
+      return readAsync(buf, N, _timeout);
+    }
+#endif
+
     int read() override {
       DBGLOG(Verbose, "[TinyGsmTCP] >>")
 
@@ -305,10 +383,9 @@ class TinyGsmTCP {
 #if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
       // If the modem is one where we can read and check the size of the buffer,
       // then the 'available()' function will call a check of the current size
-      // of the buffer and state of the connection. [available calls maintain,
-      // maintain calls modemGetAvailable, modemGetAvailable calls
-      // modemGetConnected]  This cascade means that the sock_connected value
-      // should be correct and all we need
+      // of the buffer, and sock_connected is kept up to date by the URCs of
+      // the modem (and a state check of all sockets after a URC may have been
+      // lost).  So the sock_connected value should be correct and all we need
       return sock_connected;
 #elif defined TINY_GSM_NO_MODEM_BUFFER || defined TINY_GSM_BUFFER_READ_NO_CHECK
       // If the modem doesn't have an internal buffer, or if we can't check how
@@ -329,7 +406,51 @@ class TinyGsmTCP {
 
     String remoteIP() TINY_GSM_ATTR_NOT_IMPLEMENTED;
 
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
+    /**
+     * @brief Statistics of the checks for data arrived without a URC.
+     */
+    struct PollStats {
+      uint32_t interval;  /// The current interval, ms
+      uint32_t checks;    /// Size checks covering this socket
+      uint32_t found;     /// Checks which found data waiting
+    };
+
+    PollStats pollStats() const {
+      return {poll_interval, poll_checks, poll_found};
+    }
+
+    /**
+     * @brief Set the range of the interval of the checks for data arrived
+     * without a URC (defaults TINY_GSM_POLL_INTERVAL_MIN_MS and
+     * TINY_GSM_POLL_INTERVAL_MAX_MS).  Right after traffic the socket is
+     * checked every min_ms, each check finding nothing doubles the interval
+     * up to max_ms.  E.g. (20, 20) for a request/response protocol, (500,
+     * 60000) for a socket that is mostly idle.  min_ms is at least 1, so
+     * that the interval can grow.
+     */
+    void setPollInterval(uint32_t min_ms, uint32_t max_ms) {
+      poll_min      = TinyGsmMax(min_ms, static_cast<uint32_t>(1));
+      poll_max      = TinyGsmMax(poll_min, max_ms);
+      poll_interval = poll_min;
+    }
+#endif
+
    protected:
+#if defined TINY_GSM_COROUTINES
+    // Conditions readAsync() waits for: data in the rx fifo, or none will
+    // come any more.
+    static bool dataArrived(void* arg) {
+      GsmClient* c = static_cast<GsmClient*>(arg);
+      return c->rx.size() > 0 || dataEnded(arg);
+    }
+
+    static bool dataEnded(void* arg) {
+      GsmClient* c = static_cast<GsmClient*>(arg);
+      return !c->sock_connected && c->sock_available == 0 && c->rx.size() == 0;
+    }
+
+#endif
     // Read and dump anything remaining in the modem's internal buffer.
     // Using this in the client stop() function.
     // The socket will appear open in response to connected() even after it
@@ -346,11 +467,16 @@ class TinyGsmTCP {
         at->modemRead(TinyGsmMin((size_t)rx.free(), sock_available), mux);
       }
       rx.clear();
+      // Another task may be talking to the modem
+      MS_TINY_GSM_SEM_TAKE_WAIT
       at->streamClear();
+      MS_TINY_GSM_SEM_GIVE_WAIT
 
 #elif defined TINY_GSM_NO_MODEM_BUFFER
       rx.clear();
+      MS_TINY_GSM_SEM_TAKE_WAIT
       at->streamClear();
+      MS_TINY_GSM_SEM_GIVE_WAIT
 
 #else
 #error Modem client has been incorrectly created
@@ -360,15 +486,33 @@ class TinyGsmTCP {
     modemType* at;
 
 // <MS>
+    // The lock of the modem, for the MS_TINY_GSM_SEM_* macros
+    inline TinyGsmScheduler& lockScheduler() {
+      return at->lockScheduler();
+    }
+
 public:    
     uint8_t    mux;
 
 protected:    
     size_t   sock_available;
-    uint32_t   prev_check;
     bool       sock_connected;
     bool       got_data;
     RxFifo     rx;
+
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
+    // Traffic: check tightly again
+    void pollActive() {
+      poll_interval = poll_min;
+    }
+
+    uint32_t poll_min      = TINY_GSM_POLL_INTERVAL_MIN_MS;  /// See setPollInterval()
+    uint32_t poll_max      = TINY_GSM_POLL_INTERVAL_MAX_MS;  /// See setPollInterval()
+    uint32_t poll_interval = TINY_GSM_POLL_INTERVAL_MIN_MS;  /// Current interval
+    bool     poll_wanted   = false;  /// Waiting for data, see TinyGsmTCP::pollDue()
+    uint32_t poll_checks   = 0;      /// See PollStats
+    uint32_t poll_found    = 0;      /// See PollStats
+#endif
   }; // class GsmClient
 
   /* =========================================== */
@@ -391,13 +535,7 @@ protected:
 #if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
     // Keep listening for modem URC's and proactively iterate through
     // sockets asking if any data is avaiable
-    for (int mux = 0; mux < muxCount; mux++) {
-      GsmClient* sock = thisModem().sockets[mux];
-      if (sock && sock->got_data) {
-        sock->got_data       = false;
-        sock->sock_available = thisModem().modemGetAvailable(mux);
-      }
-    }
+    if (pollDue()) { thisModem().pollSocketsImpl(); }
     while (thisModem().stream.available()) {
       thisModem().waitResponse(15, nullptr, nullptr);
     }
@@ -411,7 +549,182 @@ protected:
 #endif
   }
 
-  // Yields up to a time-out period and then reads a character from the stream
+  // maintainImpl() within budget; its waits end with the budget.
+  bool maintainImpl(TinyGsmBudget& budget) {
+    // The budget only decides whether a command is sent, see
+    // TinyGsmSim7080::maintainImpl()
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
+    if (pollDue() && budget.remaining_ms() >= TINY_GSM_MAINTAIN_MIN_POLL_MS) {
+      thisModem().pollSocketsImpl();
+    }
+    while (thisModem().stream.available() && !budget.exhausted()) {
+      thisModem().handleURCs(15, budget);
+    }
+    return thisModem().stream.available() > 0 || pollDue();
+
+#elif defined TINY_GSM_NO_MODEM_BUFFER || defined TINY_GSM_BUFFER_READ_NO_CHECK
+    thisModem().handleURCs(100, budget);
+    return thisModem().stream.available() > 0;
+
+#else
+#error Modem client has been incorrectly created
+#endif
+  }
+
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
+  // The size check of all sockets (a sweep), with the modem locked; a modem
+  // checking all sockets with one command overrides it.
+  void pollSocketsImpl() {
+    pollLast = millis();
+    for (uint8_t mux = 0; mux < muxCount; mux++) {
+      GsmClient* sock = thisModem().sockets[mux];
+      if (!sock) { continue; }
+      pollStarted(mux);
+      sock->sock_available = thisModem().modemGetAvailable(mux);
+      pollFinished(mux);
+    }
+  }
+#endif
+
+#if defined TINY_GSM_COROUTINES
+  // Used by the event loop, with the modem locked: check the sizes if due
+  // and read the data the modem announced into the rx fifos, where
+  // readAsync() takes it from.  Like pumpSocketsImpl(), but never waiting
+  // for the modem.
+  bool fetchSocketsImpl() {
+    bool work = false;
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
+    if (pollDue()) {
+      thisModem().pollSocketsImpl();
+      work = true;
+    }
+#endif
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE || \
+    defined TINY_GSM_BUFFER_READ_NO_CHECK
+    for (uint8_t mux = 0; mux < muxCount; mux++) {
+      GsmClient* sock = thisModem().sockets[mux];
+      if (sock && sock->sock_available > 0 && sock->rx.free() > 0) {
+        thisModem().modemReadLocked(
+            TinyGsmMin(static_cast<size_t>(sock->rx.free()),
+                       static_cast<size_t>(sock->sock_available)),
+            mux);
+        work = true;
+      }
+    }
+#endif
+    return work;
+  }
+
+  // Check if fetchSocketsImpl() has something to do.
+  bool fetchDue() const {
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
+    if (pollDue()) { return true; }
+#endif
+    for (uint8_t mux = 0; mux < muxCount; mux++) {
+      GsmClient* sock = thisModem().sockets[mux];
+      if (sock && sock->sock_available > 0 && sock->rx.free() > 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+#endif
+
+  // Used by the rx pump: fetch the data the modem announced into the rx fifos
+  // right away, instead of waiting for the client to ask for it.
+  bool pumpSocketsImpl() {
+    bool work = false;
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
+    if (pollDue()) {
+      // checks all sockets at once
+      thisModem().maintain();
+      work = true;
+    }
+#endif
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE || \
+    defined TINY_GSM_BUFFER_READ_NO_CHECK
+    for (uint8_t mux = 0; mux < muxCount; mux++) {
+      GsmClient* sock = thisModem().sockets[mux];
+      if (sock && sock->sock_available > 0 && sock->rx.free() > 0) {
+        thisModem().modemRead(
+            TinyGsmMin(static_cast<size_t>(sock->rx.free()),
+                       static_cast<size_t>(sock->sock_available)),
+            mux);
+        work = true;
+      }
+    }
+#endif
+    return work;
+  }
+
+#if defined TINY_GSM_BUFFER_READ_AND_CHECK_SIZE
+  // Socket poll scheduler: one size check of all sockets (a sweep, e.g.
+  // +CARECV?) serves the available() of every socket.  A sweep is due if a
+  // socket announced data (got_data), or if a client waiting for data
+  // (poll_wanted) was not checked within its interval (or a URC may have
+  // been lost), however many sockets and tasks ask.  The modem calls
+  // pollStarted() and pollFinished() around every sweep; each socket's
+  // interval adapts to its traffic.
+  bool pollDue() const {
+    uint32_t since = millis() - pollLast;
+    for (uint8_t mux = 0; mux < muxCount; mux++) {
+      GsmClient* sock = thisModem().sockets[mux];
+      if (!sock) { continue; }
+      if (sock->got_data) { return true; }
+      if (sock->poll_wanted &&
+          (thisModem().urcLossSuspected || since >= sock->poll_interval)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Before the query of the size of socket mux, or of all sockets if -1, so
+  // data announced while it runs is checked again.  Returns the sockets
+  // (bit per mux) which had announced data, see pollFailed().
+  uint32_t pollStarted(uint8_t mux = (uint8_t)-1) {
+    static_assert(muxCount <= 32, "pollStarted() keeps a bit per mux");
+    uint32_t announced = 0;
+    for (uint8_t m = 0; m < muxCount; m++) {
+      GsmClient* sock = thisModem().sockets[m];
+      if (!sock || (mux != (uint8_t)-1 && m != mux)) { continue; }
+      if (sock->got_data) { announced |= 1UL << m; }
+      sock->got_data    = false;
+      sock->poll_wanted = false;
+    }
+    if (mux == (uint8_t)-1) { pollLast = millis(); }
+    return announced;
+  }
+
+  // After the sizes are updated (of socket mux, or of all sockets if -1):
+  // back off on the sockets without data.
+  void pollFinished(uint8_t mux = (uint8_t)-1) {
+    for (uint8_t m = 0; m < muxCount; m++) {
+      GsmClient* sock = thisModem().sockets[m];
+      if (!sock || (mux != (uint8_t)-1 && m != mux)) { continue; }
+      sock->poll_checks++;
+      if (sock->sock_available > 0) {
+        sock->poll_found++;
+        sock->pollActive();
+      } else {
+        sock->poll_interval = TinyGsmMin(sock->poll_interval * 2, sock->poll_max);
+      }
+    }
+  }
+
+  // The query did not tell the sizes: the sockets which had announced data
+  // (as returned by pollStarted()) keep the announcement.
+  void pollFailed(uint32_t announced) {
+    for (uint8_t m = 0; m < muxCount; m++) {
+      GsmClient* sock = thisModem().sockets[m];
+      if (sock && (announced & (1UL << m))) { sock->got_data = true; }
+    }
+  }
+
+  uint32_t pollLast = 0U - TINY_GSM_POLL_INTERVAL_MAX_MS;  /// millis() of the last sweep
+#endif
+
+  // Waits up to a time-out period and then reads a character from the stream
   // into the mux FIFO
   // TODO(SRGDamia1):  Do we really need to wait _two_ timeout periods for no
   // character return?  Will wait once in the first "while
@@ -421,9 +734,7 @@ protected:
     if (!thisModem().sockets[mux]) return;
     uint32_t startMillis = millis();
     while (!thisModem().stream.available() &&
-           (millis() - startMillis < thisModem().sockets[mux]->_timeout)) {
-      TINY_GSM_YIELD();
-    }
+           thisModem().waitForRx(startMillis, thisModem().sockets[mux]->_timeout)) {}
     char c = thisModem().stream.read();
     thisModem().sockets[mux]->rx.put(c);
   }
@@ -37,7 +37,7 @@ class TinyGsmTime {
   String getGSMDateTime(TinyGSMDateTimeFormat format) {
     String s;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     s = thisModem().getGSMDateTimeImpl(format);
 
@@ -64,7 +64,7 @@ class TinyGsmTime {
                       int* second, float* timezone) {
     bool b = false;
 
-    MS_TINY_GSM_SEM_TAKE_WAIT
+    MS_TINY_GSM_SEM_TAKE_WAIT_CLASS(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX)
 
     b = thisModem().getNetworkTimeImpl(year, month, day, hour, minute,
                                           second, timezone);
@@ -104,6 +104,10 @@ class TinyGsmTime {
   inline modemType& thisModem() {
     return static_cast<modemType&>(*this);
   }
+  // The lock of the modem, for the MS_TINY_GSM_SEM_* macros
+  inline TinyGsmScheduler& lockScheduler() {
+    return thisModem().lockScheduler();
+  }
   ~TinyGsmTime() {}
 
   /* =========================================== */
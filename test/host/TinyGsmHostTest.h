@@ -0,0 +1,119 @@
+/**
+ * @file       TinyGsmHostTest.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * What the host tests share: CHECK() and a fake modem on a Stream.
+ */
+
+#ifndef TEST_HOST_TINYGSMHOSTTEST_H_
+#define TEST_HOST_TINYGSMHOSTTEST_H_
+
+#include "Arduino.h"
+#include <map>
+#include <mutex>
+#include <string>
+
+// Count a failed condition and go on, main() returns the count.
+#define CHECK(cond)                                                       \
+  do {                                                                    \
+    if (!(cond)) {                                                        \
+      printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond);     \
+      tinyGsmTestFailures++;                                              \
+    }                                                                     \
+  } while (0)
+
+inline int tinyGsmTestFailures = 0;
+
+inline int tinyGsmTestResult(const char* name) {
+  printf("%s: %d failure(s)\n", name, tinyGsmTestFailures);
+  return tinyGsmTestFailures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief A modem behind a Stream: every command line written ("AT...\r\n")
+ * is answered from answers, "\r\nOK\r\n" if it is not in there.  An empty
+ * answer is no answer; push() lets anything arrive, e.g. from another
+ * thread.
+ */
+class FakeModem : public Stream {
+ public:
+  void answer(const std::string& cmd, const std::string& response) {
+    std::lock_guard<std::mutex> l(_m);
+    _answers[cmd] = response;
+  }
+
+  void push(const std::string& s) {
+    std::lock_guard<std::mutex> l(_m);
+    _in += s;
+  }
+
+  // The lines written since the last call.
+  std::string sent() {
+    std::lock_guard<std::mutex> l(_m);
+    std::string s = _sent;
+    _sent.clear();
+    return s;
+  }
+
+  int calls(const std::string& cmd) {
+    std::lock_guard<std::mutex> l(_m);
+    return _calls[cmd];
+  }
+
+  int available() override {
+    std::lock_guard<std::mutex> l(_m);
+    return static_cast<int>(_in.size());
+  }
+
+  int read() override {
+    std::lock_guard<std::mutex> l(_m);
+    if (_in.empty()) { return -1; }
+    int c = static_cast<uint8_t>(_in[0]);
+    _in.erase(0, 1);
+    return c;
+  }
+
+  int peek() override {
+    std::lock_guard<std::mutex> l(_m);
+    return _in.empty() ? -1 : static_cast<uint8_t>(_in[0]);
+  }
+
+  size_t readBytes(char* buf, size_t length) override {
+    std::lock_guard<std::mutex> l(_m);
+    size_t n = _in.copy(buf, length);
+    _in.erase(0, n);
+    return n;
+  }
+
+  size_t write(uint8_t c) override {
+    std::lock_guard<std::mutex> l(_m);
+    _line += static_cast<char>(c);
+    if (_line.size() >= 2 && _line.compare(_line.size() - 2, 2, "\r\n") == 0) {
+      std::string cmd = _line.substr(0, _line.size() - 2);
+      _sent += _line;
+      _line.clear();
+      _calls[cmd]++;
+      auto it = _answers.find(cmd);
+      _in += it != _answers.end() ? it->second : "\r\nOK\r\n";
+    }
+    return 1;
+  }
+
+  size_t write(const uint8_t* b, size_t n) override {
+    for (size_t i = 0; i < n; i++) { write(b[i]); }
+    return n;
+  }
+
+ private:
+  std::mutex                         _m;
+  std::string                        _in;       /// Not read yet
+  std::string                        _line;     /// Written, not ended yet
+  std::string                        _sent;     /// See sent()
+  std::map<std::string, std::string> _answers;  /// See answer()
+  std::map<std::string, int>         _calls;    /// See calls()
+};
+
+#endif  // TEST_HOST_TINYGSMHOSTTEST_H_
@@ -0,0 +1,309 @@
+/**
+ * @file       Arduino.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The part of the Arduino core the library uses, for the host tests.
+ */
+
+#ifndef TEST_HOST_STUBS_ARDUINO_H_
+#define TEST_HOST_STUBS_ARDUINO_H_
+
+#include <cctype>
+#include <chrono>
+#include <cinttypes>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+typedef uint8_t byte;
+
+inline unsigned long millis() {
+  using namespace std::chrono;
+  return static_cast<unsigned long>(
+      duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+inline unsigned long micros() {
+  using namespace std::chrono;
+  return static_cast<unsigned long>(
+      duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+inline void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+class __FlashStringHelper;
+#define F(x) x
+#define HEX 16
+#define DEC 10
+
+class String {
+ public:
+  String() {}
+  String(const char* c) : s(c ? c : "") {}  // NOLINT
+  String(const std::string& c) : s(c) {}    // NOLINT
+  explicit String(int v) : s(std::to_string(v)) {}
+  explicit String(unsigned v) : s(std::to_string(v)) {}
+  explicit String(long v) : s(std::to_string(v)) {}
+  explicit String(unsigned long v) : s(std::to_string(v)) {}
+  explicit String(char c) : s(1, c) {}
+
+  bool reserve(unsigned n) {
+    s.reserve(n);
+    return true;
+  }
+  unsigned length() const {
+    return static_cast<unsigned>(s.size());
+  }
+  const char* c_str() const {
+    return s.c_str();
+  }
+
+  bool concat(const char* cstr, unsigned length) {
+    s.append(cstr, length);
+    return true;
+  }
+
+  String& operator+=(const String& o) {
+    s += o.s;
+    return *this;
+  }
+  String& operator+=(const char* o) {
+    s += o;
+    return *this;
+  }
+  String& operator+=(char o) {
+    s += o;
+    return *this;
+  }
+  String& operator+=(int o) {
+    s += std::to_string(o);
+    return *this;
+  }
+  String& operator+=(uint8_t o) {
+    s += std::to_string(o);
+    return *this;
+  }
+  friend String operator+(const String& a, const String& b) {
+    return String(a.s + b.s);
+  }
+  friend String operator+(const String& a, const char* b) {
+    return String(a.s + b);
+  }
+  friend String operator+(const char* a, const String& b) {
+    return String(a + b.s);
+  }
+  bool operator==(const char* o) const {
+    return s == o;
+  }
+  bool operator!=(const char* o) const {
+    return s != o;
+  }
+  bool operator==(const String& o) const {
+    return s == o.s;
+  }
+  char operator[](unsigned i) const {
+    return s[i];
+  }
+  char charAt(unsigned i) const {
+    return s[i];
+  }
+
+  bool endsWith(const char* o) const {
+    size_t n = strlen(o);
+    return s.size() >= n && s.compare(s.size() - n, n, o) == 0;
+  }
+  bool endsWith(const String& o) const {
+    return endsWith(o.c_str());
+  }
+  bool startsWith(const char* o) const {
+    return s.rfind(o, 0) == 0;
+  }
+  int indexOf(const char* o) const {
+    size_t p = s.find(o);
+    return p == std::string::npos ? -1 : static_cast<int>(p);
+  }
+  int indexOf(char o) const {
+    size_t p = s.find(o);
+    return p == std::string::npos ? -1 : static_cast<int>(p);
+  }
+  void replace(const char* a, const char* b) {
+    size_t p = 0;
+    while ((p = s.find(a, p)) != std::string::npos) {
+      s.replace(p, strlen(a), b);
+      p += strlen(b);
+    }
+  }
+  void trim() {
+    while (!s.empty() && isspace(static_cast<unsigned char>(s.back()))) {
+      s.pop_back();
+    }
+    size_t i = 0;
+    while (i < s.size() && isspace(static_cast<unsigned char>(s[i]))) { i++; }
+    s.erase(0, i);
+  }
+  void remove(unsigned i) {
+    s.erase(i);
+  }
+  void remove(unsigned i, unsigned n) {
+    s.erase(i, n);
+  }
+  long toInt() const {
+    return atol(s.c_str());
+  }
+  String substring(unsigned a) const {
+    return String(s.substr(a));
+  }
+  String substring(unsigned a, unsigned b) const {
+    return String(s.substr(a, b - a));
+  }
+
+ private:
+  std::string s;
+};
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t* b, size_t n) {
+    size_t i = 0;
+    for (; i < n; i++) { write(b[i]); }
+    return i;
+  }
+  size_t write(const char* s) {
+    return write(reinterpret_cast<const uint8_t*>(s), strlen(s));
+  }
+  size_t print(const char* s) {
+    return write(s);
+  }
+  size_t print(const String& s) {
+    return write(s.c_str());
+  }
+  size_t print(char c) {
+    return write(static_cast<uint8_t>(c));
+  }
+  size_t print(int v, int = DEC) {
+    return print(String(v));
+  }
+  size_t print(unsigned v, int = DEC) {
+    return print(String(v));
+  }
+  size_t print(long v, int = DEC) {
+    return print(String(v));
+  }
+  size_t print(unsigned long v, int = DEC) {
+    return print(String(v));
+  }
+  size_t print(double v) {
+    return print(String(std::to_string(v)));
+  }
+  size_t println(const char* s) {
+    return print(s) + print("\r\n");
+  }
+  virtual void flush() {}
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read()      = 0;
+  virtual int peek()      = 0;
+
+  void setTimeout(unsigned long t) {
+    _timeout = t;
+  }
+  unsigned long getTimeout() {
+    return _timeout;
+  }
+
+  virtual size_t readBytes(char* b, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+      int c = timedRead();
+      if (c < 0) { break; }
+      b[i++] = static_cast<char>(c);
+    }
+    return i;
+  }
+  size_t readBytes(uint8_t* b, size_t n) {
+    return readBytes(reinterpret_cast<char*>(b), n);
+  }
+  size_t readBytesUntil(char t, char* b, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+      int c = timedRead();
+      if (c < 0 || c == t) { break; }
+      b[i++] = static_cast<char>(c);
+    }
+    return i;
+  }
+  String readStringUntil(char t) {
+    String r;
+    int    c;
+    while ((c = timedRead()) >= 0 && c != t) { r += static_cast<char>(c); }
+    return r;
+  }
+  String readString() {
+    String r;
+    int    c;
+    while ((c = timedRead()) >= 0) { r += static_cast<char>(c); }
+    return r;
+  }
+  long parseInt() {
+    int c;
+    while ((c = peek()) >= 0 && !(isDigit(c) || c == '-')) { read(); }
+    bool neg = false;
+    if (peek() == '-') {
+      neg = true;
+      read();
+    }
+    long v = 0;
+    while ((c = peek()) >= 0 && isDigit(c)) {
+      v = v * 10 + (c - '0');
+      read();
+    }
+    return neg ? -v : v;
+  }
+
+ protected:
+  int timedRead() {
+    unsigned long s = millis();
+    do {
+      int c = read();
+      if (c >= 0) { return c; }
+    } while (millis() - s < _timeout);
+    return -1;
+  }
+
+  unsigned long _timeout = 1000;
+};
+
+class IPAddress {
+ public:
+  IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0)  // NOLINT
+      : _b{a, b, c, d} {}
+  uint8_t operator[](int i) const {
+    return _b[i];
+  }
+  bool operator!=(const IPAddress& o) const {
+    return memcmp(_b, o._b, 4) != 0;
+  }
+
+ private:
+  uint8_t _b[4];
+};
+
+#endif  // TEST_HOST_STUBS_ARDUINO_H_
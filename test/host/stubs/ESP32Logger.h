@@ -0,0 +1,54 @@
+/**
+ * @file       ESP32Logger.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The logger macros of the library, for the host tests: the format and the
+ * arguments are still checked by the compiler, nothing is printed unless
+ * TINY_GSM_HOST_LOG is defined.  Like a build without logging, the condition
+ * of DBGCHK() is then not evaluated.  With TINY_GSM_HOST_NO_LOGGER the
+ * macros are empty, like with the logger switched off.
+ */
+
+#ifndef TEST_HOST_STUBS_ESP32LOGGER_H_
+#define TEST_HOST_STUBS_ESP32LOGGER_H_
+
+#include <cstdio>
+
+#ifndef __FILENAME__
+#define __FILENAME__ __FILE__
+#endif
+
+#if defined TINY_GSM_HOST_NO_LOGGER
+// Like a build with the logger switched off: nothing of the log is compiled.
+#define DBGLOG(lvl, ...) {}
+#define DBGCHK(lvl, cond, ...) {}
+#define DBGCHX(lvl, cond, fmt1, fmt2, ...) {}
+#define DBGCOD(...)
+#define DBGB2S(b) ((b) ? "true" : "false")
+#else
+
+#if defined TINY_GSM_HOST_LOG
+#define TINY_GSM_HOST_PRINT 1
+#else
+#define TINY_GSM_HOST_PRINT 0
+#endif
+
+#define DBGLOG(lvl, ...) \
+  { if (TINY_GSM_HOST_PRINT) { printf(__VA_ARGS__); printf("\n"); } }
+#define DBGCHK(lvl, cond, ...) \
+  { if (TINY_GSM_HOST_PRINT && !(cond)) { printf(__VA_ARGS__); printf("\n"); } }
+#define DBGCHX(lvl, cond, fmt1, fmt2, ...) \
+  { if (TINY_GSM_HOST_PRINT) { printf((cond) ? fmt2 : fmt1, __VA_ARGS__); } }
+#define DBGCOD(...) __VA_ARGS__
+#define DBGB2S(b) ((b) ? "true" : "false")
+
+#ifndef MS_LOGGER_ON
+#define MS_LOGGER_ON
+#endif
+
+#endif  // TINY_GSM_HOST_NO_LOGGER
+
+#endif  // TEST_HOST_STUBS_ESP32LOGGER_H_
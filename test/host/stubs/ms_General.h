@@ -0,0 +1,28 @@
+/**
+ * @file       ms_General.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The helpers of ms_General the library uses, for the host tests.
+ */
+
+#ifndef TEST_HOST_STUBS_MS_GENERAL_H_
+#define TEST_HOST_STUBS_MS_GENERAL_H_
+
+#include <cstring>
+#include <string>
+
+inline char* ms_strncpy(char* d, const char* s, size_t n, size_t max) {
+  size_t k = n < max - 1 ? n : max - 1;
+  memcpy(d, s, k);
+  d[k] = '\0';
+  return d;
+}
+
+inline std::string asCharString(const char* s, int start, int n) {
+  return std::string(s + start, n);
+}
+
+#endif  // TEST_HOST_STUBS_MS_GENERAL_H_
@@ -0,0 +1,122 @@
+/**
+ * @file       test_bring_up.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The bring-up state machine: init and restart driven by maintain(), the
+ * pin, a failing step, the blocking init() on top of it.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+
+// Drive the bring-up by maintain() until it ends; the states it went
+// through as bits.
+static uint16_t drive(TinyGsmSim7080& modem, uint32_t timeout_ms = 10000) {
+  uint16_t seen  = 0;
+  uint32_t start = millis();
+  while (modem.bringUpRunning() && millis() - start < timeout_ms) {
+    seen |= 1U << modem.bringUpState();
+    modem.maintain();
+    delay(1);
+  }
+  return seen | (1U << modem.bringUpState());
+}
+
+static void testInit() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  fm.answer("AT+CPIN?", "\r\n+CPIN: READY\r\n\r\nOK\r\n");
+  fm.answer("AT+CMEE=1", "\r\nERROR\r\n");  // optional
+
+  CHECK(modem.bringUpState() == TINY_GSM_BRINGUP_IDLE && modem.bringUpProgress() == 0);
+  CHECK(modem.beginInit());
+  CHECK(!modem.beginInit());
+  CHECK(modem.bringUpRunning());
+  CHECK(modem.bringUpEta() > 0);
+
+  uint16_t seen = drive(modem);
+  CHECK(modem.bringUpState() == TINY_GSM_BRINGUP_READY);
+  CHECK(seen == ((1U << TINY_GSM_BRINGUP_PROBE) | (1U << TINY_GSM_BRINGUP_CONFIG) |
+                 (1U << TINY_GSM_BRINGUP_SIM) | (1U << TINY_GSM_BRINGUP_READY)));
+  CHECK(modem.bringUpProgress() == 100 && modem.bringUpEta() == 0);
+  CHECK(fm.sent() ==
+        "ATE0\r\nAT+CMEE=1\r\nAT+CLTS=1\r\nAT+CBATCHK=1\r\nAT+CPIN?\r\n");
+  CHECK(!modem.lockScheduler().blocked());
+
+  // The blocking init() takes the same steps
+  CHECK(modem.init());
+  CHECK(fm.calls("AT+CPIN?") == 2);
+}
+
+static void testPin() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  fm.answer("AT+CPIN?", "\r\n+CPIN: SIM PIN\r\n\r\nOK\r\n");
+
+  CHECK(modem.beginInit("1234"));
+  uint32_t start = millis();
+  while (modem.bringUpRunning() && millis() - start < 5000) {
+    if (fm.calls("AT+CPIN=\"1234\"") > 0) {
+      fm.answer("AT+CPIN?", "\r\n+CPIN: READY\r\n\r\nOK\r\n");
+    }
+    modem.maintain();
+    delay(1);
+  }
+  CHECK(modem.bringUpState() == TINY_GSM_BRINGUP_READY);
+  CHECK(fm.calls("AT+CPIN=\"1234\"") == 1 && fm.calls("AT+CPIN?") == 2);
+
+  // Still locked after the pin
+  fm.answer("AT+CPIN?", "\r\n+CPIN: SIM PIN\r\n\r\nOK\r\n");
+  CHECK(modem.beginInit("0000"));
+  drive(modem);
+  CHECK(modem.bringUpState() == TINY_GSM_BRINGUP_FAILED);
+  CHECK(fm.calls("AT+CPIN=\"0000\"") == 1);
+}
+
+static void testRestart() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  fm.answer("AT+CPIN?", "\r\n+CPIN: READY\r\n\r\nOK\r\n");
+
+  // The module listens again some time after the reboot; meanwhile the
+  // modem is free for others
+  fm.answer("AT+CSQ", "\r\n+CSQ: 12,99\r\n\r\nOK\r\n");
+  // (a status query is housekeeping: held back a while after maintain())
+  CHECK(modem.beginRestart());
+  uint16_t seen  = 0;
+  uint32_t start = millis();
+  while (modem.bringUpState() != TINY_GSM_BRINGUP_BOOTING && millis() - start < 1000) {
+    seen |= 1U << modem.bringUpState();
+    modem.maintain();
+    delay(1);
+  }
+  start = millis();
+  CHECK(modem.getSignalQuality() == 12);
+  CHECK(millis() - start < TINY_GSM_SCHED_DATA_HOLD_MS + 100);
+  CHECK(modem.bringUpState() == TINY_GSM_BRINGUP_BOOTING);
+  seen |= drive(modem);
+  CHECK(modem.bringUpState() == TINY_GSM_BRINGUP_READY);
+  CHECK(seen & (1U << TINY_GSM_BRINGUP_CFUN_OFF));
+  CHECK(seen & (1U << TINY_GSM_BRINGUP_CFUN_ON));
+  CHECK(seen & (1U << TINY_GSM_BRINGUP_REBOOT));
+  CHECK(fm.calls("AT+CREBOOT") == 1 && fm.calls("ATE0") == 2);
+
+  // A failing step ends it
+  fm.answer("AT+CFUN=0", "\r\nERROR\r\n");
+  CHECK(modem.beginRestart());
+  drive(modem);
+  CHECK(modem.bringUpState() == TINY_GSM_BRINGUP_FAILED);
+  CHECK(fm.calls("AT+CREBOOT") == 1);
+  CHECK(!modem.lockScheduler().blocked());
+}
+
+int main() {
+  testInit();
+  testPin();
+  testRestart();
+  return tinyGsmTestResult("test_bring_up");
+}
@@ -0,0 +1,102 @@
+/**
+ * @file       test_budget.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * TinyGsmBudget, and maintain() within a budget against a URC flood.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <thread>
+
+static void testBudget() {
+  TinyGsmBudget none;
+  CHECK(!none.set() && !none.exhausted(SIZE_MAX - 1));
+  CHECK(none.remaining_ms() == UINT32_MAX && none.cap(15) == 15);
+
+  TinyGsmBudget bytes(1000000, 100);
+  CHECK(bytes.set() && !bytes.exhausted());
+  bytes.spend(60);
+  CHECK(bytes.bytes() == 40 && !bytes.exhausted() && bytes.exhausted(40));
+  bytes.spend(60);
+  CHECK(bytes.bytes() == 0 && bytes.exhausted());
+
+  TinyGsmBudget time(20000);
+  CHECK(time.cap(1000) <= 20 && time.cap(5) == 5);
+  delay(30);
+  CHECK(time.exhausted() && time.remaining_us() == 0 && time.cap(1000) == 0);
+}
+
+static const char* networkName() {
+  return "\r\n*PSNWID: \"262\",\"01\",\"Net\",0,\"Net\",0\r\n";
+}
+
+static void testMaintain() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  std::string    flood;
+  for (int i = 0; i < 300; i++) { flood += networkName(); }
+
+  // A byte budget ends with the line being read
+  // (modem.stream is the buffer in front of fm, its available() counts both)
+  fm.push(flood);
+  size_t before = modem.stream.available();
+  CHECK(modem.maintain(1000000, 500));
+  size_t used = before - modem.stream.available();
+  CHECK(used >= 500 && used < 500 + strlen(networkName()));
+
+  // A time budget bounds each call, the rest is left pending
+  int      calls = 0;
+  uint32_t worst = 0;
+  bool     pending = true;
+  while (pending && calls < 10000) {
+    uint32_t start = micros();
+    pending        = modem.maintain(200);
+    worst          = TinyGsmMax(worst, static_cast<uint32_t>(micros() - start));
+    calls++;
+  }
+  CHECK(!pending && calls > 1);
+  CHECK(worst < 200 + 20000);  // a line is finished, the host is not real time
+  CHECK(fm.available() == 0);
+
+  // The modem is busy: return at once, pending
+  std::thread owner([&modem] {
+    modem.lockScheduler().acquire(TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX,
+                                  UINT32_MAX);
+    delay(200);
+    modem.lockScheduler().release();
+  });
+  delay(20);
+  uint32_t start = millis();
+  CHECK(modem.maintain(5000));
+  CHECK(millis() - start < 100);
+  owner.join();
+  CHECK(!modem.maintain(5000));
+
+  // A line still arriving is left unread when the budget is spent
+  TinyGsmEvent ev;
+  while (modem.pollEvent(ev)) {}
+  fm.push("\r\n*PSNWID: \"26");
+  modem.maintain(1000000, 3);
+  CHECK(!modem.pollEvent(ev));
+  fm.push("2\",\"01\",\"Net\",0,\"Net\",0\r\n");
+  modem.maintain();
+  bool got = false;
+  while (modem.pollEvent(ev)) {
+    if (ev.type == TINY_GSM_EVENT_NETWORK_NAME) {
+      got = strstr(ev.text, "\"262\",\"01\"") != nullptr;
+    }
+    CHECK(ev.type != TINY_GSM_EVENT_UNKNOWN_URC);
+  }
+  CHECK(got);
+}
+
+int main() {
+  testBudget();
+  testMaintain();
+  return tinyGsmTestResult("test_budget");
+}
@@ -0,0 +1,88 @@
+/**
+ * @file       test_buffered_stream.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The buffered stream: the UART read in chunks, nothing read ahead lost.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <string>
+
+// Counts the reads of the underlying stream.
+class ReadCounter : public FakeModem {
+ public:
+  int read() override {
+    reads++;
+    return FakeModem::read();
+  }
+  size_t readBytes(char* buf, size_t length) override {
+    chunks++;
+    return FakeModem::readBytes(buf, length);
+  }
+  int reads  = 0;
+  int chunks = 0;
+};
+
+static void testChunk() {
+  ReadCounter              s;
+  TinyGsmBufferedStream<8> b(s);
+  CHECK(b.fill() == 0 && b.buffered() == 0);
+
+  // One read for what fits the chunk
+  s.push("0123456789");
+  CHECK(b.fill() == 8 && s.chunks == 1);
+  CHECK(std::string(b.buffer(), b.buffered()) == "01234567");
+  CHECK(b.available() == 10);
+  b.consume(3);
+  CHECK(b.buffered() == 5 && b.consumed() == 3 && b.available() == 7);
+
+  // Filling again keeps what is unread
+  CHECK(b.fill() == 5 && s.chunks == 1);
+
+  // The usual functions return the unread bytes first
+  CHECK(b.peek() == '3' && b.read() == '3');
+  char buf[8];
+  CHECK(b.readBytes(buf, 6) == 6);
+  CHECK(std::string(buf, 6) == "456789");
+  CHECK(b.consumed() == 10 && b.available() == 0);
+  CHECK(b.read() == -1 && b.peek() == -1);
+  CHECK(s.reads == 0);
+
+  // Consuming more than buffered stops at the end
+  s.push("ab");
+  CHECK(b.fill() == 2);
+  b.consume(5);
+  CHECK(b.buffered() == 0 && b.consumed() == 12);
+}
+
+static void testWrite() {
+  FakeModem                s;
+  TinyGsmBufferedStream<8> b(s);
+  b.write(reinterpret_cast<const uint8_t*>("AT"), 2);
+  b.write('\r');
+  b.write('\n');
+  CHECK(s.sent() == "AT\r\n");
+  CHECK(b.fill() == 6);
+  CHECK(std::string(b.buffer(), b.buffered()) == "\r\nOK\r\n");
+}
+
+static void testModem() {
+  // The response is scanned in chunks, not byte by byte
+  ReadCounter    fm;
+  TinyGsmSim7080 modem(fm);
+  fm.answer("AT+CSQ", "\r\n+CSQ: 20,99\r\n\r\nOK\r\n");
+  CHECK(modem.getSignalQuality() == 20);
+  CHECK(fm.reads == 0 && fm.chunks >= 1 && fm.chunks <= 4);
+}
+
+int main() {
+  testChunk();
+  testWrite();
+  testModem();
+  return tinyGsmTestResult("test_buffered_stream");
+}
@@ -0,0 +1,104 @@
+/**
+ * @file       test_command_batch.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * TinyGsmCommandBatch and TinyGsmModem::sendATBatch() against a fake modem.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+
+static void testBatch() {
+  TinyGsmCommandBatch<64, 4> b;
+  CHECK(b.add(GF("+A=\""), "apn", '"'));
+  CHECK(b.addOptional(GF("+B")));
+  CHECK(b.addTimed(60000L, GF("+C="), 1));
+  CHECK(b.count() == 3 && b.valid());
+  CHECK(strcmp(b.command(0), "+A=\"apn\"") == 0);
+  CHECK(strcmp(b.command(2), "+C=1") == 0);
+  CHECK(!b.optional(0) && b.optional(1));
+  CHECK(b.timeout(0) == 1000 && b.timeout(2) == 60000);
+
+  // A command that does not fit is not added, and the batch is not sent
+  TinyGsmCommandBatch<10, 2> small;
+  CHECK(small.add(GF("+ABC")));
+  CHECK(!small.add(GF("+DEFGHIJ")));
+  CHECK(!small.valid() && small.count() == 1);
+  // What fits afterwards is added, the batch stays invalid
+  CHECK(small.add(GF("+X")));
+  CHECK(!small.valid() && small.count() == 2);
+  small.clear();
+  CHECK(small.valid() && small.count() == 0);
+}
+
+static void testSendBatch() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+
+  // The commands share a line, optional ones included
+  TinyGsmATBatch b;
+  b.add(GF("+A"));
+  b.add(GF("+B="), 1);
+  b.addOptional(GF("+C"));
+  CHECK(modem.sendATBatch(b));
+  CHECK(fm.sent() == "AT+A;+B=1;+C\r\n");
+  CHECK(b.result(0) == 1 && b.result(1) == 1 && b.result(2) == 1);
+
+  // ERROR of a line: its commands are sent one by one to find the failing
+  // one; a failing optional command does not fail the batch
+  fm.answer("AT+A;+B=1;+C", "\r\nERROR\r\n");
+  fm.answer("AT+C", "\r\nERROR\r\n");
+  CHECK(modem.sendATBatch(b));
+  CHECK(fm.sent() == "AT+A;+B=1;+C\r\nAT+A\r\nAT+B=1\r\nAT+C\r\n");
+  CHECK(b.result(0) == 1 && b.result(1) == 1 && b.result(2) == 2);
+
+  // An unchained command is sent alone, and not again for a failed line
+  TinyGsmATBatch u;
+  u.add(GF("+S1"));
+  u.addUnchained(60000L, GF("+ATT"));
+  u.add(GF("+S2"));
+  u.addOptional(GF("+S3"));
+  fm.answer("AT+S2;+S3", "\r\nERROR\r\n");
+  CHECK(modem.sendATBatch(u));
+  CHECK(fm.sent() == "AT+S1\r\nAT+ATT\r\nAT+S2;+S3\r\nAT+S2\r\nAT+S3\r\n");
+  CHECK(fm.calls("AT+ATT") == 1);
+  CHECK(u.timeout(1) == 60000 && u.unchained(1) && !u.unchained(2));
+
+  // The batch stops at the first failing required command
+  TinyGsmATBatch c;
+  c.add(GF("+D"));
+  c.add(GF("+E"));
+  c.add(GF("+F"));
+  fm.answer("AT+D;+E;+F", "\r\nERROR\r\n");
+  fm.answer("AT+E", "\r\n+CME ERROR: 30\r\n");
+  CHECK(!modem.sendATBatch(c));
+  CHECK(fm.sent() == "AT+D;+E;+F\r\nAT+D\r\nAT+E\r\n");
+  CHECK(c.result(0) == 1 && c.result(1) == 0 && c.result(2) == 0);
+
+  // No answer to a line: it is not sent again
+  TinyGsmATBatch d;
+  d.add(GF("+G"));
+  d.add(GF("+H"));
+  fm.answer("AT+G;+H", "");
+  uint32_t start = millis();
+  CHECK(!modem.sendATBatch(d));
+  CHECK(millis() - start >= 2000);  // the sum of the timeouts of the line
+  CHECK(fm.sent() == "AT+G;+H\r\n");
+
+  // An invalid batch is not sent at all
+  TinyGsmCommandBatch<10, 2> small;
+  small.add(GF("+ABC"));
+  small.add(GF("+DEFGHIJ"));
+  CHECK(!modem.sendATBatch(small));
+  CHECK(fm.sent().empty());
+}
+
+int main() {
+  testBatch();
+  testSendBatch();
+  return tinyGsmTestResult("test_command_batch");
+}
@@ -0,0 +1,102 @@
+/**
+ * @file       test_command_buffer.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The command buffer: the same text as print(), one write per command, long
+ * commands written in parts.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <string>
+
+// Counts the writes of a whole buffer.
+class WriteCounter : public FakeModem {
+ public:
+  using FakeModem::write;
+  size_t write(const uint8_t* b, size_t n) override {
+    writes++;
+    return FakeModem::write(b, n);
+  }
+  int writes = 0;
+};
+
+template <size_t N>
+static std::string text(const TinyGsmCommandBuffer<N>& cmd) {
+  return std::string(cmd.data(), cmd.length());
+}
+
+static void testAdd() {
+  TinyGsmCommandBuffer<64> cmd;
+  cmd.add("+CSQ");
+  cmd.add(String("=\"a\""));
+  cmd.add(',');
+  cmd.add(true);
+  cmd.add(false);
+  CHECK(text(cmd) == "+CSQ=\"a\",10");
+
+  cmd.truncate(0);
+  cmd.add(0);
+  cmd.add(' ');
+  cmd.add(-1);
+  cmd.add(' ');
+  cmd.add(static_cast<uint8_t>(255));
+  cmd.add(' ');
+  cmd.add(INT32_MIN);
+  cmd.add(' ');
+  cmd.add(UINT32_MAX);
+  CHECK(text(cmd) == "0 -1 255 -2147483648 4294967295");
+
+  cmd.truncate(0);
+  cmd.add(INT64_MIN);
+  cmd.add(' ');
+  cmd.add(INT64_MAX);
+  cmd.add(' ');
+  cmd.add(UINT64_MAX);
+  CHECK(text(cmd) ==
+        "-9223372036854775808 9223372036854775807 18446744073709551615");
+  CHECK(!cmd.overflow());
+}
+
+static void testOverflow() {
+  // Without stream what does not fit is dropped
+  TinyGsmCommandBuffer<8> cmd;
+  cmd.add("AT+CGDCONT");
+  CHECK(text(cmd) == "AT+CGDCO");
+  CHECK(cmd.overflow());
+  cmd.truncate(2);
+  CHECK(text(cmd) == "AT" && !cmd.overflow());
+  cmd.add(12345);
+  CHECK(text(cmd) == "AT12345");
+}
+
+static void testStream() {
+  // A long command is written in parts, not cut off
+  WriteCounter             s;
+  TinyGsmCommandBuffer<8> cmd(s);
+  cmd.add("AT+CGDCONT=1,\"IP\",\"internet\"");
+  cmd.add("\r\n");
+  cmd.send();
+  CHECK(s.sent() == "AT+CGDCONT=1,\"IP\",\"internet\"\r\n");
+  CHECK(s.writes == 4);
+  CHECK(!cmd.overflow() && cmd.length() == 0);
+
+  // A command of the modem is a single write
+  WriteCounter   fm;
+  TinyGsmSim7080 modem(fm);
+  fm.answer("AT+CSQ", "\r\n+CSQ: 20,99\r\n\r\nOK\r\n");
+  CHECK(modem.getSignalQuality() == 20);
+  CHECK(fm.sent() == "AT+CSQ\r\n");
+  CHECK(fm.writes == 1);
+}
+
+int main() {
+  testAdd();
+  testOverflow();
+  testStream();
+  return tinyGsmTestResult("test_command_buffer");
+}
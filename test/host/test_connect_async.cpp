@@ -0,0 +1,111 @@
+/**
+ * @file       test_connect_async.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * connectAsync(): the result with the +CAOPEN URC, no result in time, no
+ * result in time while a submitted command is in flight.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+
+static int connectCalls  = 0;
+static int connectResult = -2;
+
+static void connected(TinyGsmSim7080::GsmClientSim7080&, int8_t result, void*) {
+  connectCalls++;
+  connectResult = result;
+}
+
+static void testResult() {
+  FakeModem                        fm;
+  TinyGsmSim7080                   modem(fm);
+  TinyGsmSim7080::GsmClientSim7080 client(modem, 0);
+
+  connectCalls = 0;
+  CHECK(client.connectAsync("example.com", 80, 75, connected));
+  CHECK(client.connectState() == TINY_GSM_CONNECT_PENDING);
+  modem.maintain();
+  CHECK(client.connectState() == TINY_GSM_CONNECT_PENDING);
+
+  fm.push("\r\n+CAOPEN: 0,0\r\n");
+  modem.maintain();
+  CHECK(client.connectState() == TINY_GSM_CONNECT_DONE);
+  CHECK(client.connectResult() == 0 && connectCalls == 1 && connectResult == 0);
+
+  // A refused connect
+  CHECK(client.connectAsync("example.com", 81, 75, connected));
+  fm.push("\r\n+CAOPEN: 0,23\r\n");
+  modem.maintain();
+  CHECK(client.connectState() == TINY_GSM_CONNECT_FAILED);
+  CHECK(client.connectResult() == 23 && connectCalls == 2);
+
+  // The modem does not take it
+  fm.answer("AT+CAOPEN=0,0,\"TCP\",\"example.com\",82", "\r\nERROR\r\n");
+  CHECK(!client.connectAsync("example.com", 82, 75, connected));
+  CHECK(client.connectState() == TINY_GSM_CONNECT_FAILED);
+}
+
+static void testExpiry() {
+  FakeModem                        fm;
+  TinyGsmSim7080                   modem(fm);
+  TinyGsmSim7080::GsmClientSim7080 client(modem, 0);
+
+  connectCalls = 0;
+  CHECK(client.connectAsync("example.com", 80, 1, connected));
+  fm.sent();
+  modem.maintain();
+  CHECK(client.connectState() == TINY_GSM_CONNECT_PENDING);
+  delay(1100);
+  modem.maintain();
+  CHECK(client.connectState() == TINY_GSM_CONNECT_FAILED);
+  CHECK(connectCalls == 1 && connectResult == -1);
+  CHECK(fm.sent().find("AT+CACLOSE=0\r\n") != std::string::npos);
+
+  // A late result is not taken
+  fm.push("\r\n+CAOPEN: 0,0\r\n");
+  modem.maintain();
+  CHECK(client.connectState() == TINY_GSM_CONNECT_FAILED && connectCalls == 1);
+}
+
+static void testExpiryInFlight() {
+  FakeModem                        fm;
+  TinyGsmSim7080                   modem(fm);
+  TinyGsmSim7080::GsmClientSim7080 client(modem, 0);
+
+  connectCalls = 0;
+  CHECK(client.connectAsync("example.com", 80, 1, connected));
+  TinyGsmATRequest slow;
+  slow.command(GF("+SLOW")).timeout(5000);
+  fm.answer("AT+SLOW", "");
+  CHECK(modem.submitAT(slow));
+  modem.pollAT();
+  fm.sent();
+
+  // The connect fails in time, the close waits for the command in flight
+  delay(1100);
+  uint32_t start = millis();
+  modem.maintain();
+  CHECK(millis() - start < 100);
+  CHECK(client.connectState() == TINY_GSM_CONNECT_FAILED && connectCalls == 1);
+  CHECK(slow.state() == TINY_GSM_AT_RUNNING);
+  CHECK(fm.sent() == "");
+
+  fm.push("\r\nOK\r\n");
+  modem.maintain();
+  CHECK(slow.result() == 1);
+  modem.maintain();
+  CHECK(fm.sent() == "AT+CACLOSE=0\r\n");
+  CHECK(!modem.pollAT());
+}
+
+int main() {
+  testResult();
+  testExpiry();
+  testExpiryInFlight();
+  return tinyGsmTestResult("test_connect_async");
+}
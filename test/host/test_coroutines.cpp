@@ -0,0 +1,148 @@
+/**
+ * @file       test_coroutines.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The coroutine front-end: tasks resumed by the event loop of the modem,
+ * gprsConnectAsync() within its time budget, readAsync() woken by the data
+ * URC or the close of the socket.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#define TINY_GSM_COROUTINES
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <thread>
+
+typedef TinyGsmSim7080::GsmClientSim7080 SimClient;
+
+// Runs the event loop until the started task is done
+template <class Task>
+static void drive(TinyGsmSim7080& modem, Task& t, uint32_t timeout_ms = 3000) {
+  uint32_t start = millis();
+  while (!t.done() && millis() - start < timeout_ms) {
+    modem.eventLoop().runOnce();
+    delay(1);
+  }
+}
+
+template <class Task>
+static void run(TinyGsmSim7080& modem, Task& t) {
+  modem.eventLoop().start(t);
+  drive(modem, t);
+}
+
+static TinyGsmTask<int> reader(SimClient& c, uint8_t* buf, size_t n) {
+  int got = co_await c.readAsync(buf, n, 2000);
+  co_return got;
+}
+
+static void testCommands() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  fm.answer("AT+CSQ", "\r\n+CSQ: 21,99\r\n\r\nOK\r\n");
+  fm.answer("AT+CNACT=0,1", "\r\nOK\r\n\r\n+APP PDP: 0,ACTIVE\r\n");
+
+  auto at = modem.testATAsync();
+  run(modem, at);
+  CHECK(at.done() && at.result());
+
+  auto csq = modem.getSignalQualityAsync();
+  run(modem, csq);
+  CHECK(csq.done() && csq.result() == 21);
+
+  auto gprs = modem.gprsConnectAsync("apn", "user", "pwd");
+  run(modem, gprs);
+  CHECK(gprs.done() && gprs.result());
+
+  fm.answer("AT+CGATT=1", "\r\nERROR\r\n");
+  auto attach = modem.gprsConnectAsync("apn");
+  run(modem, attach);
+  CHECK(attach.done() && !attach.result());
+  fm.answer("AT+CGATT=1", "\r\nOK\r\n");
+
+  // ERROR to +CNACT ends the wait for the URC at once
+  fm.answer("AT+CNACT=0,1", "\r\nERROR\r\n");
+  uint32_t start = millis();
+  auto     act   = modem.gprsConnectAsync("apn");
+  run(modem, act);
+  CHECK(act.done() && !act.result() && millis() - start < 1000);
+
+  // No URC within the time budget
+  fm.answer("AT+CNACT=0,1", "\r\nOK\r\n");
+  start       = millis();
+  auto budget = modem.gprsConnectAsync("apn", nullptr, nullptr, 300);
+  run(modem, budget);
+  CHECK(budget.done() && !budget.result() && millis() - start < 600);
+}
+
+static void testRead() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  SimClient      client(modem, 0);
+  fm.answer("AT+CAOPEN=0,0,\"TCP\",\"example.com\",80", "\r\nOK\r\n\r\n+CAOPEN: 0,0\r\n");
+  fm.answer("AT+CASTATE?", "\r\n+CASTATE: 0,1\r\n\r\nOK\r\n");
+  fm.answer("AT+CARECV=0,5", "\r\n+CARECV: 5,hello\r\n\r\nOK\r\n");
+  CHECK(client.connect("example.com", 80, 10) == 1);
+
+  // Nothing there, then the URC announces data
+  uint8_t buf[16] = {};
+  auto    t       = reader(client, buf, sizeof(buf));
+  modem.eventLoop().start(t);
+  for (int i = 0; i < 50; i++) {
+    modem.eventLoop().runOnce();
+    delay(1);
+  }
+  CHECK(!t.done());
+  fm.answer("AT+CARECV?", "\r\n+CARECV: 0,5\r\n\r\nOK\r\n");
+  fm.push("\r\n+CADATAIND: 0\r\n");
+  drive(modem, t);
+  CHECK(t.done() && t.result() == 5 && memcmp(buf, "hello", 5) == 0);
+  fm.answer("AT+CARECV?", "\r\nOK\r\n");
+
+  // A waiting reader does not block the event loop while the modem is busy
+  auto busy = reader(client, buf, sizeof(buf));
+  modem.eventLoop().start(busy);
+  std::thread other([&modem] {
+    modem.lockScheduler().acquire(TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX, UINT32_MAX);
+    delay(300);
+    modem.lockScheduler().release();
+  });
+  delay(20);
+  fm.answer("AT+CARECV?", "\r\n+CARECV: 0,5\r\n\r\nOK\r\n");
+  fm.push("\r\n+CADATAIND: 0\r\n");
+  uint32_t worst = 0;
+  for (int i = 0; i < 100; i++) {
+    uint32_t start = millis();
+    modem.eventLoop().runOnce();
+    worst = TinyGsmMax(worst, static_cast<uint32_t>(millis() - start));
+    delay(1);
+  }
+  other.join();
+  CHECK(worst < 50);
+  drive(modem, busy);
+  CHECK(busy.done() && busy.result() == 5);
+  // (the size was checked more than once meanwhile)
+  fm.answer("AT+CARECV?", "\r\nOK\r\n");
+  while (client.available()) { client.read(buf, sizeof(buf)); }
+
+  // The socket closes while the reader waits
+  auto closed = reader(client, buf, sizeof(buf));
+  modem.eventLoop().start(closed);
+  for (int i = 0; i < 20; i++) {
+    modem.eventLoop().runOnce();
+    delay(1);
+  }
+  fm.push("\r\n+CASTATE: 0,0\r\n");
+  uint32_t start = millis();
+  drive(modem, closed);
+  CHECK(closed.done() && closed.result() == 0 && millis() - start < 1000);
+}
+
+int main() {
+  testCommands();
+  testRead();
+  return tinyGsmTestResult("test_coroutines");
+}
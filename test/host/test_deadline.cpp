@@ -0,0 +1,77 @@
+/**
+ * @file       test_deadline.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * One deadline for all steps of an operation: every wait is capped by it,
+ * the operation ends with a timeout result when it passed.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+
+static void testDeadline() {
+  TinyGsmDeadline never;
+  CHECK(!never.set() && !never.expired());
+  CHECK(never.remaining() == UINT32_MAX && never.cap(5000) == 5000);
+
+  TinyGsmDeadline soon(100);
+  TinyGsmDeadline later(10000);
+  CHECK(soon.set() && !soon.expired());
+  CHECK(soon.cap(5000) <= 100 && later.cap(5000) == 5000);
+  CHECK(&later.earlier(soon) == &soon && &soon.earlier(later) == &soon);
+  CHECK(&never.earlier(soon) == &soon);
+  delay(120);
+  CHECK(soon.expired() && soon.remaining() == 0 && soon.cap(5000) == 0);
+}
+
+static void testGprs() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+
+  // No "+APP PDP: 0,ACTIVE": the 60 s wait for it ends with the deadline
+  uint32_t      start = millis();
+  TinyGsmResult r     = modem.gprsConnect("apn", nullptr, nullptr, 300);
+  uint32_t      took  = millis() - start;
+  CHECK(!r && r.code == TINY_GSM_RESULT_TIMEOUT);
+  CHECK(took >= 300 && took < 800);
+
+  // No answer at all to a step in between
+  fm.answer("AT+CGATT=1", "");
+  start = millis();
+  r     = modem.gprsConnect("apn", nullptr, nullptr, 300);
+  took  = millis() - start;
+  CHECK(!r && r.code == TINY_GSM_RESULT_TIMEOUT);
+  CHECK(took < 800);
+  CHECK(fm.calls("AT+CNACT=0,1") == 1);
+
+  // The next operation has its own deadline again, the late answer does not
+  // disturb it
+  fm.push("\r\nOK\r\n");
+  fm.answer("AT+CGATT=1", "\r\nOK\r\n");
+  fm.answer("AT+CNACT=0,1", "\r\nOK\r\n\r\n+APP PDP: 0,ACTIVE\r\n");
+  CHECK(modem.gprsConnect("apn", nullptr, nullptr, 300));
+}
+
+static void testConnect() {
+  FakeModem                        fm;
+  TinyGsmSim7080                   modem(fm);
+  TinyGsmSim7080::GsmClientSim7080 client(modem, 0);
+
+  // +CAOPEN: <cid>,<result> does not come
+  uint32_t start = millis();
+  CHECK(client.connect("example.com", 80, 1) == 0);
+  uint32_t took = millis() - start;
+  CHECK(client.connectStatus().code == TINY_GSM_RESULT_TIMEOUT);
+  CHECK(took >= 1000 && took < 1500);
+}
+
+int main() {
+  testDeadline();
+  testGprs();
+  testConnect();
+  return tinyGsmTestResult("test_deadline");
+}
@@ -0,0 +1,58 @@
+/**
+ * @file       test_handover.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The modem is handed over while an operation waits for its URC: other
+ * callers get it in between, the operation gets it back in its class.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <atomic>
+#include <thread>
+
+static void testOwner() {
+  TinyGsmScheduler s;
+  s.acquire(TINY_GSM_SCHED_DATA, 2, UINT32_MAX);
+  CHECK(s.ownerClass() == TINY_GSM_SCHED_DATA && s.ownerMux() == 2);
+  s.release();
+  CHECK(s.tryAcquire());
+  CHECK(s.ownerClass() == TINY_GSM_SCHED_CONTROL);
+  CHECK(s.ownerMux() == TINY_GSM_SCHED_NO_MUX);
+  s.release();
+}
+
+static void testConnect() {
+  FakeModem                        fm;
+  TinyGsmSim7080                   modem(fm);
+  TinyGsmSim7080::GsmClientSim7080 client(modem, 0);
+
+  // The connect waits for +CAOPEN, a status query comes in between
+  fm.answer("AT+CSQ", "\r\n+CSQ: 20,99\r\n\r\nOK\r\n");
+  std::atomic<bool> connected{false};
+  std::atomic<bool> connectDone{false};
+  std::thread       connector([&] {
+    connected   = client.connect("example.com", 80, 10) == 1;
+    connectDone = true;
+  });
+  delay(50);
+  uint32_t start = millis();
+  CHECK(modem.getSignalQuality() == 20);
+  CHECK(millis() - start < 500);
+  CHECK(!connectDone);
+
+  fm.push("\r\n+CAOPEN: 0,0\r\n");
+  connector.join();
+  CHECK(connected);
+  CHECK(!modem.lockScheduler().blocked());
+}
+
+int main() {
+  testOwner();
+  testConnect();
+  return tinyGsmTestResult("test_handover");
+}
@@ -0,0 +1,92 @@
+/**
+ * @file       test_identity.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The identity cache: read once, forgotten on "SMS Ready", read and
+ * forgotten from two threads.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <atomic>
+#include <thread>
+
+static void answerIdentity(FakeModem& fm) {
+  fm.answer("AT+CGMI", "\r\nSIMCOM INCORPORATED\r\n\r\nOK\r\n");
+  fm.answer("AT+CGMM", "\r\nSIMCOM_SIM7080G\r\n\r\nOK\r\n");
+  fm.answer("AT+CGMR", "\r\nERROR\r\n");
+}
+
+static void testCache() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  answerIdentity(fm);
+
+  CHECK(modem.getModemManufacturer() == "SIMCOM INCORPORATED");
+  CHECK(modem.getModemManufacturer() == "SIMCOM INCORPORATED");
+  CHECK(modem.getModemModel() == "SIMCOM_SIM7080G");
+  modem.getModemName();
+  CHECK(fm.calls("AT+CGMI") == 1 && fm.calls("AT+CGMM") == 1);
+
+  // A failed read is not kept
+  CHECK(modem.getModemRevision() == "unknown");
+  fm.answer("AT+CGMR", "\r\n1951B08SIM7080\r\n\r\nOK\r\n");
+  CHECK(modem.getModemRevision() == "1951B08SIM7080");
+  CHECK(modem.getModemRevision() == "1951B08SIM7080");
+  CHECK(fm.calls("AT+CGMR") == 2);
+
+  // An unexpected reset makes it read again
+  fm.push("\r\nSMS Ready\r\n");
+  modem.maintain();
+  TinyGsmEvent ev;
+  bool         reset = false;
+  while (modem.pollEvent(ev)) {
+    if (ev.type == TINY_GSM_EVENT_MODEM_RESET) { reset = true; }
+  }
+  CHECK(reset);
+  CHECK(modem.getModemManufacturer() == "SIMCOM INCORPORATED");
+  CHECK(fm.calls("AT+CGMI") == 2);
+
+  modem.invalidateIdentity();
+  CHECK(modem.getModemModel() == "SIMCOM_SIM7080G");
+  CHECK(fm.calls("AT+CGMM") == 2);
+}
+
+static void testTwoThreads() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  answerIdentity(fm);
+
+  // One thread reads the identity while the other one is told of resets
+  std::atomic<bool> stop{false};
+  std::atomic<int>  wrong{0};
+  std::thread       reader([&] {
+    while (!stop) {
+      if (modem.getModemManufacturer() != "SIMCOM INCORPORATED") { wrong++; }
+      if (modem.getModemModel() != "SIMCOM_SIM7080G") { wrong++; }
+    }
+  });
+  // (a reader of the identity is housekeeping: held back a while after
+  // maintain())
+  for (int i = 0; i < 10; i++) {
+    fm.push("\r\nSMS Ready\r\n");
+    modem.maintain();
+    delay(TINY_GSM_SCHED_DATA_HOLD_MS + 20);
+  }
+  stop = true;
+  reader.join();
+
+  CHECK(wrong == 0);
+  CHECK(fm.calls("AT+CGMI") > 1);
+  CHECK(!modem.lockScheduler().blocked());
+}
+
+int main() {
+  testCache();
+  testTwoThreads();
+  return tinyGsmTestResult("test_identity");
+}
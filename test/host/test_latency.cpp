@@ -0,0 +1,117 @@
+/**
+ * @file       test_latency.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * TinyGsmLatency, and the timeouts the modem learns with it.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#define TINY_GSM_LATENCY_LEARN 1
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <thread>
+
+static uint32_t key(const char* cmd) {
+  return TinyGsmLatency::key(cmd, strlen(cmd));
+}
+
+static void testLearn() {
+  TinyGsmLatency l;
+  // Not enough samples: the timeout of the code
+  for (int i = 0; i < TINY_GSM_LATENCY_MIN_SAMPLES - 1; i++) {
+    l.record(key("+CSQ"), 30);
+  }
+  CHECK(l.timeout(key("+CSQ"), 60000) == 60000);
+  l.record(key("+CSQ"), 30);
+  // 30 ms is in the bucket up to 32 ms
+  CHECK(l.timeout(key("+CSQ"), 60000) ==
+        32 * TINY_GSM_LATENCY_FACTOR + TINY_GSM_LATENCY_MARGIN_MS);
+  // Never longer than the timeout of the code
+  CHECK(l.timeout(key("+CSQ"), 500) == 500);
+  // Other commands keep theirs
+  CHECK(l.timeout(key("+CREG?"), 60000) == 60000);
+
+  // Timing out after the learned timeout makes it grow again
+  uint32_t learned = l.timeout(key("+CSQ"), 60000);
+  for (int i = 0; i < 3; i++) { l.recordTimeout(key("+CSQ"), learned); }
+  CHECK(l.timeout(key("+CSQ"), 60000) > learned);
+
+  l.clear();
+  CHECK(l.timeout(key("+CSQ"), 60000) == 60000);
+}
+
+static void testSaveLoad() {
+  TinyGsmLatency l;
+  for (int i = 0; i < TINY_GSM_LATENCY_MIN_SAMPLES; i++) {
+    l.record(key("+CGATT=1"), 700);
+  }
+  static uint8_t blob[TinyGsmLatency::saveSize()];
+  CHECK(l.save(blob, sizeof(blob) - 1) == 0);
+  CHECK(l.save(blob, sizeof(blob)) == sizeof(blob));
+
+  TinyGsmLatency m;
+  CHECK(m.load(blob, sizeof(blob)));
+  CHECK(m.timeout(key("+CGATT=1"), 60000) == l.timeout(key("+CGATT=1"), 60000));
+  // Data of another build is refused
+  blob[0] = 'X';
+  TinyGsmLatency n;
+  CHECK(!n.load(blob, sizeof(blob)));
+  CHECK(n.timeout(key("+CGATT=1"), 60000) == 60000);
+}
+
+static void testModem() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  for (int i = 0; i < TINY_GSM_LATENCY_MIN_SAMPLES + 5; i++) {
+    modem.sendAT(GF("+TEST="), i);
+    CHECK(modem.waitResponse(60000L) == 1);
+  }
+
+  // A hanging command is given up after the learned timeout
+  fm.answer("AT+TEST=99", "");
+  uint32_t start = millis();
+  modem.sendAT(GF("+TEST="), 99);
+  CHECK(modem.waitResponse(60000L) == 0);
+  uint32_t took = millis() - start;
+  CHECK(took >= TINY_GSM_LATENCY_MIN_TIMEOUT_MS && took < 5000);
+
+  // Its late OK is not taken for the response of the next command
+  std::thread late([&fm] {
+    delay(100);
+    fm.push("\r\nOK\r\n");
+  });
+  fm.answer("AT+NEXT", "\r\n+NEXT: 1\r\n\r\nOK\r\n");
+  modem.sendAT(GF("+NEXT"));
+  CHECK(modem.waitResponse(1000L, GF("+NEXT:"), GFP(GSM_OK)) == 1);
+  CHECK(modem.waitResponse() == 1);
+  late.join();
+
+  // A chained line of a batch drains the late response as well: the
+  // ERROR arriving late for +TEST=99 is not taken for the line's result
+  fm.answer("AT+TEST=98", "");
+  modem.sendAT(GF("+TEST="), 98);
+  CHECK(modem.waitResponse(60000L) == 0);
+  fm.push("\r\nERROR\r\n");
+  fm.sent();
+  TinyGsmATBatch b;
+  b.add(GF("+P"));
+  b.add(GF("+Q"));
+  CHECK(modem.sendATBatch(b));
+  CHECK(fm.sent() == "AT+P;+Q\r\n");
+
+  // What was learned survives a restart of the modem object
+  static uint8_t blob[TinyGsmSim7080::latencySaveSize()];
+  CHECK(modem.saveLatency(blob, sizeof(blob)) == sizeof(blob));
+  TinyGsmSim7080 modem2(fm);
+  CHECK(modem2.loadLatency(blob, sizeof(blob)));
+}
+
+int main() {
+  testLearn();
+  testSaveLoad();
+  testModem();
+  return tinyGsmTestResult("test_latency");
+}
@@ -0,0 +1,88 @@
+/**
+ * @file       test_lock_profile.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The lock profile: waits and holds counted per call site, the sites costing
+ * most first.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <string>
+#include <thread>
+
+static TinyGsmLockSite holder("holder", "test_lock_profile.cpp", 1);
+static TinyGsmLockSite waiter("waiter", "test_lock_profile.cpp", 2);
+
+class Collect : public Print {
+ public:
+  size_t write(uint8_t c) override {
+    text += static_cast<char>(c);
+    return 1;
+  }
+  std::string text;
+};
+
+static void testSites() {
+  TinyGsmScheduler s;
+  TinyGsmScheduler::resetContenders();
+
+  // The holder keeps the modem 200 ms, the waiter waits for it
+  CHECK(s.acquire(TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX, UINT32_MAX, &holder));
+  std::thread other([&s] {
+    s.acquire(TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX, UINT32_MAX, &waiter);
+    s.release();
+  });
+  delay(200);
+  s.release();
+  other.join();
+
+  TinyGsmLockStats top[4];
+  CHECK(TinyGsmScheduler::topContenders(top, 4, TINY_GSM_LOCK_BY_WAIT_TOTAL) == 2);
+  CHECK(strcmp(top[0].func, "waiter") == 0 && top[0].line == 2);
+  CHECK(top[0].acquisitions == 1 && top[0].contended == 1);
+  CHECK(top[0].waitTotal_ms >= 150 && top[0].waitMax_ms == top[0].waitTotal_ms);
+  CHECK(top[1].contended == 0 && top[1].waitTotal_ms == 0);
+
+  CHECK(TinyGsmScheduler::topContenders(top, 4, TINY_GSM_LOCK_BY_HOLD_MAX) == 2);
+  CHECK(strcmp(top[0].func, "holder") == 0 && top[0].holdMax_ms >= 190);
+
+  // Only as many as asked for
+  CHECK(TinyGsmScheduler::topContenders(top, 1, TINY_GSM_LOCK_BY_HOLD_TOTAL) == 1);
+  CHECK(strcmp(top[0].func, "holder") == 0);
+
+  Collect out;
+  TinyGsmScheduler::printContenders(out);
+  CHECK(out.text.find("waiter (test_lock_profile.cpp:2): 1x, 1 waited") == 0);
+  CHECK(out.text.find("holder") != std::string::npos);
+
+  TinyGsmScheduler::resetContenders();
+  CHECK(TinyGsmScheduler::topContenders(top, 4) == 0);
+}
+
+static void testModem() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  fm.answer("AT+CSQ", "\r\n+CSQ: 20,99\r\n\r\nOK\r\n");
+
+  TinyGsmScheduler::resetContenders();
+  modem.getSignalQuality();
+  modem.getSignalQuality();
+  TinyGsmLockStats top[16];
+  size_t           n     = TinyGsmScheduler::topContenders(top, 16);
+  bool             found = false;
+  for (size_t i = 0; i < n; i++) {
+    if (strstr(top[i].func, "getSignalQuality") && top[i].acquisitions == 2) { found = true; }
+  }
+  CHECK(found);
+}
+
+int main() {
+  testSites();
+  testModem();
+  return tinyGsmTestResult("test_lock_profile");
+}
@@ -0,0 +1,89 @@
+/**
+ * @file       test_matcher.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * TinyGsmMatcher against a chain of endsWith() checks.
+ */
+
+#include "TinyGsmHostTest.h"
+#include "TinyGsmMatcher.h"
+#include <random>
+#include <string>
+#include <vector>
+
+static bool endsWith(const std::string& s, const std::string& p) {
+  return s.size() >= p.size() && s.compare(s.size() - p.size(), p.size(), p) == 0;
+}
+
+static void testMatcherRandom() {
+  std::mt19937 rng(1);
+  const char*  alpha = "OKERC+:\r\nA";
+  for (int t = 0; t < 2000; t++) {
+    std::vector<std::string> patterns;
+    int                      np = 1 + rng() % 7;
+    for (int i = 0; i < np; i++) {
+      std::string p;
+      int         len = 1 + rng() % 6;
+      for (int j = 0; j < len; j++) { p += alpha[rng() % 10]; }
+      patterns.push_back(p);
+    }
+    TinyGsmMatcher<96, 40> m;
+    for (int i = 0; i < np; i++) { m.add(patterns[i].c_str(), i + 1); }
+    m.build();
+    CHECK(m.valid());
+
+    std::string data;
+    for (int k = 0; k < 200; k++) {
+      char c = alpha[rng() % 10];
+      data += c;
+      // The first pattern the data ends with, like a chain of endsWith()
+      int expected = 0;
+      for (int i = 0; i < np && expected == 0; i++) {
+        if (endsWith(data, patterns[i])) { expected = i + 1; }
+      }
+      int got = m.feed(c);
+      if (got != expected) {
+        CHECK(got == expected);
+        return;
+      }
+    }
+  }
+}
+
+static void testMatcherResponses() {
+  TinyGsmMatcher<64, 24> m;
+  m.add("OK\r\n", 1);
+  m.add("ERROR\r\n", 2);
+  m.add("+CME ERROR:", 3);
+  m.build();
+
+  const char* in  = "\r\n+CME ERROR: 30\r\n";
+  int         got = 0;
+  for (const char* p = in; *p; p++) {
+    int r = m.feed(*p);
+    if (r) { got = r; }
+  }
+  // "+CME ERROR:" was seen first, then "ERROR" is not followed by "\r\n"
+  CHECK(got == 3);
+
+  m.reset();
+  got = 0;
+  for (const char* p = "\r\nOK\r\n"; *p; p++) { got = m.feed(*p); }
+  CHECK(got == 1);
+
+  // Nothing is added after the capacity is exceeded
+  TinyGsmMatcher<4, 8> small;
+  CHECK(!small.add("TOO LONG", 1));
+  CHECK(!small.valid());
+  small.clear();
+  CHECK(small.valid());
+}
+
+int main() {
+  testMatcherRandom();
+  testMatcherResponses();
+  return tinyGsmTestResult("test_matcher");
+}
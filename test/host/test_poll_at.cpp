@@ -0,0 +1,177 @@
+/**
+ * @file       test_poll_at.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * submitAT() / pollAT() against a fake modem: results, callbacks, blocking
+ * calls and maintain() while a command is in flight, polling from another
+ * thread.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <atomic>
+#include <thread>
+
+static std::atomic<int> doneCalls{0};
+
+static void countDone(TinyGsmATRequest&, void* arg) {
+  doneCalls++;
+  if (arg) { (*static_cast<std::atomic<int>*>(arg))++; }
+}
+
+static bool pollUntil(TinyGsmSim7080& modem, TinyGsmATRequest& req,
+                      uint32_t timeout_ms) {
+  uint32_t start = millis();
+  while (!req.done() && millis() - start < timeout_ms) {
+    modem.pollAT();
+    delay(1);
+  }
+  return req.done();
+}
+
+static void testResults() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  fm.sent();
+
+  TinyGsmATRequest ok, csq, err, none;
+  ok.command(GF("+OK")).onDone(countDone);
+  csq.command(GF("+CSQ")).onDone(countDone);
+  err.command(GF("+ERR")).onDone(countDone);
+  none.command(GF("+NONE")).timeout(200).onDone(countDone);
+  fm.answer("AT+CSQ", "\r\n+CSQ: 20,99\r\n\r\nOK\r\n");
+  fm.answer("AT+ERR", "\r\nERROR\r\n");
+  fm.answer("AT+NONE", "");
+
+  doneCalls = 0;
+  CHECK(modem.submitAT(ok) && modem.submitAT(csq));
+  CHECK(modem.submitAT(err) && modem.submitAT(none));
+  CHECK(ok.state() == TINY_GSM_AT_QUEUED);
+  // Each request is in flight only once
+  CHECK(!modem.submitAT(ok));
+  TinyGsmATRequest empty;
+  CHECK(!modem.submitAT(empty));
+
+  uint32_t start = millis();
+  CHECK(pollUntil(modem, none, 2000));
+  CHECK(millis() - start >= 200);
+  CHECK(!modem.pollAT());
+  CHECK(ok.result() == 1 && csq.result() == 1);
+  CHECK(err.result() == 2 && none.result() == 0);
+  CHECK(strstr(csq.response(), "+CSQ: 20,99") != nullptr);
+  CHECK(doneCalls == 4);
+  CHECK(fm.sent() == "AT+OK\r\nAT+CSQ\r\nAT+ERR\r\nAT+NONE\r\n");
+
+  // A request can be submitted again once done
+  CHECK(modem.submitAT(ok));
+  CHECK(modem.waitAT(ok) == 1 && doneCalls == 5);
+
+  // The deadline passes in the queue: done without being sent
+  TinyGsmATRequest late;
+  late.command(GF("+LATE")).timeout(0);
+  CHECK(modem.submitAT(late));
+  CHECK(modem.waitAT(late) == 0);
+  CHECK(fm.calls("AT+LATE") == 0);
+}
+
+static void testBlockingCall() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  fm.sent();
+
+  std::atomic<int> calls{0};
+  TinyGsmATRequest slow;
+  slow.command(GF("+SLOW")).timeout(2000).onDone(countDone, &calls);
+  fm.answer("AT+SLOW", "");
+  CHECK(modem.submitAT(slow));
+  CHECK(modem.pollAT());
+  CHECK(slow.state() == TINY_GSM_AT_RUNNING);
+
+  // A blocking call waits for the response in flight before its command
+  std::thread answer([&fm] {
+    delay(100);
+    fm.push("\r\nOK\r\n");
+  });
+  uint32_t start = millis();
+  modem.refreshSocketStates();
+  CHECK(millis() - start >= 90);
+  answer.join();
+  CHECK(slow.done() && slow.result() == 1);
+  CHECK(fm.sent() == "AT+SLOW\r\nAT+CASTATE?\r\n");
+  // The callback runs with the next poll
+  CHECK(calls == 0);
+  CHECK(modem.pollAT());
+  CHECK(calls == 1);
+}
+
+static void testMaintain() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+
+  TinyGsmATRequest slow;
+  slow.command(GF("+SLOW")).timeout(2000);
+  fm.answer("AT+SLOW", "");
+  CHECK(modem.submitAT(slow));
+  modem.pollAT();
+
+  // maintain() does not wait for the request in flight: it steps it, and
+  // its waitResponse handles the URC
+  fm.push("\r\n*PSNWID: \"262\",\"01\",\"Net\",0,\"Net\",0\r\n");
+  uint32_t start = millis();
+  CHECK(modem.maintain(100000));
+  modem.maintain();
+  CHECK(millis() - start < 100);
+  CHECK(slow.state() == TINY_GSM_AT_RUNNING);
+  TinyGsmEvent ev;
+  bool         got = false;
+  while (modem.pollEvent(ev)) {
+    if (ev.type == TINY_GSM_EVENT_NETWORK_NAME) { got = true; }
+  }
+  CHECK(got);
+
+  fm.push("\r\nOK\r\n");
+  modem.maintain();
+  CHECK(slow.result() == 1);
+}
+
+static void testOtherThread() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+
+  std::atomic<int> calls{0};
+  TinyGsmATRequest req[4];
+  for (int i = 0; i < 4; i++) {
+    req[i].command(GF("+R="), i).timeout(2000).onDone(countDone, &calls);
+    CHECK(modem.submitAT(req[i]));
+  }
+
+  // One thread polls, another calls blocking functions meanwhile
+  std::atomic<bool> stop{false};
+  std::thread       poller([&] {
+    while (!stop) {
+      if (!modem.pollAT()) { delay(1); }
+    }
+  });
+  for (int i = 0; i < 20; i++) { modem.refreshSocketStates(); }
+  uint32_t start = millis();
+  while (calls < 4 && millis() - start < 2000) { delay(1); }
+  stop = true;
+  poller.join();
+
+  CHECK(calls == 4);
+  for (int i = 0; i < 4; i++) { CHECK(req[i].result() == 1); }
+  CHECK(fm.calls("AT+CASTATE?") == 20);
+  CHECK(!modem.lockScheduler().blocked());
+}
+
+int main() {
+  testResults();
+  testBlockingCall();
+  testMaintain();
+  testOtherThread();
+  return tinyGsmTestResult("test_poll_at");
+}
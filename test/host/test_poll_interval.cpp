@@ -0,0 +1,85 @@
+/**
+ * @file       test_poll_interval.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The data check interval of each socket adapts to its traffic: it doubles
+ * with every check finding nothing, traffic makes it tight again.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+
+typedef TinyGsmSim7080::GsmClientSim7080 SimClient;
+
+// Ask for data until the next check ran; returns millis() of the call
+// which ran it.
+static uint32_t check(FakeModem& fm, SimClient& client) {
+  int      before = fm.calls("AT+CARECV?");
+  uint32_t start  = millis();
+  uint32_t asked  = start;
+  while (fm.calls("AT+CARECV?") == before && millis() - start < 2000) {
+    delay(1);
+    asked = millis();
+    client.available();
+  }
+  return asked;
+}
+
+static void testBackOff() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  SimClient      client(modem, 0);
+  fm.answer("AT+CAOPEN=0,0,\"TCP\",\"example.com\",80", "\r\nOK\r\n\r\n+CAOPEN: 0,0\r\n");
+  CHECK(client.connect("example.com", 80, 10) == 1);
+  fm.answer("AT+CARECV?", "\r\nOK\r\n");
+
+  CHECK(client.pollStats().interval == TINY_GSM_POLL_INTERVAL_MIN_MS);
+  client.setPollInterval(10, 80);
+  CHECK(client.pollStats().interval == 10);
+
+  // Nothing found: 20, 40, 80, 80; from the second on, each check waits
+  // for the interval
+  uint32_t expect[] = {20, 40, 80, 80};
+  uint32_t last     = 0;
+  for (size_t i = 0; i < 4; i++) {
+    uint32_t interval = client.pollStats().interval;
+    uint32_t asked    = check(fm, client);
+    CHECK(i == 0 || asked - last + 1 >= interval);
+    CHECK(client.pollStats().interval == expect[i]);
+    last = asked;
+  }
+  CHECK(client.pollStats().checks == 4 && client.pollStats().found == 0);
+
+  // Found data: tight again
+  fm.answer("AT+CARECV?", "\r\n+CARECV: 0,4\r\n\r\nOK\r\n");
+  check(fm, client);
+  CHECK(client.pollStats().interval == 10);
+  CHECK(client.pollStats().checks == 5 && client.pollStats().found == 1);
+
+  // Read it: traffic as well; let the interval grow, then send: an answer
+  // is likely to come soon
+  fm.answer("AT+CARECV=0,4", "\r\n+CARECV: 4,data\r\n\r\nOK\r\n");
+  fm.answer("AT+CARECV?", "\r\nOK\r\n");
+  uint8_t buf[4];
+  CHECK(client.read(buf, sizeof(buf)) == 4);
+  CHECK(client.pollStats().interval == 10);
+  check(fm, client);
+  check(fm, client);
+  CHECK(client.pollStats().interval == 40);
+  fm.answer("AT+CASEND=0,2", "\r\n>\r\nOK\r\n");
+  CHECK(client.write(reinterpret_cast<const uint8_t*>("hi"), 2) == 2);
+  CHECK(client.pollStats().interval == 10);
+
+  // The interval can grow from the smallest minimum
+  client.setPollInterval(0, 0);
+  CHECK(client.pollStats().interval == 1);
+}
+
+int main() {
+  testBackOff();
+  return tinyGsmTestResult("test_poll_interval");
+}
@@ -0,0 +1,94 @@
+/**
+ * @file       test_poll_sweep.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The size sweep of the whole modem: one +CARECV? serves the available() of
+ * all sockets, a data announcement makes it due at once.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <string>
+
+typedef TinyGsmSim7080::GsmClientSim7080 SimClient;
+
+static void open(FakeModem& fm, SimClient& client, uint8_t mux) {
+  std::string m = std::to_string(mux);
+  fm.answer("AT+CAOPEN=" + m + ",0,\"TCP\",\"example.com\",80",
+            "\r\nOK\r\n\r\n+CAOPEN: " + m + ",0\r\n");
+  CHECK(client.connect("example.com", 80, 10) == 1);
+}
+
+static void testShared() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  SimClient      a(modem, 0);
+  SimClient      b(modem, 1);
+  SimClient      c(modem, 2);
+  open(fm, a, 0);
+  open(fm, b, 1);
+  open(fm, c, 2);
+
+  // All sockets ask, one sweep answers them all
+  fm.answer("AT+CARECV?", "\r\n+CARECV: 1,7\r\n\r\nOK\r\n");
+  CHECK(a.available() == 0);
+  CHECK(b.available() == 7);
+  CHECK(c.available() == 0);
+  CHECK(a.available() == 0 && c.available() == 0);
+  CHECK(fm.calls("AT+CARECV?") == 1);
+
+  // Nobody waits for data: no sweep
+  fm.answer("AT+CARECV?", "\r\nOK\r\n");
+  modem.maintain();
+  CHECK(fm.calls("AT+CARECV?") == 1);
+
+  // An announcement makes it due before the interval passed
+  fm.push("\r\n+CADATAIND: 2\r\n");
+  modem.maintain();
+  fm.answer("AT+CARECV?", "\r\n+CARECV: 1,7\r\n\r\n+CARECV: 2,3\r\n\r\nOK\r\n");
+  modem.maintain();
+  CHECK(fm.calls("AT+CARECV?") == 2);
+  CHECK(c.available() == 3 && b.available() == 7 && a.available() == 0);
+  CHECK(fm.calls("AT+CARECV?") == 2);
+
+  // A failed sweep keeps the announcement
+  int calls = fm.calls("AT+CARECV?");
+  fm.push("\r\n+CADATAIND: 0\r\n");
+  modem.maintain();
+  fm.answer("AT+CARECV?", "\r\nERROR\r\n");
+  modem.maintain();
+  CHECK(fm.calls("AT+CARECV?") == calls + 1);
+  fm.answer("AT+CARECV?", "\r\n+CARECV: 0,5\r\n\r\nOK\r\n");
+  modem.maintain();
+  CHECK(fm.calls("AT+CARECV?") == calls + 2);
+  CHECK(a.available() == 5);
+}
+
+static void testInterval() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  SimClient      a(modem, 0);
+  open(fm, a, 0);
+
+  // Asking all the time sweeps now and then only
+  fm.answer("AT+CARECV?", "\r\nOK\r\n");
+  int      asked = 0;
+  uint32_t start = millis();
+  while (millis() - start < 300) {
+    a.available();
+    asked++;
+    delay(1);
+  }
+  CHECK(fm.calls("AT+CARECV?") >= 1 && fm.calls("AT+CARECV?") <= 5);
+  CHECK(asked > 50);
+}
+
+int main() {
+  testShared();
+  testInterval();
+  return tinyGsmTestResult("test_poll_sweep");
+}
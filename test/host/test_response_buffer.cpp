@@ -0,0 +1,62 @@
+/**
+ * @file       test_response_buffer.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * TinyGsmResponseBuffer and its overflow policies; the data of
+ * waitResponse(timeout_ms, data, ...) beyond the size of the buffer.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <string>
+
+static void testResponseBuffer() {
+  TinyGsmResponseBuffer<8, TINY_GSM_OVERFLOW_KEEP_HEAD> head;
+  for (const char* p = "0123456789"; *p; p++) { head.append(*p); }
+  CHECK(std::string(head.c_str()) == "01234567");
+  CHECK(head.dropped() == 2);
+  CHECK(head.endsWith("567") && !head.endsWith("789"));
+
+  TinyGsmResponseBuffer<8, TINY_GSM_OVERFLOW_KEEP_TAIL> tail;
+  bool all = true;
+  for (const char* p = "0123456789OK\r\n"; *p; p++) { all = tail.append(*p) && all; }
+  CHECK(!all);
+  CHECK(tail.endsWith("OK\r\n"));
+  CHECK(tail.length() <= 8);
+  CHECK(tail.dropped() + tail.length() == 14);
+
+  tail.truncate(2);
+  CHECK(tail.length() == 2 && strlen(tail.c_str()) == 2);
+  tail.truncate(5);
+  CHECK(tail.length() == 2);
+  tail.clear();
+  CHECK(tail.length() == 0 && tail.dropped() == 0 && tail.c_str()[0] == '\0');
+  CHECK(!tail.endsWith(nullptr));
+}
+
+static void testStringData() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+
+  // Longer than the response buffer, with a 0x00 byte skipped
+  std::string rev(TINY_GSM_RESPONSE_BUFFER_SIZE + 100, 'R');
+  rev[10] = '\0';
+  fm.answer("AT+CGMR", "\r\n" + rev + "\r\n\r\nOK\r\n");
+  std::string expected = rev.substr(0, 10) + rev.substr(11);
+  CHECK(std::string(modem.getModemRevision().c_str()) == expected);
+
+  // A URC handled within the response is not part of the data
+  fm.answer("AT+CGSN", "\r\n*PSNWID: \"262\",\"01\",\"Net\",0,\"Net\",0\r\n"
+                       "\r\n861234567890123\r\n\r\nOK\r\n");
+  CHECK(modem.getModemSerialNumber() == "861234567890123");
+}
+
+int main() {
+  testResponseBuffer();
+  testStringData();
+  return tinyGsmTestResult("test_response_buffer");
+}
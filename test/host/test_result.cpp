@@ -0,0 +1,75 @@
+/**
+ * @file       test_result.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * How commands end: +CME/+CMS ERROR end the wait at once and give their
+ * error code to the TinyGsmResult of the operation.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+
+static void testCodes() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  fm.answer("AT+CNACT=0,1", "\r\nOK\r\n\r\n+APP PDP: 0,ACTIVE\r\n");
+
+  TinyGsmResult ok = modem.gprsConnect("apn");
+  CHECK(ok && ok.code == TINY_GSM_RESULT_OK);
+
+  fm.answer("AT+CGATT=1", "\r\n+CME ERROR: 30\r\n");
+  uint32_t      start = millis();
+  TinyGsmResult cme   = modem.gprsConnect("apn");
+  CHECK(millis() - start < 1000);
+  CHECK(!cme && cme.code == TINY_GSM_RESULT_CME_ERROR && cme.error == 30);
+  CHECK(strcmp(cme.text(), "+CME ERROR") == 0);
+
+  fm.answer("AT+CGATT=1", "\r\n+CMS ERROR: 500\r\n");
+  TinyGsmResult cms = modem.gprsConnect("apn");
+  CHECK(!cms && cms.code == TINY_GSM_RESULT_CMS_ERROR && cms.error == 500);
+
+  // Text instead of the number (AT+CMEE=2)
+  fm.answer("AT+CGATT=1", "\r\n+CME ERROR: no network service\r\n");
+  TinyGsmResult verbose = modem.gprsConnect("apn");
+  CHECK(!verbose && verbose.code == TINY_GSM_RESULT_CME_ERROR && verbose.error == -1);
+
+  fm.answer("AT+CGATT=1", "\r\nERROR\r\n");
+  TinyGsmResult error = modem.gprsConnect("apn");
+  CHECK(!error && error.code == TINY_GSM_RESULT_ERROR);
+
+  // The next command is not affected
+  fm.answer("AT+CSQ", "\r\n+CSQ: 15,99\r\n\r\nOK\r\n");
+  CHECK(modem.getSignalQuality() == 15);
+}
+
+static void testConnect() {
+  FakeModem                        fm;
+  TinyGsmSim7080                   modem(fm);
+  TinyGsmSim7080::GsmClientSim7080 client(modem, 0);
+
+  // The modem refuses the connection: the <result> of +CAOPEN
+  fm.answer("AT+CAOPEN=0,0,\"TCP\",\"example.com\",80", "\r\nOK\r\n\r\n+CAOPEN: 0,23\r\n");
+  CHECK(client.connect("example.com", 80, 10) == 0);
+  CHECK(client.connectStatus().code == TINY_GSM_RESULT_ERROR);
+  CHECK(client.connectStatus().error == 23);
+
+  // The modem does not take the command
+  fm.answer("AT+CAOPEN=0,0,\"TCP\",\"example.com\",80", "\r\n+CME ERROR: 3\r\n");
+  CHECK(client.connect("example.com", 80, 10) == 0);
+  CHECK(client.connectStatus().code == TINY_GSM_RESULT_CME_ERROR);
+  CHECK(client.connectStatus().error == 3);
+
+  fm.answer("AT+CAOPEN=0,0,\"TCP\",\"example.com\",80", "\r\nOK\r\n\r\n+CAOPEN: 0,0\r\n");
+  CHECK(client.connect("example.com", 80, 10) == 1);
+  CHECK(client.connectStatus());
+}
+
+int main() {
+  testCodes();
+  testConnect();
+  return tinyGsmTestResult("test_result");
+}
@@ -0,0 +1,139 @@
+/**
+ * @file       test_rx_pump.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The rx pump: the pipe with a producer and a consumer thread, URCs handled
+ * by the pump task while another task talks to the modem.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#define TINY_GSM_RX_PUMP
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <atomic>
+#include <string>
+#include <thread>
+
+typedef TinyGsmRxPump<64> SmallPump;
+
+static bool pullStep(void* arg) {
+  return static_cast<SmallPump*>(arg)->pull() > 0;
+}
+
+static void testPipe() {
+  FakeModem fm;
+  SmallPump pump(fm);
+  CHECK(pump.start(pullStep, &pump, 1));
+
+  // Many times the size of the pipe, in pieces of all sizes
+  const size_t total = 20000;
+  std::thread  producer([&fm] {
+    size_t sent = 0;
+    size_t len  = 1;
+    while (sent < total) {
+      std::string s;
+      for (size_t i = 0; i < len && sent < total; i++, sent++) {
+        s += static_cast<char>('a' + sent % 23);
+      }
+      fm.push(s);
+      len = len % 97 + 1;
+      if (fm.available() > 256) { delay(1); }
+    }
+  });
+
+  // The consumer pulls itself as well if the pipe is empty
+  size_t   got   = 0;
+  bool     order = true;
+  uint32_t start = millis();
+  while (got < total && millis() - start < 20000) {
+    char   buf[40];
+    size_t n = 0;
+    if (got % 2) {
+      int c = pump.read();
+      if (c >= 0) {
+        buf[0] = static_cast<char>(c);
+        n      = 1;
+      }
+    } else if (pump.available()) {
+      n = pump.readBytes(buf, TinyGsmMin(sizeof(buf), static_cast<size_t>(pump.available())));
+    }
+    for (size_t i = 0; i < n; i++, got++) {
+      if (buf[i] != static_cast<char>('a' + got % 23)) { order = false; }
+    }
+  }
+  producer.join();
+  pump.stop();
+  CHECK(got == total);
+  CHECK(order);
+  CHECK(!pump.running());
+
+  // Stopped, the stream reads the UART directly
+  fm.push("xyz");
+  CHECK(pump.available() == 3);
+  CHECK(pump.read() == 'x');
+}
+
+static void testModem() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  fm.answer("AT+CSQ", "\r\n+CSQ: 20,99\r\n\r\nOK\r\n");
+
+  CHECK(modem.startRxPump());
+  CHECK(modem.rxPumpRunning());
+
+  // The pump handles a URC without anybody calling maintain()
+  fm.push("\r\n*PSNWID: \"262\",\"01\",\"Net\",0,\"Net\",0\r\n");
+  TinyGsmEvent ev;
+  bool         got   = false;
+  uint32_t     start = millis();
+  while (!got && millis() - start < 1000) {
+    if (modem.pollEvent(ev)) { got = ev.type == TINY_GSM_EVENT_NETWORK_NAME; }
+    delay(1);
+  }
+  CHECK(got);
+
+  // URCs arrive while another task queries the modem: the responses go to
+  // the caller, the URCs to the pump or the caller, none gets lost
+  const int         urcs = 50;
+  std::atomic<bool> stop{false};
+  std::atomic<int>  wrong{0};
+  std::thread       caller([&] {
+    while (!stop) {
+      if (modem.getSignalQuality() != 20) { wrong++; }
+    }
+  });
+  int events = 0;
+  for (int i = 0; i < urcs; i++) {
+    fm.push("\r\n*PSUTTZ: 24/10/18,12:00:00\",\"+08\",1\r\n");
+    delay(2);
+    while (modem.pollEvent(ev)) {
+      if (ev.type == TINY_GSM_EVENT_NETWORK_TIME) { events++; }
+    }
+  }
+  start = millis();
+  while (events < urcs && millis() - start < 2000) {
+    while (modem.pollEvent(ev)) {
+      if (ev.type == TINY_GSM_EVENT_NETWORK_TIME) { events++; }
+    }
+    delay(1);
+  }
+  stop = true;
+  caller.join();
+  CHECK(wrong == 0 && fm.calls("AT+CSQ") > 1);
+  CHECK(events == urcs);
+  CHECK(modem.eventsDropped() == 0);
+
+  modem.stopRxPump();
+  CHECK(!modem.rxPumpRunning());
+  CHECK(modem.getSignalQuality() == 20);
+  CHECK(!modem.lockScheduler().blocked());
+}
+
+int main() {
+  testPipe();
+  testModem();
+  return tinyGsmTestResult("test_rx_pump");
+}
@@ -0,0 +1,90 @@
+/**
+ * @file       test_rx_signal.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * Waiting for UART bytes on a signal: notifications are kept until waited
+ * for, a response wakes the waiting command at once, nobody spins on the
+ * stream meanwhile.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <atomic>
+#include <thread>
+
+// Counts how often the modem looks at the stream.
+class CountingModem : public FakeModem {
+ public:
+  int available() override {
+    looks++;
+    return FakeModem::available();
+  }
+  std::atomic<int> looks{0};
+};
+
+static void testSignal() {
+  TinyGsmRxSignal s;
+
+  // Nobody notifies: short sleeps only
+  uint32_t start = millis();
+  CHECK(!s.wait(1000));
+  CHECK(millis() - start < 50);
+  CHECK(!s.active());
+
+  // Waking does not tell that the UART is hooked up
+  s.wake();
+  CHECK(s.wait(1000) && !s.active());
+
+  // A notification before the wait is not lost
+  s.notify();
+  CHECK(s.active());
+  start = millis();
+  CHECK(s.wait(1000));
+  CHECK(millis() - start < 50);
+
+  // Hooked up: the wait ends with the notification, or with the safety net
+  std::thread notifier([&s] {
+    delay(30);
+    s.notify();
+  });
+  start = millis();
+  CHECK(s.wait(1000));
+  CHECK(millis() - start >= 20 && millis() - start < TINY_GSM_RX_WAIT_MAX_MS);
+  notifier.join();
+  start = millis();
+  CHECK(!s.wait(1000));
+  CHECK(millis() - start >= TINY_GSM_RX_WAIT_MAX_MS - 10);
+  CHECK(millis() - start < TINY_GSM_RX_WAIT_MAX_MS + 100);
+}
+
+static void testModem() {
+  CountingModem  fm;
+  TinyGsmSim7080 modem(fm);
+  modem.notifyRxData();  // the UART receive callback is hooked up
+
+  // The response comes late; the command sleeps until it is there
+  fm.answer("AT+CSQ", "");
+  std::thread uart([&] {
+    delay(300);
+    fm.push("\r\n+CSQ: 16,99\r\n\r\nOK\r\n");
+    modem.notifyRxData();
+  });
+  fm.looks = 0;
+
+  uint32_t start = millis();
+  CHECK(modem.getSignalQuality() == 16);
+  uint32_t took = millis() - start;
+  uart.join();
+  CHECK(took >= 300 && took < 400);
+  CHECK(fm.looks < 30);
+}
+
+int main() {
+  testSignal();
+  testModem();
+  return tinyGsmTestResult("test_rx_signal");
+}
@@ -0,0 +1,134 @@
+/**
+ * @file       test_scheduler.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * TinyGsmScheduler: who gets the modem next, with callers on std::threads.
+ */
+
+#include "TinyGsmHostTest.h"
+#include "TinyGsmCommon.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Callers {
+  TinyGsmScheduler sched;
+  std::mutex       m;
+  std::string      order;  /// Tags of the callers, in the order served
+
+  void user(TinyGsmSchedClass cls, uint8_t mux, char tag) {
+    if (!sched.acquire(cls, mux, UINT32_MAX)) { return; }
+    {
+      std::lock_guard<std::mutex> l(m);
+      order += tag;
+    }
+    delay(5);
+    sched.release();
+  }
+};
+
+static void testOrder() {
+  Callers c;
+  c.sched.acquire(TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX, UINT32_MAX);
+  std::vector<std::thread> t;
+  t.emplace_back(&Callers::user, &c, TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX, 'H');
+  delay(10);
+  t.emplace_back(&Callers::user, &c, TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX, 'C');
+  delay(10);
+  t.emplace_back(&Callers::user, &c, TINY_GSM_SCHED_DATA, 1, 'a');
+  delay(10);
+  t.emplace_back(&Callers::user, &c, TINY_GSM_SCHED_DATA, 1, 'b');
+  delay(10);
+  t.emplace_back(&Callers::user, &c, TINY_GSM_SCHED_DATA, 3, 'x');
+  delay(10);
+  CHECK(!c.sched.tryAcquire());
+  c.sched.release();
+  for (auto& th : t) { th.join(); }
+  // Socket I/O first, round-robin across the muxes, housekeeping last
+  CHECK(c.order == "axbCH");
+  CHECK(c.sched.granted(TINY_GSM_SCHED_DATA) == 3);
+}
+
+static void testHousekeepingHold() {
+  Callers  c;
+  uint32_t start = millis();
+  c.user(TINY_GSM_SCHED_DATA, 2, 'd');
+  c.user(TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX, 'h');
+  CHECK(millis() - start >= TINY_GSM_SCHED_DATA_HOLD_MS);
+  CHECK(c.order == "dh");
+
+  // A housekeeping waiter held back does not refuse a try ...
+  c.user(TINY_GSM_SCHED_DATA, 2, 'd');
+  std::thread hk(&Callers::user, &c, TINY_GSM_SCHED_HOUSEKEEPING, TINY_GSM_SCHED_NO_MUX, 'k');
+  delay(20);
+  bool got = c.sched.tryAcquire();
+  CHECK(got);
+  if (got) { c.sched.release(); }
+  hk.join();
+
+  // ... a waiter which would be admitted does
+  c.sched.acquire(TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX, UINT32_MAX);
+  std::thread ctl(&Callers::user, &c, TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX, 'c');
+  delay(20);
+  c.sched.release();
+  got = c.sched.tryAcquire();
+  CHECK(!got);
+  if (got) { c.sched.release(); }
+  ctl.join();
+}
+
+static void testWaitLimit() {
+  TinyGsmScheduler s;
+  s.acquire(TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX, UINT32_MAX);
+  bool     got   = true;
+  uint32_t start = millis();
+  std::thread th([&] { got = s.acquire(TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX, 50); });
+  th.join();
+  CHECK(!got);
+  CHECK(millis() - start >= 50 && millis() - start < 1000);
+  CHECK(!s.acquire(TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX, 0));
+  CHECK(s.blocked());
+  s.release();
+  CHECK(!s.blocked());
+}
+
+static void countAcquired(void* arg) {
+  ++*static_cast<int*>(arg);
+}
+
+static void testOnAcquired() {
+  TinyGsmScheduler s;
+  int              n = 0;
+  s.onAcquired(&countAcquired, &n);
+  CHECK(s.acquire(TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX, UINT32_MAX));
+  s.release();
+  CHECK(s.tryAcquire());
+  s.release();
+  CHECK(n == 2);
+  // Without settling, e.g. the short turns of pollAT()
+  CHECK(s.tryAcquire(nullptr, false));
+  s.release();
+  CHECK(n == 2);
+}
+
+static void testTwoModems() {
+  TinyGsmScheduler a;
+  TinyGsmScheduler b;
+  a.acquire(TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX, UINT32_MAX);
+  CHECK(b.tryAcquire());
+  CHECK(a.blocked() && b.blocked());
+  b.release();
+  a.release();
+}
+
+int main() {
+  testOrder();
+  testHousekeepingHold();
+  testWaitLimit();
+  testOnAcquired();
+  testTwoModems();
+  return tinyGsmTestResult("test_scheduler");
+}
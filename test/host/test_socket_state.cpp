@@ -0,0 +1,90 @@
+/**
+ * @file       test_socket_state.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The socket states are kept by the +CASTATE URCs: the size sweep does not
+ * ask for them, only after a URC may have been lost.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <string>
+
+typedef TinyGsmSim7080::GsmClientSim7080 SimClient;
+
+static void open(FakeModem& fm, SimClient& client, uint8_t mux) {
+  std::string m = std::to_string(mux);
+  fm.answer("AT+CAOPEN=" + m + ",0,\"TCP\",\"example.com\",80",
+            "\r\nOK\r\n\r\n+CAOPEN: " + m + ",0\r\n");
+  CHECK(client.connect("example.com", 80, 10) == 1);
+}
+
+static void testURC() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  SimClient      a(modem, 0);
+  SimClient      b(modem, 1);
+  open(fm, a, 0);
+  open(fm, b, 1);
+
+  // The sweep asks for the sizes only
+  fm.answer("AT+CARECV?", "\r\nOK\r\n");
+  CHECK(a.available() == 0);
+  CHECK(fm.calls("AT+CARECV?") == 1 && fm.calls("AT+CASTATE?") == 0);
+  CHECK(a.connected() && b.connected());
+
+  // The modem tells when a socket closes
+  fm.push("\r\n+CASTATE: 1,0\r\n");
+  modem.maintain();
+  CHECK(a.connected() && !b.connected());
+  CHECK(fm.calls("AT+CASTATE?") == 0);
+}
+
+static void testLoss() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  SimClient      a(modem, 0);
+  SimClient      b(modem, 1);
+  open(fm, a, 0);
+  open(fm, b, 1);
+  fm.answer("AT+CARECV?", "\r\nOK\r\n");
+  fm.answer("AT+CASTATE?", "\r\n+CASTATE: 1,1\r\n\r\nOK\r\n");
+
+  // The module restarted: the states are asked for with the next sweep,
+  // which is due at once
+  CHECK(a.available() == 0);
+  fm.push("\r\nSMS Ready\r\n");
+  modem.maintain();
+  CHECK(a.available() == 0);
+  CHECK(fm.calls("AT+CARECV?") == 2 && fm.calls("AT+CASTATE?") == 1);
+  CHECK(!a.connected() && b.connected());
+
+  // Once only
+  fm.push("\r\n+CADATAIND: 1\r\n");
+  modem.maintain();
+  modem.maintain();
+  CHECK(fm.calls("AT+CARECV?") == 3 && fm.calls("AT+CASTATE?") == 1);
+
+  // A send failing for the socket
+  fm.answer("AT+CASEND=1,5", "\r\nERROR\r\n");
+  CHECK(b.write(reinterpret_cast<const uint8_t*>("hello"), 5) == 0);
+  fm.answer("AT+CASTATE?", "\r\nOK\r\n");
+  b.available();
+  CHECK(fm.calls("AT+CASTATE?") == 2);
+  CHECK(!b.connected());
+
+  // Asked for explicitly
+  fm.answer("AT+CASTATE?", "\r\n+CASTATE: 0,1\r\n\r\nOK\r\n");
+  CHECK(modem.refreshSocketStates());
+  CHECK(a.connected() && fm.calls("AT+CASTATE?") == 3);
+}
+
+int main() {
+  testURC();
+  testLoss();
+  return tinyGsmTestResult("test_socket_state");
+}
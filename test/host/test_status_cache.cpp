@@ -0,0 +1,99 @@
+/**
+ * @file       test_status_cache.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * The status cache: the maximum age, callers joining the query in flight,
+ * the bounded wait for it; shared signal quality queries of the modem.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <atomic>
+#include <thread>
+
+static void testAge() {
+  TinyGsmStatusCache<int> cache;
+  int                     v = 0;
+  CHECK(cache.begin(v, 1000) == TINY_GSM_CACHE_QUERY);
+  cache.end(true, 7);
+  CHECK(cache.begin(v, 1000) == TINY_GSM_CACHE_FRESH && v == 7);
+
+  // Too old for this caller
+  CHECK(cache.begin(v, 0) == TINY_GSM_CACHE_QUERY);
+  cache.end(true, 8);
+  delay(30);
+  CHECK(cache.begin(v, 20) == TINY_GSM_CACHE_QUERY);
+
+  // A failed query is not kept
+  cache.end(false, 0);
+  CHECK(cache.begin(v, 1000) == TINY_GSM_CACHE_QUERY);
+  cache.end(true, 9);
+  cache.invalidate();
+  CHECK(cache.begin(v, 1000) == TINY_GSM_CACHE_QUERY);
+  cache.end(true, 9);
+}
+
+static void testJoin() {
+  TinyGsmStatusCache<int> cache;
+  int                     v = 0;
+  CHECK(cache.begin(v, 0) == TINY_GSM_CACHE_QUERY);
+
+  // Callers coming meanwhile get the result of the query in flight
+  std::atomic<int> joined{0};
+  std::thread      a([&] {
+    int w = 0;
+    if (cache.begin(w, 0, 2000) == TINY_GSM_CACHE_JOINED && w == 42) { joined++; }
+  });
+  std::thread      b([&] {
+    int w = 0;
+    if (cache.begin(w, 0, 2000) == TINY_GSM_CACHE_JOINED && w == 42) { joined++; }
+  });
+  delay(50);
+  cache.end(true, 42);
+  a.join();
+  b.join();
+  CHECK(joined == 2);
+
+  // The query in flight does not end in time
+  CHECK(cache.begin(v, 0) == TINY_GSM_CACHE_QUERY);
+  uint32_t start = millis();
+  CHECK(cache.begin(v, 0, 50) == TINY_GSM_CACHE_TIMEOUT);
+  CHECK(millis() - start >= 50 && millis() - start < 500);
+  cache.end(true, 1);
+}
+
+static void testModem() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  fm.answer("AT+CSQ", "\r\n+CSQ: 17,99\r\n\r\nOK\r\n");
+  CHECK(modem.getSignalQuality(1000) == 17);
+  CHECK(modem.getSignalQuality(1000) == 17);
+  CHECK(modem.getSignalQuality() == 17);
+  CHECK(fm.calls("AT+CSQ") == 2);
+
+  // Two callers, one query
+  fm.answer("AT+CSQ", "");
+  std::atomic<int> first{0};
+  std::atomic<int> second{0};
+  std::thread      a([&] { first = modem.getSignalQuality(); });
+  delay(50);
+  std::thread      b([&] { second = modem.getSignalQuality(); });
+  delay(50);
+  fm.push("\r\n+CSQ: 18,99\r\n\r\nOK\r\n");
+  a.join();
+  b.join();
+  CHECK(first == 18 && second == 18);
+  CHECK(fm.calls("AT+CSQ") == 3);
+  CHECK(!modem.lockScheduler().blocked());
+}
+
+int main() {
+  testAge();
+  testJoin();
+  testModem();
+  return tinyGsmTestResult("test_status_cache");
+}
@@ -0,0 +1,80 @@
+/**
+ * @file       test_two_modems.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * Every modem has its own lock: a busy modem does not hold up another one.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <atomic>
+#include <thread>
+
+static void testIndependent() {
+  FakeModem      fa;
+  FakeModem      fb;
+  TinyGsmSim7080 a(fa);
+  TinyGsmSim7080 b(fb);
+  fa.answer("AT+CSQ", "\r\n+CSQ: 11,99\r\n\r\nOK\r\n");
+  fb.answer("AT+CSQ", "\r\n+CSQ: 22,99\r\n\r\nOK\r\n");
+  CHECK(&a.lockScheduler() != &b.lockScheduler());
+
+  // Modem a is busy for 300 ms
+  CHECK(a.lockScheduler().acquire(TINY_GSM_SCHED_CONTROL, TINY_GSM_SCHED_NO_MUX, UINT32_MAX));
+  std::atomic<int>      csqA{0};
+  std::atomic<uint32_t> tookA{0};
+  std::thread           other([&] {
+    uint32_t start = millis();
+    csqA           = a.getSignalQuality();
+    tookA          = millis() - start;
+  });
+
+  // Modem b answers meanwhile
+  uint32_t start = millis();
+  CHECK(b.getSignalQuality() == 22);
+  CHECK(millis() - start < 100);
+  CHECK(a.lockScheduler().blocked() && !b.lockScheduler().blocked());
+
+  delay(300);
+  a.lockScheduler().release();
+  other.join();
+  CHECK(csqA == 11 && tookA >= 250);
+  CHECK(fa.calls("AT+CSQ") == 1 && fb.calls("AT+CSQ") == 1);
+}
+
+static void testBothBusy() {
+  FakeModem      fa;
+  FakeModem      fb;
+  TinyGsmSim7080 a(fa);
+  TinyGsmSim7080 b(fb);
+  fa.answer("AT+CSQ", "\r\n+CSQ: 11,99\r\n\r\nOK\r\n");
+  fb.answer("AT+CSQ", "\r\n+CSQ: 22,99\r\n\r\nOK\r\n");
+
+  // Each modem used from two tasks at once
+  std::atomic<int> wrong{0};
+  auto             use = [&wrong](TinyGsmSim7080& m, int expect) {
+    for (int i = 0; i < 50; i++) {
+      if (m.getSignalQuality() != expect) { wrong++; }
+    }
+  };
+  std::thread t1(use, std::ref(a), 11);
+  std::thread t2(use, std::ref(a), 11);
+  std::thread t3(use, std::ref(b), 22);
+  std::thread t4(use, std::ref(b), 22);
+  t1.join();
+  t2.join();
+  t3.join();
+  t4.join();
+  CHECK(wrong == 0);
+  CHECK(!a.lockScheduler().blocked() && !b.lockScheduler().blocked());
+}
+
+int main() {
+  testIndependent();
+  testBothBusy();
+  return tinyGsmTestResult("test_two_modems");
+}
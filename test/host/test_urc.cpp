@@ -0,0 +1,119 @@
+/**
+ * @file       test_urc.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Nov 2016
+ *
+ * URC dispatch: the URC table of the modem, handlers of the application,
+ * URCs inside a response, unknown URCs; the event queue running over.
+ */
+
+#define TINY_GSM_MODEM_SIM7080
+#include "TinyGsmHostTest.h"
+#include "TinyGsmClient.h"
+#include <string>
+
+static std::string netlight;
+static int         netlightCalls = 0;
+
+static bool onNetlight(const char* params, void* arg) {
+  netlight = params;
+  netlightCalls++;
+  *static_cast<int*>(arg) += 1;
+  return true;
+}
+
+static bool onNothing(const char*, void*) {
+  return true;
+}
+
+static void testTable() {
+  FakeModem                        fm;
+  TinyGsmSim7080                   modem(fm);
+  TinyGsmSim7080::GsmClientSim7080 client(modem, 0);
+  fm.answer("AT+CAOPEN=0,0,\"TCP\",\"example.com\",80", "\r\nOK\r\n\r\n+CAOPEN: 0,0\r\n");
+  CHECK(client.connect("example.com", 80, 10) == 1);
+  CHECK(client.connected());
+
+  fm.push("\r\n+CASTATE: 0,0\r\n\r\n*PSUTTZ: 24/10/18,12:00:00\",\"+08\",1\r\n"
+          "\r\nDST: 1\r\n");
+  modem.maintain();
+  TinyGsmEvent ev;
+  CHECK(modem.pollEvent(ev) && ev.type == TINY_GSM_EVENT_SOCKET_CLOSED && ev.mux == 0);
+  CHECK(modem.pollEvent(ev) && ev.type == TINY_GSM_EVENT_NETWORK_TIME);
+  CHECK(strstr(ev.text, "24/10/18,12:00:00") != nullptr);
+  CHECK(modem.pollEvent(ev) && ev.type == TINY_GSM_EVENT_DAYLIGHT_SAVING && ev.value == 1);
+  CHECK(!modem.pollEvent(ev));
+  CHECK(!client.connected());
+}
+
+static void testApplication() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  int            count = 0;
+  netlightCalls        = 0;
+  CHECK(modem.addURCHandler(GF("+CNETLIGHT:"), onNetlight, &count));
+
+  fm.push("\r\n+CNETLIGHT: 1\r\n");
+  modem.maintain();
+  CHECK(netlightCalls == 1 && count == 1);
+  CHECK(netlight == " 1");
+
+  // Inside the response of a command: handled, the response is not disturbed
+  fm.answer("AT+CSQ", "\r\n+CNETLIGHT: 0\r\n\r\n+CSQ: 19,99\r\n\r\nOK\r\n");
+  CHECK(modem.getSignalQuality() == 19);
+  CHECK(netlightCalls == 2 && netlight == " 0");
+
+  // The table is full
+  for (int i = 1; i < TINY_GSM_URC_HANDLERS; i++) {
+    CHECK(modem.addURCHandler(GF("+NOTHING:"), onNothing));
+  }
+  CHECK(!modem.addURCHandler(GF("+NOTHING:"), onNothing));
+}
+
+static void testUnknown() {
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+
+  // A URC-like line nobody handles is published, other lines are not
+  fm.push("\r\n+FOO: 1,2\r\n\r\nstray\r\n");
+  modem.maintain();
+  TinyGsmEvent ev;
+  CHECK(modem.pollEvent(ev) && ev.type == TINY_GSM_EVENT_UNKNOWN_URC);
+  CHECK(strcmp(ev.text, "+FOO: 1,2") == 0);
+  CHECK(!modem.pollEvent(ev));
+}
+
+static void testOverflow() {
+  TinyGsmEventQueue<4> q;
+  TinyGsmEvent         ev;
+  for (int i = 0; i < 6; i++) {
+    ev.value = static_cast<int16_t>(i);
+    CHECK(q.push(ev) == (i < 4));
+  }
+  CHECK(q.dropped() == 2);
+  for (int i = 0; i < 4; i++) { CHECK(q.pop(ev) && ev.value == i); }
+  CHECK(!q.pop(ev) && q.empty());
+  CHECK(q.push(ev) && q.dropped() == 2);
+
+  // Nobody polls the events of the modem
+  FakeModem      fm;
+  TinyGsmSim7080 modem(fm);
+  for (int i = 0; i < TINY_GSM_EVENT_QUEUE_SIZE + 3; i++) {
+    fm.push("\r\nDST: 0\r\n");
+  }
+  modem.maintain();
+  CHECK(modem.eventsDropped() == 3);
+  int n = 0;
+  while (modem.pollEvent(ev)) { n++; }
+  CHECK(n == TINY_GSM_EVENT_QUEUE_SIZE);
+}
+
+int main() {
+  testTable();
+  testApplication();
+  testUnknown();
+  testOverflow();
+  return tinyGsmTestResult("test_urc");
+}